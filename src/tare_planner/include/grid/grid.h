@@ -85,6 +85,12 @@ public:
     return resolution_inv_;
   }
 
+  // Bytes of the cell array, not including what the cells point to
+  uint64_t GetMemoryBytes() const
+  {
+    return cells_.capacity() * sizeof(_T) + subs_.capacity() * sizeof(Eigen::Vector3i);
+  }
+
   bool InRange(int x, int y, int z) const
   {
     return InRange(Eigen::Vector3i(x, y, z));
@@ -0,0 +1,283 @@
+/**
+ * @file packed_grid.h
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Class that implements a 3D grid of 2-bit cells packed into 64-bit words
+ * @version 0.1
+ * @date 2021-06-19
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <Eigen/Core>
+#include <utils/misc_utils.h>
+
+namespace grid_ns
+{
+/**
+ * @brief Same geometry interface as Grid, for cell types with at most four values (0 to 3), stored 32 cells per word.
+ * Sub is computed from ind instead of being looked up, so there is no per-cell memory besides the 2 bits.
+ * Whole-word operations compare all 32 cells of a word against a value at once, for counting cells and for masks of
+ * the cells to visit. Words are atomics accessed with relaxed ordering, plain loads and stores on x86, so that
+ * SetCellValueAtomic() can be used from several threads writing different cells of the same word.
+ */
+template <typename _T>
+class PackedGrid
+{
+public:
+  typedef uint64_t WordType;
+  static const int kCellsPerWord = 32;
+
+  explicit PackedGrid(const Eigen::Vector3i& size, _T init_value,
+                      const Eigen::Vector3d& origin = Eigen::Vector3d(0, 0, 0),
+                      const Eigen::Vector3d& resolution = Eigen::Vector3d(1, 1, 1), int dimension = 3)
+  {
+    origin_ = origin;
+    size_ = size;
+    dimension_ = dimension;
+    SetResolution(resolution);
+    cell_number_ = size_.x() * size_.y() * size_.z();
+    word_number_ = (cell_number_ + kCellsPerWord - 1) / kCellsPerWord;
+    words_.reset(new std::atomic<WordType>[word_number_]);
+    Fill(init_value);
+  }
+
+  ~PackedGrid() = default;
+
+  int GetCellNumber() const
+  {
+    return cell_number_;
+  }
+
+  int GetWordNumber() const
+  {
+    return word_number_;
+  }
+
+  Eigen::Vector3i GetSize() const
+  {
+    return size_;
+  }
+
+  Eigen::Vector3d GetOrigin() const
+  {
+    return origin_;
+  }
+
+  void SetOrigin(const Eigen::Vector3d& origin)
+  {
+    origin_ = origin;
+  }
+
+  void SetResolution(const Eigen::Vector3d& resolution)
+  {
+    resolution_ = resolution;
+    for (int i = 0; i < dimension_; i++)
+    {
+      resolution_inv_(i) = 1.0 / resolution(i);
+    }
+  }
+
+  Eigen::Vector3d GetResolution() const
+  {
+    return resolution_;
+  }
+
+  uint64_t GetMemoryBytes() const
+  {
+    return word_number_ * sizeof(WordType);
+  }
+
+  bool InRange(const Eigen::Vector3i& sub) const
+  {
+    bool in_range = true;
+    for (int i = 0; i < dimension_; i++)
+    {
+      in_range &= sub(i) >= 0 && sub(i) < size_(i);
+    }
+    return in_range;
+  }
+
+  bool InRange(int ind) const
+  {
+    return ind >= 0 && ind < cell_number_;
+  }
+
+  Eigen::Vector3i Ind2Sub(int ind) const
+  {
+    Eigen::Vector3i sub;
+    int layer_size = size_.x() * size_.y();
+    sub.z() = ind / layer_size;
+    ind -= sub.z() * layer_size;
+    sub.y() = ind / size_.x();
+    sub.x() = ind % size_.x();
+    return sub;
+  }
+
+  int Sub2Ind(int x, int y, int z) const
+  {
+    return x + (y * size_.x()) + (z * size_.x() * size_.y());
+  }
+
+  int Sub2Ind(const Eigen::Vector3i& sub) const
+  {
+    return Sub2Ind(sub.x(), sub.y(), sub.z());
+  }
+
+  Eigen::Vector3d Sub2Pos(const Eigen::Vector3i& sub) const
+  {
+    Eigen::Vector3d pos(0, 0, 0);
+    for (int i = 0; i < dimension_; i++)
+    {
+      pos(i) = origin_(i) + sub(i) * resolution_(i) + resolution_(i) / 2;
+    }
+    return pos;
+  }
+
+  Eigen::Vector3d Ind2Pos(int ind) const
+  {
+    return Sub2Pos(Ind2Sub(ind));
+  }
+
+  Eigen::Vector3i Pos2Sub(const Eigen::Vector3d& pos) const
+  {
+    Eigen::Vector3i sub(0, 0, 0);
+    for (int i = 0; i < dimension_; i++)
+    {
+      sub(i) = pos(i) - origin_(i) > 0 ? static_cast<int>((pos(i) - origin_(i)) * resolution_inv_(i)) : -1;
+    }
+    return sub;
+  }
+
+  _T GetCellValue(int index) const
+  {
+    WordType word = words_[index / kCellsPerWord].load(std::memory_order_relaxed);
+    return static_cast<_T>((word >> Shift(index)) & kCellMask);
+  }
+
+  // Not safe against concurrent writes to other cells of the same word, see SetCellValueAtomic()
+  void SetCellValue(int index, _T value)
+  {
+    std::atomic<WordType>& word = words_[index / kCellsPerWord];
+    WordType cleared = word.load(std::memory_order_relaxed) & ~(kCellMask << Shift(index));
+    word.store(cleared | (static_cast<WordType>(value) << Shift(index)), std::memory_order_relaxed);
+  }
+
+  void SetCellValueAtomic(int index, _T value)
+  {
+    std::atomic<WordType>& word = words_[index / kCellsPerWord];
+    WordType expected = word.load(std::memory_order_relaxed);
+    WordType desired;
+    do
+    {
+      desired = (expected & ~(kCellMask << Shift(index))) | (static_cast<WordType>(value) << Shift(index));
+    } while (!word.compare_exchange_weak(expected, desired, std::memory_order_relaxed));
+  }
+
+  // Sets the cells [begin_index, end_index), whole words at a time in the middle of the range
+  void SetCellValueRange(int begin_index, int end_index, _T value)
+  {
+    while (begin_index < end_index && begin_index % kCellsPerWord != 0)
+    {
+      SetCellValue(begin_index++, value);
+    }
+    WordType pattern = Pattern(value);
+    for (; begin_index + kCellsPerWord <= end_index; begin_index += kCellsPerWord)
+    {
+      words_[begin_index / kCellsPerWord].store(pattern, std::memory_order_relaxed);
+    }
+    while (begin_index < end_index)
+    {
+      SetCellValue(begin_index++, value);
+    }
+  }
+
+  void Fill(_T value)
+  {
+    WordType pattern = Pattern(value);
+    for (int i = 0; i < word_number_; i++)
+    {
+      words_[i].store(pattern, std::memory_order_relaxed);
+    }
+  }
+
+  // Bit i is set if cell word_ind * kCellsPerWord + i has the value
+  uint32_t GetValueMask(int word_ind, _T value) const
+  {
+    WordType diff = words_[word_ind].load(std::memory_order_relaxed) ^ Pattern(value);
+    WordType match = ~(diff | (diff >> 1)) & kLowBits;
+    uint32_t mask = CompressLowBits(match);
+    int valid_cell_num = cell_number_ - word_ind * kCellsPerWord;
+    if (valid_cell_num < kCellsPerWord)
+    {
+      mask &= (uint32_t(1) << valid_cell_num) - 1;
+    }
+    return mask;
+  }
+
+  WordType GetWord(int word_ind) const
+  {
+    return words_[word_ind].load(std::memory_order_relaxed);
+  }
+
+  void SetWord(int word_ind, WordType word)
+  {
+    words_[word_ind].store(word, std::memory_order_relaxed);
+  }
+
+  // Bit i is set if cell i of the two words differs
+  static uint32_t GetDiffMask(WordType word, WordType other_word)
+  {
+    WordType diff = word ^ other_word;
+    return CompressLowBits(diff | (diff >> 1));
+  }
+
+  int Count(_T value) const
+  {
+    int count = 0;
+    for (int i = 0; i < word_number_; i++)
+    {
+      count += __builtin_popcount(GetValueMask(i, value));
+    }
+    return count;
+  }
+
+private:
+  static const WordType kCellMask = 0x3;
+  static const WordType kLowBits = 0x5555555555555555ULL;
+
+  Eigen::Vector3d origin_;
+  Eigen::Vector3i size_;
+  Eigen::Vector3d resolution_;
+  Eigen::Vector3d resolution_inv_;
+  int cell_number_;
+  int word_number_;
+  int dimension_;
+  std::unique_ptr<std::atomic<WordType>[]> words_;
+
+  static int Shift(int index)
+  {
+    return (index % kCellsPerWord) * 2;
+  }
+  // The value replicated in all 32 cells of a word
+  static WordType Pattern(_T value)
+  {
+    return kLowBits * (static_cast<WordType>(value) & kCellMask);
+  }
+  // Gathers bits 0, 2, 4, ... 62 into bits 0 to 31
+  static uint32_t CompressLowBits(WordType bits)
+  {
+    bits &= kLowBits;
+    bits = (bits | (bits >> 1)) & 0x3333333333333333ULL;
+    bits = (bits | (bits >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+    bits = (bits | (bits >> 4)) & 0x00FF00FF00FF00FFULL;
+    bits = (bits | (bits >> 8)) & 0x0000FFFF0000FFFFULL;
+    bits = (bits | (bits >> 16)) & 0x00000000FFFFFFFFULL;
+    return static_cast<uint32_t>(bits);
+  }
+};
+}  // namespace grid_ns
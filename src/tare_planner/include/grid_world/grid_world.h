@@ -27,6 +27,8 @@
 #include <tsp_solver/tsp_solver.h>
 #include <keypose_graph/keypose_graph.h>
 #include <exploration_path/exploration_path.h>
+#include <utils/memory_report.h>
+#include <utils/profiler.h>
 
 namespace viewpoint_manager_ns
 {
@@ -175,6 +177,13 @@ public:
   {
     roadmap_connection_point_set_ = set;
   }
+  // Bytes held outside of the cell itself
+  uint64_t GetMemoryBytes() const
+  {
+    return misc_utils_ns::GetVectorBytes(viewpoint_indices_) + misc_utils_ns::GetVectorBytes(connected_cell_indices_) +
+           misc_utils_ns::GetVectorBytes(keypose_graph_node_indices_) +
+           misc_utils_ns::GetVectorBytes(path_to_keypose_graph_.poses);
+  }
 
 private:
   CellStatus status_;
@@ -357,6 +366,7 @@ public:
   bool PathValid(const nav_msgs::Path& path, int from_cell_ind, int to_cell_ind);
   bool HasDirectKeyposeGraphConnection(const std::unique_ptr<keypose_graph_ns::KeyposeGraph>& keypose_graph,
                                        const Eigen::Vector3d& start_position, const Eigen::Vector3d& goal_position);
+  void GetMemoryUsage(misc_utils_ns::MemoryReport& report) const;
 
 private:
   int kRowNum;
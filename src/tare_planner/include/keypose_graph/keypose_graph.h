@@ -22,7 +22,9 @@
 #include <pcl/point_types.h>
 
 #include <planning_env/planning_env.h>
+#include <utils/memory_report.h>
 #include <utils/misc_utils.h>
+#include <utils/profiler.h>
 
 namespace viewpoint_manager_ns
 {
@@ -123,6 +125,7 @@ public:
   int GetConnectedNodeNum();
   void GetMarker(visualization_msgs::Marker& node_marker, visualization_msgs::Marker& edge_marker);
   void GetVisualizationCloud(pcl::PointCloud<pcl::PointXYZI>::Ptr cloud);
+  void GetMemoryUsage(misc_utils_ns::MemoryReport& report) const;
   std::vector<int> GetConnectedGraphNodeIndices()
   {
     return connected_node_indices_;
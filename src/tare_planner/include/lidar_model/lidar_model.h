@@ -1,7 +1,7 @@
 /**
  * @file lidar_model.h
  * @author Chao Cao (ccao1@andrew.cmu.edu)
- * @brief Class that implements the sensor model of a LiDAR
+ * @brief Class template that implements the sensor model of a LiDAR, with instantiations for common sensors
  * @version 0.1
  * @date 2019-09-26
  *
@@ -10,6 +10,8 @@
  */
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <cmath>
@@ -24,14 +26,72 @@
 
 namespace lidar_model_ns
 {
-class LiDARModel
+// Members shared by all sensor models
+class LiDARModelBase
 {
 public:
   static double pointcloud_resolution_;
-  explicit LiDARModel(double px = 0.0, double py = 0.0, double pz = 0.0, double rw = 1.0, double rx = 0.0,
-                      double ry = 0.0, double rz = 0.0);
-  explicit LiDARModel(const geometry_msgs::Pose& pose);
-  ~LiDARModel() = default;
+  static void setCloudDWZResol(double cloud_dwz_resol)
+  {
+    pointcloud_resolution_ = cloud_dwz_resol * kCloudInflateRatio;
+  }
+
+protected:
+  /**
+   * @brief whether a number is close to zero
+   *
+   * @param x input number
+   * @return true
+   * @return false
+   */
+  static bool isZero(double x)
+  {
+    return std::abs(x) < kEpsilon;
+  }
+
+  // Constant converting radian to degree
+  static const double kToDegreeConst;
+  // Constant converting degree to radian
+  static const double kToRadianConst;
+  // Threshold for checking if a number is close to zero
+  static const double kEpsilon;
+  // Ratio for inflating the cloud
+  static const double kCloudInflateRatio;
+  // Resolution of the quantized distances stored in the coverage arrays, in meters
+  static const double kDistanceResolution;
+};
+
+/**
+ * @brief Coverage model of a LiDAR with a fixed scan pattern, the coverage arrays are sized at compile time.
+ * Angles are in degrees. The vertical field-of-view is centered at VerticalFOVCenter degrees above the horizontal
+ * plane, and the horizontal field-of-view is centered at the x axis.
+ */
+template <int HorizontalFOV, int VerticalFOV, int HorizontalResolution, int VerticalResolution, int MaxRange,
+          int VerticalFOVCenter = 0>
+class SensorModel : public LiDARModelBase
+{
+public:
+  explicit SensorModel(double px = 0.0, double py = 0.0, double pz = 0.0, double rw = 1.0, double rx = 0.0,
+                       double ry = 0.0, double rz = 0.0)
+    : epoch_(0)
+  {
+    pose_.position.x = px;
+    pose_.position.y = py;
+    pose_.position.z = pz;
+    pose_.orientation.w = rw;
+    pose_.orientation.x = rx;
+    pose_.orientation.y = ry;
+    pose_.orientation.z = rz;
+    covered_voxel_.fill(0);
+    voxel_epoch_.fill(0);
+    ResetCoverage();
+  }
+  explicit SensorModel(const geometry_msgs::Pose& pose)
+    : SensorModel(pose.position.x, pose.position.y, pose.position.z, pose.orientation.w, pose.orientation.x,
+                  pose.orientation.y, pose.orientation.z)
+  {
+  }
+  ~SensorModel() = default;
 
   /**
    * @brief
@@ -44,7 +104,7 @@ public:
   {
     double distance_to_point = misc_utils_ns::PointXYZDist<PointType, geometry_msgs::Point>(point, pose_.position);
 
-    if (isZero(distance_to_point))
+    if (isZero(distance_to_point) || distance_to_point > kMaxRange)
       return;
 
     double dx = point.x - pose_.position.x;
@@ -68,11 +128,10 @@ public:
         if (!RowIndexInRange(row_index))
           continue;
         int ind = sub2ind(row_index, column_index);
-        double previous_distance_to_point = covered_voxel_[ind];
-        if (isZero(previous_distance_to_point) || distance_to_point < previous_distance_to_point || reset_[ind])
+        if (!VoxelCovered(ind) || distance_to_point < GetVoxelDistance(ind))
         {
-          covered_voxel_[ind] = distance_to_point;
-          reset_[ind] = false;
+          covered_voxel_[ind] = QuantizeDistance(distance_to_point);
+          voxel_epoch_[ind] = epoch_;
         }
       }
     }
@@ -92,7 +151,7 @@ public:
   {
     double distance_to_point = misc_utils_ns::PointXYZDist<PointType, geometry_msgs::Point>(point, pose_.position);
 
-    if (isZero(distance_to_point))
+    if (isZero(distance_to_point) || distance_to_point > kMaxRange)
       return false;
 
     double dx = point.x - pose_.position.x;
@@ -116,10 +175,7 @@ public:
         if (!RowIndexInRange(row_index))
           continue;
         int ind = sub2ind(row_index, column_index);
-        float previous_distance_to_point = covered_voxel_[ind];
-        if ((!isZero(previous_distance_to_point) &&
-             distance_to_point < previous_distance_to_point + occlusion_threshold && !reset_[ind]) ||
-            reset_[ind])
+        if (!VoxelCovered(ind) || distance_to_point < GetVoxelDistance(ind) + occlusion_threshold)
         {
           return true;
         }
@@ -128,10 +184,18 @@ public:
     return false;
   }
   /**
-   * @brief
-   * TODO
+   * @brief Mark all voxels uncovered by advancing the epoch, the voxel arrays are only cleared when it wraps around
    */
-  void ResetCoverage();
+  void ResetCoverage()
+  {
+    epoch_++;
+    if (epoch_ == 0)
+    {
+      // Wrapped around, stamps from 65535 resets ago would look current again
+      voxel_epoch_.fill(0);
+      epoch_ = 1;
+    }
+  }
   /**
    * @brief Get the Visualization Cloud object
    * TODO
@@ -140,11 +204,48 @@ public:
    * @param max_range
    */
   void GetVisualizationCloud(pcl::PointCloud<pcl::PointXYZI>::Ptr& visualization_cloud, double resol = 0.2,
-                             double max_range = 25.0) const;
-
-  static void setCloudDWZResol(double cloud_dwz_resol)
+                             double max_range = 25.0) const
   {
-    pointcloud_resolution_ = cloud_dwz_resol * kCloudInflateRatio;
+    visualization_cloud->clear();
+    geometry_msgs::Point start_point = pose_.position;
+    for (int i = 0; i < covered_voxel_.size(); i++)
+    {
+      int row_index, column_index;
+      ind2sub(i, row_index, column_index);
+      double phi = (column_index * kHorizontalResolution - kHorizontalFOV / 2) * M_PI / 180;
+      double theta = (row_index * kVerticalResolution - kVerticalAngleOffset) * M_PI / 180;
+
+      double r = GetVoxelDistance(i);
+      if (!VoxelCovered(i))
+      {
+        r = max_range;
+      }
+      geometry_msgs::Point end_point;
+      end_point.x = r * sin(theta) * cos(phi) + pose_.position.x;
+      end_point.y = r * sin(theta) * sin(phi) + pose_.position.y;
+      end_point.z = r * cos(theta) + pose_.position.z;
+      pcl::PointXYZI point;
+      point.x = end_point.x;
+      point.y = end_point.y;
+      point.z = end_point.z;
+      point.intensity = 0.0;
+
+      visualization_cloud->points.push_back(point);
+      pcl::PointCloud<pcl::PointXYZI>::Ptr tmp_cloud(new pcl::PointCloud<pcl::PointXYZI>());
+      misc_utils_ns::LinInterpPoints<pcl::PointXYZI>(start_point, end_point, resol, tmp_cloud);
+      for (auto& tmp_point : tmp_cloud->points)
+      {
+        if (!VoxelCovered(i))
+        {
+          tmp_point.intensity = 0.0;
+        }
+        else
+        {
+          tmp_point.intensity = 10.0;
+        }
+      }
+      *visualization_cloud += *tmp_cloud;
+    }
   }
 
   void setPose(const geometry_msgs::Pose& pose)
@@ -167,6 +268,35 @@ public:
   {
     pose_.position.z = height;
   }
+  // Scan pattern of the sensor model in degrees
+  static int GetHorizontalFOV()
+  {
+    return kHorizontalFOV;
+  }
+  static int GetVerticalFOV()
+  {
+    return kVerticalFOV;
+  }
+  static int GetHorizontalResolution()
+  {
+    return kHorizontalResolution;
+  }
+  static int GetVerticalResolution()
+  {
+    return kVerticalResolution;
+  }
+  static int GetMaxRange()
+  {
+    return kMaxRange;
+  }
+  static int GetVerticalFOVCenter()
+  {
+    return kVerticalFOVCenter;
+  }
+  static int GetVoxelNum()
+  {
+    return kHorizontalVoxelSize * kVerticalVoxelSize;
+  }
 
 private:
   /**
@@ -176,7 +306,10 @@ private:
    * @param column_index column index
    * @return int linear index
    */
-  int sub2ind(int row_index, int column_index) const;
+  int sub2ind(int row_index, int column_index) const
+  {
+    return row_index * kHorizontalVoxelSize + column_index;
+  }
   /**
    * @brief convert linear indices to subscripts
    *
@@ -184,17 +317,10 @@ private:
    * @param row_index row index
    * @param column_index column index
    */
-  void ind2sub(int ind, int& row_index, int& column_index) const;
-  /**
-   * @brief whether a number is close to zero
-   *
-   * @param x input number
-   * @return true
-   * @return false
-   */
-  bool isZero(double x) const
+  void ind2sub(int ind, int& row_index, int& column_index) const
   {
-    return std::abs(x) < kEpsilon;
+    row_index = ind / kHorizontalVoxelSize;
+    column_index = ind % kHorizontalVoxelSize;
   }
 
   /**
@@ -206,7 +332,8 @@ private:
    */
   inline int GetHorizontalAngle(double dx, double dy) const
   {
-    double horizontal_angle = (misc_utils_ns::ApproxAtan2(dy, dx) * kToDegreeConst + 180) / kHorizontalResolution;
+    double horizontal_angle =
+        (misc_utils_ns::ApproxAtan2(dy, dx) * kToDegreeConst + kHorizontalFOV / 2) / kHorizontalResolution;
     return static_cast<int>(round(horizontal_angle));
   }
   /**
@@ -252,34 +379,176 @@ private:
   {
     return column_index >= 0 && column_index < kHorizontalVoxelSize;
   }
+  // A voxel written before the last reset reads as uncovered, as does one with a zero distance
+  inline bool VoxelCovered(int ind) const
+  {
+    return voxel_epoch_[ind] == epoch_ && covered_voxel_[ind] != 0;
+  }
+  inline double GetVoxelDistance(int ind) const
+  {
+    return covered_voxel_[ind] * kDistanceResolution;
+  }
+  inline uint16_t QuantizeDistance(double distance) const
+  {
+    double quantized_distance = std::round(distance / kDistanceResolution);
+    return quantized_distance < UINT16_MAX ? static_cast<uint16_t>(quantized_distance) : UINT16_MAX;
+  }
 
-  // Constant converting radian to degree
-  static const double kToDegreeConst;
-  // Constant converting degree to radian
-  static const double kToRadianConst;
-  // Threshold for checking if a number is close to zero
-  static const double kEpsilon;
-  // Ratio for inflating the cloud
-  static const double kCloudInflateRatio;
   // Horizontal field-of-view in degrees
-  static const int kHorizontalFOV = 360;
+  static const int kHorizontalFOV = HorizontalFOV;
   // Vertical field-of-view in degrees
-  static const int kVerticalFOV = 24;
+  static const int kVerticalFOV = VerticalFOV;
   // Horizontal resolution
-  static const int kHorizontalResolution = 2;
+  static const int kHorizontalResolution = HorizontalResolution;
   // Vertical resolution
-  static const int kVerticalResolution = 2;
+  static const int kVerticalResolution = VerticalResolution;
+  // Points farther than this (in meters) are neither covered nor visible
+  static const int kMaxRange = MaxRange;
+  // Elevation of the center of the vertical field-of-view in degrees
+  static const int kVerticalFOVCenter = VerticalFOVCenter;
   // Horizontal dimension of the voxel grid
   static const int kHorizontalVoxelSize = kHorizontalFOV / kHorizontalResolution;
   // Vertical dimension of the voxel grid
   static const int kVerticalVoxelSize = kVerticalFOV / kVerticalResolution;
   // Vertical angle offset, eg, angle [75, 105] -> indices [0, 30]
-  static const int kVerticalAngleOffset = -(90 - kVerticalFOV / 2);
-  // The distance that a ray can reach from the direction determined by the horizontal angle and vertical angle
-  std::array<float, kHorizontalVoxelSize * kVerticalVoxelSize> covered_voxel_;
-  // Whether a voxel is reset
-  std::array<bool, kHorizontalVoxelSize * kVerticalVoxelSize> reset_;
+  static const int kVerticalAngleOffset = -(90 - VerticalFOVCenter - kVerticalFOV / 2);
+  // The distance that a ray can reach from the direction determined by the horizontal angle and vertical angle, in
+  // units of kDistanceResolution
+  std::array<uint16_t, kHorizontalVoxelSize * kVerticalVoxelSize> covered_voxel_;
+  // The epoch in which a voxel was last written, voxels from earlier epochs are treated as reset
+  std::array<uint16_t, kHorizontalVoxelSize * kVerticalVoxelSize> voxel_epoch_;
+  uint16_t epoch_;
   // Pose of the lidar model
   geometry_msgs::Pose pose_;
+
+  static_assert(HorizontalFOV % HorizontalResolution == 0 && VerticalFOV % VerticalResolution == 0,
+                "The field-of-view must be a multiple of the resolution");
+};
+
+// Velodyne VLP-16 class spinning LiDAR, the model the planner was tuned with
+typedef SensorModel<360, 24, 2, 2, 100> LiDARModel;
+// Livox Mid-360, vertical field-of-view -7 to 52 degrees
+typedef SensorModel<360, 60, 2, 2, 40, 22> Mid360LiDARModel;
+// Ouster OS1-128, vertical field-of-view +-22.5 degrees
+typedef SensorModel<360, 46, 2, 2, 120> OS1LiDARModel;
+
+enum class LiDARModelType
+{
+  VLP16 = 0,
+  MID360 = 1,
+  OS1_128 = 2
+};
+
+// Accepts "vlp16", "mid360" and "os1_128", returns false for other names
+bool GetLiDARModelType(const std::string& name, LiDARModelType& type);
+
+// Scan pattern of a sensor model in degrees, for code that selects the sensor at runtime
+struct LiDARScanPattern
+{
+  int horizontal_fov;
+  int vertical_fov;
+  int horizontal_resolution;
+  int vertical_resolution;
+  int max_range;
+  int vertical_fov_center;
+  // Elevation of the upper edge of the vertical field-of-view, positive above the horizontal plane
+  double GetUpperVerticalAngle() const
+  {
+    return vertical_fov_center + vertical_fov / 2.0;
+  }
+  // Elevation of the lower edge of the vertical field-of-view, positive above the horizontal plane
+  double GetLowerVerticalAngle() const
+  {
+    return vertical_fov_center - vertical_fov / 2.0;
+  }
+};
+
+template <class SensorModelType>
+LiDARScanPattern GetScanPattern()
+{
+  LiDARScanPattern scan_pattern;
+  scan_pattern.horizontal_fov = SensorModelType::GetHorizontalFOV();
+  scan_pattern.vertical_fov = SensorModelType::GetVerticalFOV();
+  scan_pattern.horizontal_resolution = SensorModelType::GetHorizontalResolution();
+  scan_pattern.vertical_resolution = SensorModelType::GetVerticalResolution();
+  scan_pattern.max_range = SensorModelType::GetMaxRange();
+  scan_pattern.vertical_fov_center = SensorModelType::GetVerticalFOVCenter();
+  return scan_pattern;
+}
+
+LiDARScanPattern GetScanPattern(LiDARModelType type);
+
+/**
+ * @brief Sensor models of a type selected at runtime.
+ * Only the vector of the selected type is allocated. Visit() dispatches once and passes that vector to the visitor, so
+ * that loops over the models run the fixed-size kernel of the sensor. The per-index helpers dispatch on every call.
+ */
+class LiDARModelArray
+{
+public:
+  explicit LiDARModelArray(LiDARModelType type = LiDARModelType::VLP16, int size = 0);
+  ~LiDARModelArray() = default;
+  void Resize(LiDARModelType type, int size);
+  LiDARModelType GetType() const
+  {
+    return type_;
+  }
+  int Size() const
+  {
+    return size_;
+  }
+  template <class Visitor>
+  decltype(auto) Visit(Visitor&& visitor)
+  {
+    switch (type_)
+    {
+      case LiDARModelType::MID360:
+        return visitor(mid360_models_);
+      case LiDARModelType::OS1_128:
+        return visitor(os1_models_);
+      case LiDARModelType::VLP16:
+      default:
+        return visitor(vlp16_models_);
+    }
+  }
+  template <class Visitor>
+  decltype(auto) Visit(Visitor&& visitor) const
+  {
+    switch (type_)
+    {
+      case LiDARModelType::MID360:
+        return visitor(mid360_models_);
+      case LiDARModelType::OS1_128:
+        return visitor(os1_models_);
+      case LiDARModelType::VLP16:
+      default:
+        return visitor(vlp16_models_);
+    }
+  }
+  template <class PointType>
+  void UpdateCoverage(int ind, const PointType& point)
+  {
+    Visit([&](auto& models) { models[ind].template UpdateCoverage<PointType>(point); });
+  }
+  template <class PointType>
+  bool CheckVisibility(int ind, const PointType& point, double occlusion_threshold) const
+  {
+    return Visit([&](const auto& models) {
+      return models[ind].template CheckVisibility<PointType>(point, occlusion_threshold);
+    });
+  }
+  geometry_msgs::Point GetPosition(int ind) const;
+  void SetPosition(int ind, const geometry_msgs::Point& position);
+  void SetHeight(int ind, double height);
+  void ResetCoverage(int ind);
+  void ResetCoverage();
+  uint64_t GetMemoryBytes() const;
+
+private:
+  LiDARModelType type_;
+  int size_;
+  std::vector<LiDARModel> vlp16_models_;
+  std::vector<Mid360LiDARModel> mid360_models_;
+  std::vector<OS1LiDARModel> os1_models_;
 };
 }  // namespace lidar_model_ns
\ No newline at end of file
@@ -18,6 +18,8 @@
 #include "grid_world/grid_world.h"
 #include "exploration_path/exploration_path.h"
 #include "viewpoint_manager/viewpoint_manager.h"
+#include "utils/memory_report.h"
+#include "utils/profiler.h"
 
 namespace local_coverage_planner_ns
 {
@@ -78,26 +80,29 @@ public:
 
   // Visualization
   void GetSelectedViewPointVisCloud(pcl::PointCloud<pcl::PointXYZI>::Ptr& cloud);
+  // The viewpoint manager is shared and reports separately
+  void GetMemoryUsage(misc_utils_ns::MemoryReport& report) const;
 
 private:
   int GetBoundaryViewpointIndex(const exploration_path_ns::ExplorationPath& global_path);
   void GetBoundaryViewpointIndices(exploration_path_ns::ExplorationPath global_path);
   void GetNavigationViewPointIndices(exploration_path_ns::ExplorationPath global_path,
                                      std::vector<int>& navigation_viewpoint_indices);
-  void UpdateViewPointCoveredPoint(std::vector<bool>& point_list, int viewpoint_index, bool use_array_ind = false);
-  void UpdateViewPointCoveredFrontierPoint(std::vector<bool>& frontier_point_list, int viewpoint_index,
-                                           bool use_array_ind = false);
+  void UpdateViewPointCoveredPoint(misc_utils_ns::DynamicBitset& covered_point_set, int viewpoint_index,
+                                   bool use_array_ind = false);
+  void UpdateViewPointCoveredFrontierPoint(misc_utils_ns::DynamicBitset& covered_frontier_point_set,
+                                           int viewpoint_index, bool use_array_ind = false);
 
   void EnqueueViewpointCandidates(std::vector<std::pair<int, int>>& cover_point_queue,
                                   std::vector<std::pair<int, int>>& frontier_queue,
-                                  const std::vector<bool>& covered_point_list,
-                                  const std::vector<bool>& covered_frontier_point_list,
+                                  const misc_utils_ns::DynamicBitset& covered_point_set,
+                                  const misc_utils_ns::DynamicBitset& covered_frontier_point_set,
                                   const std::vector<int>& selected_viewpoint_array_indices);
 
-  void SelectViewPoint(const std::vector<std::pair<int, int>>& queue, const std::vector<bool>& covered,
+  void SelectViewPoint(const std::vector<std::pair<int, int>>& queue, const misc_utils_ns::DynamicBitset& covered,
                        std::vector<int>& selected_viewpoint_indices, bool use_frontier = false);
   void SelectViewPointFromFrontierQueue(std::vector<std::pair<int, int>>& frontier_queue,
-                                        std::vector<bool>& frontier_covered,
+                                        misc_utils_ns::DynamicBitset& frontier_covered,
                                         std::vector<int>& selected_viewpoint_indices);
   exploration_path_ns::ExplorationPath SolveTSP(const std::vector<int>& selected_viewpoint_indices,
                                                 std::vector<int>& ordered_viewpoint_indices);
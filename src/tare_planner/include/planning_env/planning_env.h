@@ -10,6 +10,7 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <cmath>
 #include <vector>
 #include <memory>
@@ -27,6 +28,7 @@
 
 // Third parties
 #include <utils/pointcloud_utils.h>
+#include <utils/voxel_bucket_hash.h>
 // Components
 #include <pointcloud_manager/pointcloud_manager.h>
 #include <lidar_model/lidar_model.h>
@@ -64,12 +66,17 @@ struct planning_env_ns::PlanningEnvParameters
   double kPointCloudCellHeight;
   int kPointCloudManagerNeighborCellNum;
   double kCoverCloudZSqueezeRatio;
+  bool kUseVoxelHashCoverageDilation;
+  // Extract vertical surfaces with column hashing instead of kdtree radius searches, same output
+  bool kUseColumnVerticalSurfaceExtractor;
 
   // Occupancy Grid
   bool kUseFrontier;
   double kFrontierClusterTolerance;
   int kFrontierClusterMinSize;
   Eigen::Vector3d kExtractFrontierRange;
+  // Max publish rate (Hz) of the rolling occupancy grid cloud, 0 for the default visualization rate
+  double kRollingOccupancyGridCloudPublishRate;
 
   void ReadParameters(ros::NodeHandle& nh);
 };
@@ -136,8 +143,7 @@ public:
       {
         rolling_occupancy_grid_->UpdateOccupancy<PCLPointType>(cloud);
         rolling_occupancy_grid_->RayTrace(robot_position_);
-        rolling_occupancy_grid_->GetVisualizationCloud(rolling_occupancy_grid_cloud_->cloud_);
-        //rolling_occupancy_grid_cloud_->Publish();
+        PublishRollingOccupancyGridCloud();
       }
     }
   }
@@ -161,8 +167,16 @@ public:
       get_surface_timer.Start();
 
       vertical_surface_cloud_->cloud_->clear();
-      vertical_surface_extractor_.ExtractVerticalSurface<PlannerCloudPointType, PlannerCloudPointType>(
-          keypose_cloud_->cloud_, vertical_surface_cloud_->cloud_);
+      if (parameters_.kUseColumnVerticalSurfaceExtractor)
+      {
+        column_vertical_surface_extractor_.ExtractVerticalSurface<PlannerCloudPointType, PlannerCloudPointType>(
+            keypose_cloud_->cloud_, vertical_surface_cloud_->cloud_);
+      }
+      else
+      {
+        vertical_surface_extractor_.ExtractVerticalSurface<PlannerCloudPointType, PlannerCloudPointType>(
+            keypose_cloud_->cloud_, vertical_surface_cloud_->cloud_);
+      }
       vertical_surface_cloud_->Publish();  // "~/coverage_cloud"，"keypose_cloud"中垂直的表面
 
       // 历史的点云，R通道设置为255
@@ -185,50 +199,29 @@ public:
         point.g = 0;
         point.b = 0;
       }
-      for (auto& point : stacked_cloud_->cloud_->points)
+      for (const auto& stacked_point : stacked_cloud_->cloud_->points)
       {
+        PlannerCloudPointType point = stacked_point;
         point.r = 255;
+        stacked_cloud_downsizer_.Add(point);
       }
-      *(stacked_cloud_->cloud_) += *(keypose_cloud_->cloud_);
-      stacked_cloud_downsizer_.Downsize(stacked_cloud_->cloud_, parameters_.kStackedCloudDwzLeafSize,
-                                        parameters_.kStackedCloudDwzLeafSize, parameters_.kStackedCloudDwzLeafSize);
-      for (const auto& point : stacked_cloud_->cloud_->points)
-      {
-        if (point.r < 40)  // TODO: computed from the keypose cloud resolution and stacked cloud resolution
-        {
-          diff_cloud_->cloud_->points.push_back(point);
-        }
-      }
+      stacked_cloud_downsizer_.Add(*(keypose_cloud_->cloud_));
+      stacked_cloud_downsizer_.Flush(*(diff_cloud_->cloud_));
+      // TODO: computed from the keypose cloud resolution and stacked cloud resolution
+      auto& diff_points = diff_cloud_->cloud_->points;
+      diff_points.erase(std::remove_if(diff_points.begin(), diff_points.end(),
+                                       [](const PlannerCloudPointType& point) { return point.r >= 40; }),
+                        diff_points.end());
+      diff_cloud_->cloud_->width = diff_cloud_->cloud_->points.size();
       diff_cloud_->Publish();
       get_surface_timer.Stop(false);
 
-      // Stack together
-      keypose_cloud_stack_[keypose_cloud_count_]->clear();
-      *keypose_cloud_stack_[keypose_cloud_count_] = *keypose_cloud_->cloud_;
-      keypose_cloud_count_ = (keypose_cloud_count_ + 1) % parameters_.kKeyposeCloudStackNum;  // default(5)
-      stacked_cloud_->cloud_->clear();
-      // 多次keypose_cloud_堆叠为stacked_cloud_
-      for (int i = 0; i < parameters_.kKeyposeCloudStackNum; i++)
-      {
-        *(stacked_cloud_->cloud_) += *keypose_cloud_stack_[i];
-      }
-      stacked_cloud_downsizer_.Downsize(stacked_cloud_->cloud_, parameters_.kStackedCloudDwzLeafSize,
-                                        parameters_.kStackedCloudDwzLeafSize, parameters_.kStackedCloudDwzLeafSize);
-
-      vertical_surface_cloud_stack_[keypose_cloud_count_]->clear();
-      *vertical_surface_cloud_stack_[keypose_cloud_count_] = *(vertical_surface_cloud_->cloud_);
-      keypose_cloud_count_ = (keypose_cloud_count_ + 1) % parameters_.kKeyposeCloudStackNum;
-      stacked_vertical_surface_cloud_->cloud_->clear();
-      for (int i = 0; i < parameters_.kKeyposeCloudStackNum; i++)
-      {
-        *(stacked_vertical_surface_cloud_->cloud_) += *vertical_surface_cloud_stack_[i];
-      }
-
-      stacked_cloud_downsizer_.Downsize(stacked_vertical_surface_cloud_->cloud_, parameters_.kStackedCloudDwzLeafSize,
-                                        parameters_.kStackedCloudDwzLeafSize, parameters_.kStackedCloudDwzLeafSize);
+      // Stack together, 多次keypose_cloud_堆叠为stacked_cloud_
+      stacked_cloud_map_.AddCloud(*(keypose_cloud_->cloud_));
+      stacked_vertical_surface_cloud_map_.AddCloud(*(vertical_surface_cloud_->cloud_));
       stacked_vertical_surface_cloud_kdtree_->setInputCloud(stacked_vertical_surface_cloud_->cloud_);
 
-      // 堆叠的墙面点云(vertical_surface_cloud_stack_叠加)
+      // 堆叠的墙面点云(最近kKeyposeCloudStackNum帧vertical_surface_cloud_叠加)
       UpdateCollisionCloud();
 
       UpdateFrontiers();
@@ -260,7 +253,7 @@ public:
   {
     return planner_cloud_->cloud_;
   }
-  void UpdateCoveredArea(const lidar_model_ns::LiDARModel& robot_viewpoint,
+  void UpdateCoveredArea(const lidar_model_ns::LiDARModelArray& robot_viewpoint,
                          const std::shared_ptr<viewpoint_manager_ns::ViewPointManager>& viewpoint_manager);
 
   void GetUncoveredArea(const std::shared_ptr<viewpoint_manager_ns::ViewPointManager>& viewpoint_manager,
@@ -274,14 +267,16 @@ public:
   void PublishStackedCloud();
   void PublishUncoveredCloud();
   void PublishUncoveredFrontierCloud();
+  // Includes the pointcloud manager and the rolling occupancy grid
+  void GetMemoryUsage(misc_utils_ns::MemoryReport& report) const;
 
 private:
   PlanningEnvParameters parameters_;
 
-  std::vector<typename PlannerCloudType::Ptr> keypose_cloud_stack_;
-  std::vector<typename PlannerCloudType::Ptr> vertical_surface_cloud_stack_;
-
-  int keypose_cloud_count_;
+  // Voxel maps over the last kKeyposeCloudStackNum keypose and vertical surface clouds
+  pointcloud_utils_ns::SlidingWindowVoxelMap<PlannerCloudPointType> stacked_cloud_map_;
+  pointcloud_utils_ns::SlidingWindowVoxelMap<PlannerCloudPointType> stacked_vertical_surface_cloud_map_;
+  pointcloud_utils_ns::SlidingWindowVoxelMap<pcl::PointXYZI> collision_cloud_map_;
   Eigen::Vector3d robot_position_;
   Eigen::Vector3d prev_robot_position_;
   bool robot_position_update_;
@@ -289,11 +284,12 @@ private:
   std::unique_ptr<pointcloud_utils_ns::PCLCloud<PlannerCloudPointType>> stacked_cloud_;
   std::unique_ptr<pointcloud_utils_ns::PCLCloud<PlannerCloudPointType>> stacked_vertical_surface_cloud_;
   pcl::KdTreeFLANN<PlannerCloudPointType>::Ptr stacked_vertical_surface_cloud_kdtree_;
-  pointcloud_utils_ns::PointCloudDownsizer<PlannerCloudPointType> stacked_cloud_downsizer_;
-  pointcloud_utils_ns::PointCloudDownsizer<pcl::PointXYZI> collision_cloud_downsizer_;
+  pointcloud_utils_ns::VoxelHashDownsizer<PlannerCloudPointType> stacked_cloud_downsizer_;
   std::unique_ptr<pointcloud_utils_ns::PCLCloud<PlannerCloudPointType>> vertical_surface_cloud_;
   pointcloud_utils_ns::VerticalSurfaceExtractor vertical_surface_extractor_;
   pointcloud_utils_ns::VerticalSurfaceExtractor vertical_frontier_extractor_;
+  pointcloud_utils_ns::ColumnVerticalSurfaceExtractor column_vertical_surface_extractor_;
+  pointcloud_utils_ns::ColumnVerticalSurfaceExtractor column_vertical_frontier_extractor_;
 
   pcl::PointCloud<pcl::PointXYZI>::Ptr collision_cloud_;
   std::unique_ptr<pointcloud_utils_ns::PCLCloud<PlannerCloudPointType>> diff_cloud_;
@@ -315,6 +311,7 @@ private:
 
   std::unique_ptr<pointcloud_utils_ns::PCLCloud<PlannerCloudPointType>> squeezed_planner_cloud_;
   pcl::KdTreeFLANN<PlannerCloudPointType>::Ptr squeezed_planner_cloud_kdtree_;
+  misc_utils_ns::VoxelBucketHash covered_point_hash_;
 
   std::unique_ptr<pointcloud_utils_ns::PCLCloud<pcl::PointXYZI>> uncovered_cloud_;
   std::unique_ptr<pointcloud_utils_ns::PCLCloud<pcl::PointXYZI>> uncovered_frontier_cloud_;
@@ -331,4 +328,5 @@ private:
 
   void UpdateCollisionCloud();
   void UpdateFrontiers();
+  void PublishRollingOccupancyGridCloud();
 };
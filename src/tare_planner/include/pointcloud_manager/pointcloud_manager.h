@@ -24,7 +24,9 @@
 #include <visualization_msgs/Marker.h>
 
 #include "grid/grid.h"
+#include <utils/memory_report.h>
 #include <utils/misc_utils.h>
+#include <utils/profiler.h>
 
 namespace pointcloud_manager_ns
 {
@@ -34,6 +36,12 @@ public:
   typedef pcl::PointXYZRGBNormal PCLPointType;
   typedef pcl::PointCloud<pcl::PointXYZRGBNormal> PCLCloudType;
   typedef typename pcl::PointCloud<pcl::PointXYZRGBNormal>::Ptr PCLCloudTypePtr;
+  // Cell and in-cell index of a point in the cloud returned by GetPointCloud()
+  struct CloudPointHandle
+  {
+    int cloud_index;
+    int point_index;
+  };
 
   explicit PointCloudManager(int row_num = 20, int col_num = 20, int level_num = 10, int max_cell_point_num = 100000,
                              double cell_size = 24, double cell_height = 3, int neighbor_cell_num = 5);
@@ -42,6 +50,7 @@ public:
   template <class InputPCLPointType>
   void UpdatePointCloud(const pcl::PointCloud<InputPCLPointType>& cloud_in)
   {
+    PROFILE_SCOPE("pointcloud manager update pointcloud");
     for (const auto& cloud_in_point : cloud_in.points)
     {
       PCLPointType point;
@@ -66,7 +75,13 @@ public:
     // std::cout << "pointcloud_grid_number: " << pointcloud_grid_->GetCellNumber() << std::endl;
   }
 
+  // Also records a handle per output point, valid until the cell clouds are modified
   void GetPointCloud(PCLCloudType& cloud_out);
+  const CloudPointHandle& GetCloudPointHandle(int index) const
+  {
+    MY_ASSERT(index >= 0 && index < point_handles_.size());
+    return point_handles_[index];
+  }
   void ClearNeighborCellOccupancyCloud();
   pcl::PointCloud<pcl::PointXYZI>::Ptr GetRolledInOccupancyCloud();
   void GetOccupancyCloud(pcl::PointCloud<pcl::PointXYZI>::Ptr& occupancy_cloud);
@@ -87,10 +102,17 @@ public:
   }
   void GetCloudPointIndex(int index, int& cloud_index, int& cloud_point_index);
   int GetAllPointNum();
+  void GetMemoryUsage(misc_utils_ns::MemoryReport& report) const;
 
   void UpdateOldCloudPoints();
   void UpdateCoveredCloudPoints();
   void UpdateCoveredCloudPoints(int cloud_index, int point_index);
+  // Marks the point at index of the last GetPointCloud() output as covered in its cell
+  void SetCloudPointCovered(int index)
+  {
+    const CloudPointHandle& handle = GetCloudPointHandle(index);
+    pointcloud_grid_->GetCell(handle.cloud_index)->points[handle.point_index].g = 255;
+  }
 
 private:
   std::unique_ptr<grid_ns::Grid<PCLCloudTypePtr>> pointcloud_grid_;
@@ -121,6 +143,7 @@ private:
   std::vector<int> neighbor_indices_;
   std::vector<int> prev_neighbor_indices_;
   std::vector<int> new_neighbor_indices_;
+  std::vector<CloudPointHandle> point_handles_;
 
   void UpdateOrigin();
 };
@@ -17,7 +17,9 @@
 #include <Eigen/Core>
 
 #include <grid/grid.h>
+#include <utils/memory_report.h>
 #include <utils/misc_utils.h>
+#include <utils/profiler.h>
 
 namespace rolling_grid_ns
 {
@@ -60,6 +62,11 @@ public:
     Eigen::Vector3i sub = grid0_->Ind2Sub(ind);
     return GetArrayInd(sub);
   }
+  // No range check and no conversion to sub, for inner loops that keep ind in range themselves
+  int GetArrayIndUnchecked(int ind) const
+  {
+    return which_grid_ ? grid1_->GetCellValue(ind) : grid0_->GetCellValue(ind);
+  }
   int GetInd(int array_ind) const
   {
     MY_ASSERT(InRange(array_ind));
@@ -70,6 +77,11 @@ public:
   void GetUpdatedIndices(std::vector<int>& updated_indices) const;
   void GetRolledOutIndices(const Eigen::Vector3i& roll_dir, std::vector<int>& rolled_out_indices);
   void GetUpdatedArrayIndices(std::vector<int>& updated_array_indices) const;
+  uint64_t GetMemoryBytes() const
+  {
+    return grid0_->GetMemoryBytes() + grid1_->GetMemoryBytes() + misc_utils_ns::GetVectorBytes(updated_indices_) +
+           misc_utils_ns::GetVectorBytes(array_ind_to_ind_);
+  }
 
 private:
   Eigen::Vector3i size_;
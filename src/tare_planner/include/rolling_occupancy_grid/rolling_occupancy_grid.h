@@ -10,15 +10,23 @@
  */
 #pragma once
 
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <Eigen/Core>
 
 #include <ros/ros.h>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 
-#include "grid/grid.h"
+#include "grid/packed_grid.h"
 #include "rolling_grid/rolling_grid.h"
+#include "utils/bitset_utils.h"
+#include "utils/memory_report.h"
 #include "utils/misc_utils.h"
 
 namespace rolling_occupancy_grid_ns
@@ -35,7 +43,9 @@ public:
   };
 
   explicit RollingOccupancyGrid(ros::NodeHandle& nh);
-  ~RollingOccupancyGrid() = default;
+  ~RollingOccupancyGrid();
+  RollingOccupancyGrid(const RollingOccupancyGrid&) = delete;
+  RollingOccupancyGrid& operator=(const RollingOccupancyGrid&) = delete;
 
   Eigen::Vector3d GetResolution()
   {
@@ -77,6 +87,15 @@ public:
     return occupancy_cloud_;
   }
   void GetVisualizationCloud(pcl::PointCloud<pcl::PointXYZI>::Ptr& vis_cloud);
+  // Same cloud as GetVisualizationCloud() but kept by the grid and updated with the cells changed since the last call
+  const pcl::PointCloud<pcl::PointXYZI>::Ptr& UpdateVisualizationCloud();
+  // Frees the incremental visualization, the next UpdateVisualizationCloud() starts over from an empty cloud
+  void ResetVisualizationCloud();
+  int GetCellStateCount(CellState state) const
+  {
+    return occupancy_array_->Count(state);
+  }
+  void GetMemoryUsage(misc_utils_ns::MemoryReport& report) const;
 
 private:
   bool initialized_;
@@ -89,11 +108,105 @@ private:
   Eigen::Vector3d origin_;
   Eigen::Vector3d robot_position_;
   std::unique_ptr<rolling_grid_ns::RollingGrid> rolling_grid_;
-  std::unique_ptr<grid_ns::Grid<CellState>> occupancy_array_;
+  // 2 bits per cell, indexed by array ind
+  std::unique_ptr<grid_ns::PackedGrid<CellState>> occupancy_array_;
   std::vector<int> updated_grid_indices_;
   pcl::PointCloud<pcl::PointXYZI>::Ptr occupancy_cloud_;
 
+  // Parallel ray tracing, used when ray_trace_thread_num_ > 1
+  int ray_trace_thread_num_;
+  // Stop a ray at cells already freed in this update, faster but approximate
+  bool ray_trace_early_out_;
+  // Stamp of the ray trace update in which each cell (by array ind) was last freed, 0 is never
+  uint8_t ray_trace_epoch_;
+  std::vector<uint8_t> free_epoch_;
+  std::vector<int> ray_end_indices_;
+  std::vector<std::vector<int>> ray_cell_buffers_;
+  // Threads 1 to ray_trace_thread_num_ - 1 of the parallel ray trace, started with the grid and joined when it is
+  // destroyed. The calling thread traces the first share of the rays.
+  std::vector<std::thread> ray_trace_workers_;
+  std::mutex ray_trace_mutex_;
+  std::condition_variable ray_trace_start_condition_;
+  std::condition_variable ray_trace_done_condition_;
+  // Incremented for every parallel ray trace, each worker traces its share once per generation
+  int ray_trace_generation_;
+  int ray_trace_busy_worker_num_;
+  bool ray_trace_workers_stopping_;
+  Eigen::Vector3i ray_trace_origin_sub_;
+  // Unknown cells already tested in the current frontier extraction, by array ind
+  misc_utils_ns::DynamicBitset frontier_checked_;
+
+  // Cell states as of the last UpdateVisualizationCloud(), nullptr when the incremental visualization is not in use.
+  // Cells rolled into the window are set to NOT_FRONTIER, which the occupancy array never holds, so they always differ.
+  std::unique_ptr<grid_ns::PackedGrid<CellState>> vis_cell_states_;
+  pcl::PointCloud<pcl::PointXYZI>::Ptr vis_cloud_;
+  // Array ind -> index of its point in vis_cloud_ (-1 for none), and the reverse
+  std::vector<int> vis_point_indices_;
+  std::vector<int> vis_point_array_inds_;
+
   bool InRange(const Eigen::Vector3i& sub, const Eigen::Vector3i& sub_min, const Eigen::Vector3i& sub_max);
+  void RayTraceParallel(const Eigen::Vector3i& origin_sub);
+  void RayTraceWorker(int thread_ind);
+  // Share of ray_end_indices_ traced by a thread
+  void RayTraceThreadShare(int thread_ind, const int*& ray_end_begin, const int*& ray_end_end) const;
+  void RayTraceRays(const Eigen::Vector3i& origin_sub, const int* ray_end_begin, const int* ray_end_end,
+                    std::vector<int>& ray_cells);
+
+  /**
+   * @brief Integer 3D DDA between the centers of two cells, calls visitor(ind) for every cell from start to end
+   * until it returns false. Along axis i the ray crosses its k-th cell boundary at t = (2k + 1) / (2 |d_i|), the
+   * crossings of different axes are compared after scaling by the other axes' lengths, so there is no floating point.
+   */
+  template <class Visitor>
+  void TraverseRay(const Eigen::Vector3i& start_sub, const Eigen::Vector3i& end_sub, Visitor&& visitor) const
+  {
+    const int64_t kNever = INT64_MAX;
+    Eigen::Vector3i diff = end_sub - start_sub;
+    int64_t abs_x = std::abs(diff.x());
+    int64_t abs_y = std::abs(diff.y());
+    int64_t abs_z = std::abs(diff.z());
+    int64_t scale_x = abs_x > 0 ? abs_x : 1;
+    int64_t scale_y = abs_y > 0 ? abs_y : 1;
+    int64_t scale_z = abs_z > 0 ? abs_z : 1;
+    int64_t t_delta_x = 2 * scale_y * scale_z;
+    int64_t t_delta_y = 2 * scale_x * scale_z;
+    int64_t t_delta_z = 2 * scale_x * scale_y;
+    int64_t t_max_x = abs_x > 0 ? t_delta_x / 2 : kNever;
+    int64_t t_max_y = abs_y > 0 ? t_delta_y / 2 : kNever;
+    int64_t t_max_z = abs_z > 0 ? t_delta_z / 2 : kNever;
+    int step_x = misc_utils_ns::signum(diff.x());
+    int step_y = misc_utils_ns::signum(diff.y()) * grid_size_.x();
+    int step_z = misc_utils_ns::signum(diff.z()) * grid_size_.x() * grid_size_.y();
+
+    int ind = occupancy_array_->Sub2Ind(start_sub);
+    if (!visitor(ind))
+    {
+      return;
+    }
+    int step_num = abs_x + abs_y + abs_z;
+    for (int i = 0; i < step_num; i++)
+    {
+      if (t_max_x <= t_max_y && t_max_x <= t_max_z)
+      {
+        ind += step_x;
+        t_max_x += t_delta_x;
+      }
+      else if (t_max_y <= t_max_z)
+      {
+        ind += step_y;
+        t_max_y += t_delta_y;
+      }
+      else
+      {
+        ind += step_z;
+        t_max_z += t_delta_z;
+      }
+      if (!visitor(ind))
+      {
+        return;
+      }
+    }
+  }
 
   // void InitializeOrigin();
 };
@@ -25,6 +25,8 @@
 #include <std_msgs/Int32.h>
 #include <std_msgs/Int32MultiArray.h>
 #include <std_msgs/Float32.h>
+#include <std_msgs/Header.h>
+#include <std_msgs/String.h>
 #include <geometry_msgs/PolygonStamped.h>
 #include <geometry_msgs/Pose.h>
 // PCL
@@ -39,7 +41,11 @@
 #include <pcl_conversions/pcl_conversions.h>
 // Third parties
 #include <utils/pointcloud_utils.h>
+#include <utils/pointcloud2_reader.h>
+#include <utils/memory_report.h>
 #include <utils/misc_utils.h>
+#include <utils/profiler.h>
+#include <utils/visited_position_index.h>
 // Components
 #include "keypose_graph/keypose_graph.h"
 #include "planning_env/planning_env.h"
@@ -73,11 +79,17 @@ struct PlannerParameters
   std::string sub_coverage_boundary_topic_;
   std::string sub_viewpoint_boundary_topic_;
   std::string sub_nogo_boundary_topic_;
+  std::string sub_profiler_export_topic_;
+  std::string sub_memory_report_export_topic_;
 
   std::string pub_exploration_finish_topic_;
   std::string pub_runtime_breakdown_topic_;
   std::string pub_runtime_topic_;
   std::string pub_waypoint_topic_;
+  std::string pub_memory_report_topic_;
+  std::string pub_planning_cycle_topic_;
+  std::string kProfilerTraceFile;
+  std::string kMemoryReportFile;
 
   // Bool
   bool kAutoStart;
@@ -86,6 +98,17 @@ struct PlannerParameters
   bool kCheckTerrainCollision;
   bool kExtendWayPoint;
   bool kUseLineOfSightLookAheadPoint;
+  bool kEnableProfiler;
+  // Disables all visualization outputs
+  bool kHeadless;
+  // Convert and publish the visualization clouds and markers on a separate thread
+  bool kUseVisualizationThread;
+
+  // Int
+  // Number of planning iterations between two profiler reports in the log, 0 to disable
+  int kProfilerReportInterval;
+  // Number of planning iterations between two memory reports on the memory report topic, 0 to disable
+  int kMemoryReportInterval;
 
   // Double
   double kKeyposeCloudDwzFilterLeafSize;
@@ -94,6 +117,9 @@ struct PlannerParameters
   double kTerrainCollisionThreshold;
   double kLookAheadDistance;
   double kExtendWayPointDistance;
+  double kProfilerHistogramWindow;
+  // Default rate limit (Hz) of the visualization outputs, 0 for none
+  double kVisualizationMaxRate;
 
   bool ReadParameters(ros::NodeHandle& nh);
 };
@@ -121,13 +147,15 @@ struct PlannerData
 
   nav_msgs::Odometry keypose_;
   geometry_msgs::Point robot_position_;
-  lidar_model_ns::LiDARModel robot_viewpoint_;
+  lidar_model_ns::LiDARModelArray robot_viewpoint_;
   exploration_path_ns::ExplorationPath exploration_path_;
   Eigen::Vector3d lookahead_point_;
   Eigen::Vector3d moving_direction_;
   double robot_yaw_;
   bool moving_forward_;
-  std::vector<Eigen::Vector3d> visited_positions_;
+  misc_utils_ns::VisitedPositionIndex visited_positions_;
+  // Visited positions around the local planning horizon, refreshed each cycle
+  std::vector<Eigen::Vector3d> active_visited_positions_;
   int cur_keypose_node_ind_;
   Eigen::Vector3d initial_position_;
 
@@ -145,6 +173,7 @@ struct PlannerData
   std::unique_ptr<misc_utils_ns::Marker> grid_world_marker_;
 
   void Initialize(ros::NodeHandle& nh, ros::NodeHandle& nh_p);
+  void GetMemoryUsage(misc_utils_ns::MemoryReport& report) const;
 };
 
 class SensorCoveragePlanner3D
@@ -153,7 +182,7 @@ public:
   explicit SensorCoveragePlanner3D(ros::NodeHandle& nh, ros::NodeHandle& nh_p);
   bool initialize(ros::NodeHandle& nh, ros::NodeHandle& nh_p);
   void execute(const ros::TimerEvent&);
-  ~SensorCoveragePlanner3D() = default;
+  ~SensorCoveragePlanner3D();
 
 private:
   bool keypose_cloud_update_;
@@ -170,7 +199,9 @@ private:
   bool step_;
   PlannerParameters pp_;
   PlannerData pd_;
-  pointcloud_utils_ns::PointCloudDownsizer<pcl::PointXYZ> pointcloud_downsizer_;
+  // Scans are added as they arrive and flushed into the keypose cloud
+  pointcloud_utils_ns::VoxelHashDownsizer<pcl::PointXYZ> scan_stack_downsizer_;
+  pointcloud_utils_ns::VoxelHashDownsizer<pcl::PointXYZI> registered_cloud_downsizer_;
 
   int update_representation_runtime_;
   int local_viewpoint_sampling_runtime_;
@@ -180,6 +211,9 @@ private:
   int overall_runtime_;
   int registered_cloud_count_;
   int keypose_count_;
+  int profiler_report_count_;
+  int memory_report_count_;
+  misc_utils_ns::MemoryReport memory_report_;
 
   ros::Time start_time_;
 
@@ -194,6 +228,8 @@ private:
   ros::Subscriber coverage_boundary_sub_;
   ros::Subscriber viewpoint_boundary_sub_;
   ros::Subscriber nogo_boundary_sub_;
+  ros::Subscriber profiler_export_sub_;
+  ros::Subscriber memory_report_export_sub_;
 
   // ROS publishers
   ros::Publisher global_path_full_publisher_;
@@ -204,6 +240,9 @@ private:
   ros::Publisher exploration_finish_pub_;
   ros::Publisher runtime_breakdown_pub_;
   ros::Publisher runtime_pub_;
+  ros::Publisher memory_report_pub_;
+  // Stamped with the expected time of each execution, lets a simulator step in lockstep with the planner
+  ros::Publisher planning_cycle_pub_;
   // Debug
   ros::Publisher pointcloud_manager_neighbor_cells_origin_pub_;
 
@@ -216,6 +255,8 @@ private:
   void CoverageBoundaryCallback(const geometry_msgs::PolygonStampedConstPtr& polygon_msg);
   void ViewPointBoundaryCallback(const geometry_msgs::PolygonStampedConstPtr& polygon_msg);
   void NogoBoundaryCallback(const geometry_msgs::PolygonStampedConstPtr& polygon_msg);
+  void ProfilerExportCallback(const std_msgs::String::ConstPtr& file_path_msg);
+  void MemoryReportExportCallback(const std_msgs::String::ConstPtr& file_path_msg);
 
   void SendInitialWaypoint();
   void UpdateKeyposeGraph();
@@ -235,7 +276,10 @@ private:
   exploration_path_ns::ExplorationPath ConcatenateGlobalLocalPath(
       const exploration_path_ns::ExplorationPath& global_path, const exploration_path_ns::ExplorationPath& local_path);
 
+  void PlanningCycle();
   void PublishRuntime();
+  void UpdateProfiler();
+  void UpdateMemoryReport(bool force = false);
   double GetRobotToHomeDistance();
   void PublishExplorationState();
   void PublishWaypoint();
@@ -35,6 +35,8 @@ public:
   void GetGlobalSubspaceMarker(const std::unique_ptr<grid_world_ns::GridWorld>& grid_world,
                                const std::vector<int>& ordered_cell_indices);
   void PublishMarkers();
+  // Whether any marker is subscribed, the markers are only worth building if so
+  bool HasSubscribers() const;
 
 private:
   const std::string kWorldFrameID = "map";
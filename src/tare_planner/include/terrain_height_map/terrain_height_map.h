@@ -0,0 +1,98 @@
+/**
+ * @file terrain_height_map.h
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Class that implements a rolling 2.5D terrain elevation map aligned with the viewpoint grid
+ * @version 0.1
+ * @date 2021-06-19
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <cfloat>
+#include <memory>
+#include <vector>
+
+#include <Eigen/Core>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <rolling_grid/rolling_grid.h>
+#include <utils/memory_report.h>
+
+namespace terrain_height_map_ns
+{
+struct TerrainHeightCell
+{
+  float min_z = FLT_MAX;
+  float max_z = -FLT_MAX;
+  float sum_z = 0.0f;
+  int point_num = 0;
+};
+
+/**
+ * @brief Min/max/mean terrain height per xy cell, accumulated as terrain clouds arrive.
+ * The layout matches the first z layer of the viewpoint grid: the same size, resolution and subscript convention, and
+ * it is rolled with the same steps so that a viewpoint subscript addresses its terrain cell directly.
+ */
+class TerrainHeightMap
+{
+public:
+  TerrainHeightMap(const Eigen::Vector3i& size, const Eigen::Vector3d& resolution);
+  ~TerrainHeightMap() = default;
+  void SetOrigin(const Eigen::Vector3d& origin);
+  Eigen::Vector3d GetOrigin() const
+  {
+    return origin_;
+  }
+  // Shifts the origin by -roll_step * resolution and clears the cells that rolled in
+  void Roll(const Eigen::Vector3i& roll_step);
+  void Reset();
+  // Bins the points with intensity not above the threshold, points outside the map are ignored
+  void UpdateHeight(const pcl::PointCloud<pcl::PointXYZI>::Ptr& cloud, double intensity_threshold = DBL_MAX);
+  Eigen::Vector3i GetSub(const Eigen::Vector3d& position) const;
+  bool InRange(const Eigen::Vector3i& sub) const
+  {
+    return sub.z() == 0 && grid_->InRange(sub);
+  }
+  bool HasHeight(const Eigen::Vector3i& sub) const
+  {
+    return GetCell(sub).point_num > 0;
+  }
+  const TerrainHeightCell& GetCell(const Eigen::Vector3i& sub) const
+  {
+    return cells_[grid_->GetArrayInd(sub)];
+  }
+  double GetMinHeight(const Eigen::Vector3i& sub) const
+  {
+    return GetCell(sub).min_z;
+  }
+  double GetMaxHeight(const Eigen::Vector3i& sub) const
+  {
+    return GetCell(sub).max_z;
+  }
+  double GetMeanHeight(const Eigen::Vector3i& sub) const
+  {
+    const TerrainHeightCell& cell = GetCell(sub);
+    return cell.point_num > 0 ? cell.sum_z / cell.point_num : 0.0;
+  }
+  // Mean of the min heights of the observed cells within radius cells (a square window), false if none is observed
+  bool GetSmoothedMinHeight(const Eigen::Vector3i& sub, int radius, double& height) const;
+  uint64_t GetMemoryBytes() const
+  {
+    return grid_->GetMemoryBytes() + misc_utils_ns::GetVectorBytes(cells_) +
+           misc_utils_ns::GetVectorBytes(updated_indices_);
+  }
+
+  typedef std::unique_ptr<TerrainHeightMap> Ptr;
+
+private:
+  Eigen::Vector3i size_;
+  Eigen::Vector3d resolution_;
+  Eigen::Vector3d origin_;
+  std::unique_ptr<rolling_grid_ns::RollingGrid> grid_;
+  std::vector<TerrainHeightCell> cells_;
+  std::vector<int> updated_indices_;
+};
+}  // namespace terrain_height_map_ns
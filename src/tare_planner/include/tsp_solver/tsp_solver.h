@@ -10,6 +10,7 @@
 #include "ortools/constraint_solver/routing_enums.pb.h"
 #include "ortools/constraint_solver/routing_index_manager.h"
 #include "ortools/constraint_solver/routing_parameters.h"
+#include "utils/profiler.h"
 
 using namespace operations_research;
 
@@ -0,0 +1,171 @@
+/**
+ * @file bitset_utils.h
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Dense bitset used for coverage set operations
+ * @version 0.1
+ * @date 2021-06-10
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace misc_utils_ns
+{
+/**
+ * @brief A dense bitset over an index space that grows on demand.
+ * Gain computations are done word by word: popcount(this & ~other) and this |= other.
+ */
+class DynamicBitset
+{
+public:
+  typedef uint64_t WordType;
+  static const int kWordBits = 64;
+
+  DynamicBitset() = default;
+  explicit DynamicBitset(int bit_num) : words_(WordNum(bit_num), 0)
+  {
+  }
+  ~DynamicBitset() = default;
+
+  // Set all bits to zero and make sure bit_num bits can be stored without reallocation
+  void Reset(int bit_num = 0)
+  {
+    words_.assign(WordNum(bit_num), 0);
+  }
+  // Drop all bits but keep the allocated memory
+  void Clear()
+  {
+    words_.clear();
+  }
+  bool Empty() const
+  {
+    return words_.empty();
+  }
+  void Set(int ind)
+  {
+    int word_ind = ind / kWordBits;
+    if (word_ind >= static_cast<int>(words_.size()))
+    {
+      words_.resize(word_ind + 1, 0);
+    }
+    words_[word_ind] |= (WordType(1) << (ind % kWordBits));
+  }
+  void Unset(int ind)
+  {
+    int word_ind = ind / kWordBits;
+    if (word_ind < static_cast<int>(words_.size()))
+    {
+      words_[word_ind] &= ~(WordType(1) << (ind % kWordBits));
+    }
+  }
+  bool Test(int ind) const
+  {
+    int word_ind = ind / kWordBits;
+    if (word_ind >= static_cast<int>(words_.size()))
+    {
+      return false;
+    }
+    return (words_[word_ind] >> (ind % kWordBits)) & WordType(1);
+  }
+  int Count() const
+  {
+    int count = 0;
+    for (const auto& word : words_)
+    {
+      count += PopCount(word);
+    }
+    return count;
+  }
+  // Number of bits set in this but not in other
+  int CountAndNot(const DynamicBitset& other) const
+  {
+    int count = 0;
+    size_t common_size = std::min(words_.size(), other.words_.size());
+    for (size_t i = 0; i < common_size; i++)
+    {
+      count += PopCount(words_[i] & ~other.words_[i]);
+    }
+    for (size_t i = common_size; i < words_.size(); i++)
+    {
+      count += PopCount(words_[i]);
+    }
+    return count;
+  }
+  // this |= other
+  void Or(const DynamicBitset& other)
+  {
+    if (other.words_.size() > words_.size())
+    {
+      words_.resize(other.words_.size(), 0);
+    }
+    for (size_t i = 0; i < other.words_.size(); i++)
+    {
+      words_[i] |= other.words_[i];
+    }
+  }
+  // this &= other
+  void And(const DynamicBitset& other)
+  {
+    size_t common_size = std::min(words_.size(), other.words_.size());
+    for (size_t i = 0; i < common_size; i++)
+    {
+      words_[i] &= other.words_[i];
+    }
+    std::fill(words_.begin() + common_size, words_.end(), 0);
+  }
+  // this &= ~other
+  void AndNot(const DynamicBitset& other)
+  {
+    size_t common_size = std::min(words_.size(), other.words_.size());
+    for (size_t i = 0; i < common_size; i++)
+    {
+      words_[i] &= ~other.words_[i];
+    }
+  }
+  // Index of the first set bit at or after ind, -1 if there is none
+  int FindNext(int ind) const
+  {
+    int word_ind = ind / kWordBits;
+    if (ind < 0 || word_ind >= static_cast<int>(words_.size()))
+    {
+      return -1;
+    }
+    WordType word = words_[word_ind] & (~WordType(0) << (ind % kWordBits));
+    while (word == 0)
+    {
+      word_ind++;
+      if (word_ind >= static_cast<int>(words_.size()))
+      {
+        return -1;
+      }
+      word = words_[word_ind];
+    }
+    return word_ind * kWordBits + __builtin_ctzll(word);
+  }
+  int GetWordNum() const
+  {
+    return words_.size();
+  }
+  uint64_t GetMemoryBytes() const
+  {
+    return words_.capacity() * sizeof(WordType);
+  }
+
+private:
+  static int WordNum(int bit_num)
+  {
+    return (bit_num + kWordBits - 1) / kWordBits;
+  }
+  static int PopCount(WordType word)
+  {
+    return __builtin_popcountll(word);
+  }
+
+  std::vector<WordType> words_;
+};
+}  // namespace misc_utils_ns
@@ -0,0 +1,114 @@
+/**
+ * @file memory_report.h
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Per-module memory accounting with high-water marks
+ * @version 0.1
+ * @date 2021-06-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <pcl/point_cloud.h>
+
+namespace misc_utils_ns
+{
+template <class T>
+uint64_t GetVectorBytes(const std::vector<T>& vec)
+{
+  return vec.capacity() * sizeof(T);
+}
+
+template <class T>
+uint64_t GetNestedVectorBytes(const std::vector<std::vector<T>>& vec)
+{
+  uint64_t bytes = GetVectorBytes(vec);
+  for (const auto& inner_vec : vec)
+  {
+    bytes += GetVectorBytes(inner_vec);
+  }
+  return bytes;
+}
+
+// Estimated for std::unordered_map and std::unordered_set, a node per element plus the bucket array
+template <class HashTableType>
+uint64_t GetHashTableBytes(const HashTableType& hash_table)
+{
+  return hash_table.bucket_count() * sizeof(void*) +
+         hash_table.size() * (sizeof(typename HashTableType::value_type) + 2 * sizeof(void*));
+}
+
+template <class PointType>
+uint64_t GetCloudBytes(const pcl::PointCloud<PointType>& cloud)
+{
+  return sizeof(cloud) + cloud.points.capacity() * sizeof(PointType);
+}
+
+template <class CloudPtrType>
+uint64_t GetCloudPtrBytes(const CloudPtrType& cloud)
+{
+  return cloud ? GetCloudBytes(*cloud) : 0;
+}
+
+// Estimated, FLANN keeps a copy of the points, an index per point and the tree nodes
+template <class KdTreePtrType>
+uint64_t GetKdTreeBytes(const KdTreePtrType& kdtree)
+{
+  if (!kdtree || !kdtree->getInputCloud())
+  {
+    return 0;
+  }
+  return kdtree->getInputCloud()->points.size() * (3 * sizeof(float) + 3 * sizeof(int));
+}
+
+/**
+ * @brief Bytes held by each (module, category), sampled periodically.
+ * A sample is written between BeginSample() and EndSample(), the high-water marks persist across samples.
+ */
+class MemoryReport
+{
+public:
+  MemoryReport();
+  ~MemoryReport() = default;
+  void BeginSample();
+  // Accumulates if the category is added more than once in a sample
+  void Add(const std::string& module, const std::string& category, uint64_t bytes);
+  void EndSample();
+  uint64_t GetTotalBytes() const
+  {
+    return total_bytes_;
+  }
+  uint64_t GetPeakTotalBytes() const
+  {
+    return peak_total_bytes_;
+  }
+  uint64_t GetModuleBytes(const std::string& module) const;
+  uint64_t GetModulePeakBytes(const std::string& module) const;
+  void Print(std::ostream& os) const;
+  bool Export(const std::string& file_path) const;
+  // Resident set size and its peak of this process from /proc/self/status, false if unavailable
+  static bool GetResidentMemory(uint64_t& rss_bytes, uint64_t& peak_rss_bytes);
+
+private:
+  struct Entry
+  {
+    uint64_t bytes = 0;
+    uint64_t peak_bytes = 0;
+  };
+
+  std::map<std::string, std::map<std::string, Entry>> modules_;
+  // Highest sum over the categories of a module in a single sample, the category peaks may come from different samples
+  std::map<std::string, uint64_t> module_peak_bytes_;
+  uint64_t total_bytes_;
+  uint64_t peak_total_bytes_;
+  int sample_count_;
+};
+}  // namespace misc_utils_ns
@@ -31,6 +31,8 @@
 #include <algorithm>
 #include <vector>
 #include <chrono>
+#include <memory>
+#include "utils/visualization_worker.h"
 
 #define MY_ASSERT(val)                                                                                                 \
   if (!(val))                                                                                                          \
@@ -187,14 +189,20 @@ T getParam(ros::NodeHandle& nh, const std::string& name, const T default_val)
  * @param frame_id
  */
 template <class PCLPointCloudType>
-void PublishCloud(const ros::Publisher& cloud_publisher, const PCLPointCloudType& cloud, const std::string& frame_id)
+void PublishCloud(const ros::Publisher& cloud_publisher, const PCLPointCloudType& cloud, const std::string& frame_id,
+                  const ros::Time& stamp)
 {
   sensor_msgs::PointCloud2 cloud_msg;
   pcl::toROSMsg(cloud, cloud_msg);
   cloud_msg.header.frame_id = frame_id;
-  cloud_msg.header.stamp = ros::Time::now();
+  cloud_msg.header.stamp = stamp;
   cloud_publisher.publish(cloud_msg);
 }
+template <class PCLPointCloudType>
+void PublishCloud(const ros::Publisher& cloud_publisher, const PCLPointCloudType& cloud, const std::string& frame_id)
+{
+  PublishCloud(cloud_publisher, cloud, frame_id, ros::Time::now());
+}
 
 template <class ROSMsgType>
 void Publish(const ros::Publisher& publisher, ROSMsgType& msg, const std::string& frame_id)
@@ -282,12 +290,59 @@ public:
   }
 };
 
+/**
+ * @brief Decides whether a visualization output is worth producing: the node is not headless, the topic has
+ * subscribers and the rate limit allows. Callers build the message only when Open() returns true, so clouds and markers
+ * nobody looks at are neither assembled nor serialized.
+ */
+class VisualizationGate
+{
+public:
+  explicit VisualizationGate(double max_rate = 0) : last_open_time_(0)
+  {
+    SetMaxRate(max_rate);
+  }
+  ~VisualizationGate() = default;
+  // Disables every visualization output
+  static void SetHeadless(bool headless)
+  {
+    headless_ = headless;
+  }
+  static bool Headless()
+  {
+    return headless_;
+  }
+  // Rate limit (Hz) of the gates without their own, 0 for none
+  static void SetDefaultMaxRate(double max_rate)
+  {
+    default_min_interval_ = max_rate > 0 ? 1.0 / max_rate : 0;
+  }
+  // Rate limit (Hz) of this gate, 0 to use the default
+  void SetMaxRate(double max_rate)
+  {
+    min_interval_ = max_rate > 0 ? 1.0 / max_rate : 0;
+  }
+  bool HasSubscribers(const ros::Publisher& publisher) const
+  {
+    return !headless_ && publisher.getNumSubscribers() > 0;
+  }
+  // Whether to publish now, a true result counts as a publish for the rate limit
+  bool Open(const ros::Publisher& publisher);
+
+private:
+  static bool headless_;
+  static double default_min_interval_;
+  double min_interval_;
+  ros::Time last_open_time_;
+};
+
 class Marker
 {
 private:
   std::string pub_topic_;
   std::string frame_id_;
   ros::Publisher marker_pub_;
+  VisualizationGate gate_;
 
 public:
   static int id_;
@@ -336,9 +391,46 @@ public:
   {
     marker_.action = action;
   }
+  void SetMaxPublishRate(double max_rate)
+  {
+    gate_.SetMaxRate(max_rate);
+  }
+  bool HasSubscribers() const
+  {
+    return gate_.HasSubscribers(marker_pub_);
+  }
   void Publish()
   {
-    misc_utils_ns::Publish<visualization_msgs::Marker>(marker_pub_, marker_, frame_id_);
+    if (gate_.Open(marker_pub_))
+    {
+      PublishSnapshot();
+    }
+  }
+  // Runs producer, which fills marker_, only when the marker is going to be published
+  template <class Producer>
+  void PublishLazily(Producer&& producer)
+  {
+    if (gate_.Open(marker_pub_))
+    {
+      producer();
+      PublishSnapshot();
+    }
+  }
+  // Publishes a copy of marker_ from the visualization worker, or right away if the worker is not running
+  void PublishSnapshot()
+  {
+    marker_.header.frame_id = frame_id_;
+    marker_.header.stamp = ros::Time::now();
+    VisualizationWorker& worker = VisualizationWorker::GetInstance();
+    if (!worker.Enabled())
+    {
+      marker_pub_.publish(marker_);
+      return;
+    }
+    std::shared_ptr<const visualization_msgs::Marker> snapshot =
+        std::make_shared<const visualization_msgs::Marker>(marker_);
+    ros::Publisher publisher = marker_pub_;
+    worker.Post(this, [snapshot, publisher]() { publisher.publish(*snapshot); });
   }
 
   typedef std::shared_ptr<Marker> Ptr;
@@ -352,9 +444,10 @@ void RayCast(const Eigen::Vector3i& start_sub, const Eigen::Vector3i& end_sub, c
              const Eigen::Vector3i& min_sub, std::vector<Eigen::Vector3i>& output);
 bool InFOV(const Eigen::Vector3d& point_position, const Eigen::Vector3d& viewpoint_position, double vertical_half_fov,
            double range);
+// The fov ratios are the tangents of the angles between the horizontal plane and the upper and lower edges of the fov
 bool InFOVSimple(const Eigen::Vector3d& point_position, const Eigen::Vector3d& viewpoint_position,
-                 double vertical_fov_ratio, double range, double xy_dist_threshold = 0, double z_diff_threshold = 0,
-                 bool print = false);
+                 double upper_fov_ratio, double lower_fov_ratio, double range, double xy_dist_threshold = 0,
+                 double z_diff_threshold = 0, bool print = false);
 float ApproxAtan(float z);
 float ApproxAtan2(float y, float x);
 double GetPathLength(const nav_msgs::Path& path);
@@ -0,0 +1,127 @@
+/**
+ * @file pointcloud2_reader.h
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Reads the points of a sensor_msgs::PointCloud2 in place, without converting it to a PCL cloud first
+ * @version 0.1
+ * @date 2021-06-19
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include <sensor_msgs/PointCloud2.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl_conversions/pcl_conversions.h>
+
+namespace pointcloud_utils_ns
+{
+/**
+ * @brief Iterates the points of a PointCloud2 message straight from its data buffer using the field offsets.
+ * Callers filter and write the points into their own clouds in the same pass, instead of pcl::fromROSMsg into a
+ * temporary cloud followed by a copy or filter loop. Layouts that cannot be read in place (no float32 x/y/z, big-endian
+ * data) fall back to pcl::fromROSMsg, so the visitor sees the same points either way.
+ */
+class PointCloud2Reader
+{
+public:
+  explicit PointCloud2Reader(const sensor_msgs::PointCloud2& msg);
+  ~PointCloud2Reader() = default;
+
+  // Whether the points are read in place
+  bool InPlace() const
+  {
+    return in_place_;
+  }
+  bool HasIntensity() const
+  {
+    return intensity_offset_ >= 0;
+  }
+  int GetPointNumber() const
+  {
+    return msg_.width * msg_.height;
+  }
+
+  // Calls visitor(x, y, z, intensity) for every point with finite coordinates, intensity is 0 if the message has none
+  template <class Visitor>
+  void ForEach(Visitor&& visitor) const
+  {
+    if (!in_place_)
+    {
+      pcl::PointCloud<pcl::PointXYZI> cloud;
+      pcl::fromROSMsg<pcl::PointXYZI>(msg_, cloud);
+      for (const auto& point : cloud.points)
+      {
+        if (std::isfinite(point.x) && std::isfinite(point.y) && std::isfinite(point.z))
+        {
+          visitor(point.x, point.y, point.z, point.intensity);
+        }
+      }
+      return;
+    }
+    for (uint32_t row = 0; row < msg_.height; row++)
+    {
+      const uint8_t* point_data = msg_.data.data() + row * msg_.row_step;
+      for (uint32_t col = 0; col < msg_.width; col++, point_data += msg_.point_step)
+      {
+        float x, y, z;
+        std::memcpy(&x, point_data + x_offset_, sizeof(float));
+        std::memcpy(&y, point_data + y_offset_, sizeof(float));
+        std::memcpy(&z, point_data + z_offset_, sizeof(float));
+        if (std::isfinite(x) && std::isfinite(y) && std::isfinite(z))
+        {
+          visitor(x, y, z, ReadIntensity(point_data));
+        }
+      }
+    }
+  }
+
+private:
+  const sensor_msgs::PointCloud2& msg_;
+  bool in_place_;
+  int x_offset_;
+  int y_offset_;
+  int z_offset_;
+  int intensity_offset_;
+  uint8_t intensity_datatype_;
+
+  float ReadIntensity(const uint8_t* point_data) const
+  {
+    if (intensity_offset_ < 0)
+    {
+      return 0;
+    }
+    const uint8_t* field_data = point_data + intensity_offset_;
+    switch (intensity_datatype_)
+    {
+      case sensor_msgs::PointField::FLOAT32:
+      {
+        float value;
+        std::memcpy(&value, field_data, sizeof(value));
+        return value;
+      }
+      case sensor_msgs::PointField::FLOAT64:
+      {
+        double value;
+        std::memcpy(&value, field_data, sizeof(value));
+        return static_cast<float>(value);
+      }
+      case sensor_msgs::PointField::UINT8:
+        return *field_data;
+      case sensor_msgs::PointField::UINT16:
+      {
+        uint16_t value;
+        std::memcpy(&value, field_data, sizeof(value));
+        return value;
+      }
+      default:
+        return 0;
+    }
+  }
+};
+}  // namespace pointcloud_utils_ns
@@ -3,8 +3,17 @@
 //
 #pragma once
 
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
 // PCL
 #include <pcl/PointIndices.h>
+#include <pcl/common/centroid.h>
 #include <pcl/filters/extract_indices.h>
 #include <pcl/filters/voxel_grid.h>
 #include <pcl/kdtree/kdtree.h>
@@ -15,14 +24,41 @@
 #include <pcl_conversions/pcl_conversions.h>
 
 #include <utils/misc_utils.h>
+#include <utils/profiler.h>
 
 namespace pointcloud_utils_ns
 {
 class VerticalSurfaceExtractor;
+class ColumnVerticalSurfaceExtractor;
 template <typename PCLPointType>
 class PointCloudDownsizer;
 template <typename PCLPointType>
+class VoxelHashDownsizer;
+template <typename PCLPointType>
+class SlidingWindowVoxelMap;
+template <typename PCLPointType>
 struct PCLCloud;
+
+// Integer coordinates of the voxel of a point, floor(coordinate / leaf size)
+struct VoxelKey
+{
+  int x;
+  int y;
+  int z;
+  bool operator==(const VoxelKey& other) const
+  {
+    return x == other.x && y == other.y && z == other.z;
+  }
+};
+struct VoxelKeyHash
+{
+  size_t operator()(const VoxelKey& key) const
+  {
+    return static_cast<size_t>(static_cast<uint64_t>(static_cast<uint32_t>(key.x)) * 73856093ULL ^
+                               static_cast<uint64_t>(static_cast<uint32_t>(key.y)) * 19349663ULL ^
+                               static_cast<uint64_t>(static_cast<uint32_t>(key.z)) * 83492791ULL);
+  }
+};
 }  // namespace pointcloud_utils_ns
 
 class pointcloud_utils_ns::VerticalSurfaceExtractor
@@ -58,6 +94,7 @@ public:
   void ExtractVerticalSurface(typename pcl::PointCloud<PCLPointType>::Ptr& cloud, double z_max = DBL_MAX,
                               double z_min = -DBL_MAX)
   {
+    PROFILE_SCOPE("extract vertical surface");
     pcl::copyPointCloud(*cloud, *extractor_cloud_);
     for (auto& point : extractor_cloud_->points)
     {
@@ -106,6 +143,7 @@ public:
                               typename pcl::PointCloud<OutputPCLPointType>::Ptr& cloud_out, double z_max = DBL_MAX,
                               double z_min = -DBL_MAX)
   {
+    PROFILE_SCOPE("extract vertical surface");
     pcl::copyPointCloud(*cloud_in, *extractor_cloud_);
     for (auto& point : extractor_cloud_->points)
     {
@@ -149,6 +187,160 @@ public:
   }
 };
 
+/**
+ * @brief Same classification as VerticalSurfaceExtractor without the kdtree: a point is on a vertical surface if at
+ * least kNeighborThreshold points within kRadiusThreshold in the xy plane differ from it in z by (kZDiffMin,
+ * kZDiffMax). Points are hashed into 2D columns of kRadiusThreshold and sorted by z within each column. A point is
+ * rejected in O(1) if the z extent of the 3x3 columns around it is within kZDiffMin of it (e.g. flat ground).
+ * Otherwise only the points of the two z bands of those columns are checked.
+ */
+class pointcloud_utils_ns::ColumnVerticalSurfaceExtractor
+{
+private:
+  struct ColumnPoint
+  {
+    float x;
+    float y;
+    float z;
+  };
+
+  double kRadiusThreshold;
+  double kZDiffMax;
+  double kZDiffMin;
+  int kNeighborThreshold;
+  std::unordered_map<VoxelKey, int, VoxelKeyHash> column_indices_;
+  std::vector<VoxelKey> column_keys_;
+  // Column of each input point, -1 for non-finite points
+  std::vector<int> point_column_inds_;
+  // Points of column i are column_points_[column_starts_[i], column_starts_[i + 1]), sorted by z
+  std::vector<int> column_starts_;
+  std::vector<ColumnPoint> column_points_;
+  std::vector<float> column_min_z_;
+  std::vector<float> column_max_z_;
+  // Extent and indices (-1 if empty) of the 3x3 columns around each column
+  std::vector<float> stencil_min_z_;
+  std::vector<float> stencil_max_z_;
+  std::vector<int> stencil_column_inds_;
+
+  template <class PCLPointType>
+  void BuildColumns(const pcl::PointCloud<PCLPointType>& cloud)
+  {
+    column_indices_.clear();
+    column_keys_.clear();
+    point_column_inds_.resize(cloud.points.size());
+    double radius_inv = 1.0 / kRadiusThreshold;
+    for (int i = 0; i < cloud.points.size(); i++)
+    {
+      const PCLPointType& point = cloud.points[i];
+      if (!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z))
+      {
+        point_column_inds_[i] = -1;
+        continue;
+      }
+      VoxelKey key{ static_cast<int>(std::floor(point.x * radius_inv)),
+                    static_cast<int>(std::floor(point.y * radius_inv)), 0 };
+      auto inserted = column_indices_.emplace(key, static_cast<int>(column_keys_.size()));
+      if (inserted.second)
+      {
+        column_keys_.push_back(key);
+      }
+      point_column_inds_[i] = inserted.first->second;
+    }
+    column_starts_.assign(column_keys_.size() + 1, 0);
+    for (const auto& column_ind : point_column_inds_)
+    {
+      if (column_ind >= 0)
+      {
+        column_starts_[column_ind + 1]++;
+      }
+    }
+    for (int i = 0; i < column_keys_.size(); i++)
+    {
+      column_starts_[i + 1] += column_starts_[i];
+    }
+    column_points_.resize(column_starts_.back());
+    std::vector<int> column_ends(column_starts_.begin(), column_starts_.end() - 1);
+    for (int i = 0; i < cloud.points.size(); i++)
+    {
+      if (point_column_inds_[i] >= 0)
+      {
+        const PCLPointType& point = cloud.points[i];
+        column_points_[column_ends[point_column_inds_[i]]++] = ColumnPoint{ point.x, point.y, point.z };
+      }
+    }
+    FinishColumns();
+  }
+  void FinishColumns();
+  bool IsVertical(const ColumnPoint& point, int column_ind) const;
+
+public:
+  explicit ColumnVerticalSurfaceExtractor();
+  ~ColumnVerticalSurfaceExtractor() = default;
+  void SetRadiusThreshold(double radius_threshold)
+  {
+    kRadiusThreshold = radius_threshold;
+  }
+  void SetZDiffMax(double z_diff_max)
+  {
+    kZDiffMax = z_diff_max;
+  }
+  void SetZDiffMin(double z_diff_min)
+  {
+    kZDiffMin = z_diff_min;
+  }
+  void SetNeighborThreshold(int neighbor_threshold)
+  {
+    kNeighborThreshold = neighbor_threshold;
+  }
+  template <class PCLPointType>
+  void ExtractVerticalSurface(typename pcl::PointCloud<PCLPointType>::Ptr& cloud, double z_max = DBL_MAX,
+                              double z_min = -DBL_MAX)
+  {
+    PROFILE_SCOPE("extract vertical surface");
+    BuildColumns(*cloud);
+    int vertical_point_num = 0;
+    for (int i = 0; i < cloud->points.size(); i++)
+    {
+      const PCLPointType& point = cloud->points[i];
+      if (point_column_inds_[i] < 0 || point.z > z_max || point.z < z_min)
+        continue;
+      if (IsVertical(ColumnPoint{ point.x, point.y, point.z }, point_column_inds_[i]))
+      {
+        cloud->points[vertical_point_num++] = point;
+      }
+    }
+    cloud->points.resize(vertical_point_num);
+    cloud->width = vertical_point_num;
+    cloud->height = 1;
+  }
+
+  template <class InputPCLPointType, class OutputPCLPointType>
+  void ExtractVerticalSurface(typename pcl::PointCloud<InputPCLPointType>::Ptr& cloud_in,
+                              typename pcl::PointCloud<OutputPCLPointType>::Ptr& cloud_out, double z_max = DBL_MAX,
+                              double z_min = -DBL_MAX)
+  {
+    PROFILE_SCOPE("extract vertical surface");
+    BuildColumns(*cloud_in);
+    cloud_out->clear();
+    for (int i = 0; i < cloud_in->points.size(); i++)
+    {
+      const InputPCLPointType& point = cloud_in->points[i];
+      if (point_column_inds_[i] < 0 || point.z > z_max || point.z < z_min)
+        continue;
+      if (IsVertical(ColumnPoint{ point.x, point.y, point.z }, point_column_inds_[i]))
+      {
+        OutputPCLPointType point_out;
+        point_out.x = point.x;
+        point_out.y = point.y;
+        point_out.z = point.z;
+        cloud_out->points.push_back(point_out);
+      }
+    }
+    cloud_out->width = cloud_out->points.size();
+    cloud_out->height = 1;
+  }
+};
+
 template <typename PCLPointType>
 class pointcloud_utils_ns::PointCloudDownsizer
 {
@@ -169,6 +361,357 @@ public:
   }
 };
 
+/**
+ * @brief Voxel filter that hashes each point to its voxel as it is added, linear in the number of points.
+ * Points can be added in several batches (e.g. scan by scan) with Add(), Flush() then writes one point per voxel, in
+ * the order the voxels were first hit, and starts over. Unlike pcl::VoxelGrid there is no sort and no single voxel
+ * index over the whole extent, so it does not overflow for large clouds or small leaves.
+ */
+template <typename PCLPointType>
+class pointcloud_utils_ns::VoxelHashDownsizer
+{
+public:
+  enum class Policy
+  {
+    CENTROID = 0,     // Average of every field of the points in the voxel, as pcl::VoxelGrid
+    FIRST_POINT = 1,  // First point added to the voxel
+  };
+
+private:
+  Policy policy_;
+  double leaf_size_inv_x_;
+  double leaf_size_inv_y_;
+  double leaf_size_inv_z_;
+  // Voxel -> index in centroids_ or first_points_
+  std::unordered_map<VoxelKey, int, VoxelKeyHash> voxel_indices_;
+  typedef pcl::CentroidPoint<PCLPointType> Centroid;
+  std::vector<Centroid, Eigen::aligned_allocator<Centroid>> centroids_;
+  std::vector<PCLPointType, Eigen::aligned_allocator<PCLPointType>> first_points_;
+
+public:
+  explicit VoxelHashDownsizer(Policy policy = Policy::CENTROID)
+    : policy_(policy), leaf_size_inv_x_(1.0), leaf_size_inv_y_(1.0), leaf_size_inv_z_(1.0)
+  {
+  }
+  ~VoxelHashDownsizer() = default;
+  // Both apply to the points added after the next Flush() or Clear()
+  void SetPolicy(Policy policy)
+  {
+    MY_ASSERT(voxel_indices_.empty());
+    policy_ = policy;
+  }
+  void SetLeafSize(double leaf_size_x, double leaf_size_y, double leaf_size_z)
+  {
+    MY_ASSERT(voxel_indices_.empty());
+    leaf_size_inv_x_ = 1.0 / leaf_size_x;
+    leaf_size_inv_y_ = 1.0 / leaf_size_y;
+    leaf_size_inv_z_ = 1.0 / leaf_size_z;
+  }
+  int GetVoxelNumber() const
+  {
+    return voxel_indices_.size();
+  }
+  void Add(const PCLPointType& point)
+  {
+    if (!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z))
+    {
+      return;
+    }
+    VoxelKey key{ static_cast<int>(std::floor(point.x * leaf_size_inv_x_)),
+                  static_cast<int>(std::floor(point.y * leaf_size_inv_y_)),
+                  static_cast<int>(std::floor(point.z * leaf_size_inv_z_)) };
+    auto inserted = voxel_indices_.emplace(key, static_cast<int>(voxel_indices_.size()));
+    if (policy_ == Policy::CENTROID)
+    {
+      if (inserted.second)
+      {
+        centroids_.emplace_back();
+      }
+      centroids_[inserted.first->second].add(point);
+    }
+    else if (inserted.second)
+    {
+      first_points_.push_back(point);
+    }
+  }
+  void Add(const pcl::PointCloud<PCLPointType>& cloud)
+  {
+    for (const auto& point : cloud.points)
+    {
+      Add(point);
+    }
+  }
+  // Replaces the points of cloud with one point per voxel, cloud can be one of the clouds that were added
+  void Flush(pcl::PointCloud<PCLPointType>& cloud)
+  {
+    if (policy_ == Policy::CENTROID)
+    {
+      cloud.points.resize(centroids_.size());
+      for (int i = 0; i < centroids_.size(); i++)
+      {
+        centroids_[i].get(cloud.points[i]);
+      }
+    }
+    else
+    {
+      cloud.points.assign(first_points_.begin(), first_points_.end());
+    }
+    cloud.width = cloud.points.size();
+    cloud.height = 1;
+    cloud.is_dense = true;
+    Clear();
+  }
+  void Clear()
+  {
+    voxel_indices_.clear();
+    centroids_.clear();
+    first_points_.clear();
+  }
+  // Same interface as PointCloudDownsizer::Downsize()
+  void Downsize(typename pcl::PointCloud<PCLPointType>::Ptr& cloud, double leaf_size_x, double leaf_size_y,
+                double leaf_size_z)
+  {
+    Clear();
+    SetLeafSize(leaf_size_x, leaf_size_y, leaf_size_z);
+    Add(*cloud);
+    Flush(*cloud);
+  }
+};
+
+/**
+ * @brief Voxel map over the clouds of the last few keyposes, e.g. the keypose cloud stack.
+ * Each keypose cloud is stored as its per-voxel point sums. Adding a keypose adds its sums to the voxels and, once the
+ * window is full, the sums of the oldest keypose are subtracted. A voxel is dropped when no keypose in the window has
+ * points in it. GetCloud() is a live view with one point (the centroid) per voxel, only the points of the voxels
+ * touched by the added and evicted keyposes are updated.
+ */
+template <typename PCLPointType>
+class pointcloud_utils_ns::SlidingWindowVoxelMap
+{
+private:
+  struct Voxel
+  {
+    VoxelKey key;
+    double x;
+    double y;
+    double z;
+    int point_num;
+    // Number of keyposes in the window with points in the voxel
+    int keypose_num;
+    // Index of the voxel's point in cloud_, -1 if not in the cloud
+    int cloud_ind;
+    // Last update the voxel was touched in, to visit each voxel once per update
+    int update_id;
+  };
+  // Points of a keypose cloud in one voxel
+  struct Contribution
+  {
+    int voxel_ind;
+    double x;
+    double y;
+    double z;
+    int point_num;
+  };
+
+  int window_size_;
+  double leaf_size_inv_;
+  int update_id_;
+  std::deque<std::vector<Contribution>> window_;
+  std::unordered_map<VoxelKey, int, VoxelKeyHash> voxel_indices_;
+  std::vector<Voxel> voxels_;
+  std::vector<int> free_voxel_inds_;
+  std::vector<int> touched_voxel_inds_;
+  // Voxel -> index in the contributions of the keypose being added
+  std::vector<int> contribution_inds_;
+  typename pcl::PointCloud<PCLPointType>::Ptr cloud_;
+  // cloud_->points[i] is the centroid of voxels_[cloud_voxel_inds_[i]]
+  std::vector<int> cloud_voxel_inds_;
+
+  int GetVoxel(const VoxelKey& key)
+  {
+    auto it = voxel_indices_.find(key);
+    if (it != voxel_indices_.end())
+    {
+      return it->second;
+    }
+    int voxel_ind;
+    if (free_voxel_inds_.empty())
+    {
+      voxel_ind = voxels_.size();
+      voxels_.emplace_back();
+      contribution_inds_.push_back(-1);
+    }
+    else
+    {
+      voxel_ind = free_voxel_inds_.back();
+      free_voxel_inds_.pop_back();
+    }
+    voxels_[voxel_ind] = Voxel{ key, 0, 0, 0, 0, 0, -1, -1 };
+    voxel_indices_.emplace(key, voxel_ind);
+    return voxel_ind;
+  }
+  void Touch(int voxel_ind)
+  {
+    if (voxels_[voxel_ind].update_id != update_id_)
+    {
+      voxels_[voxel_ind].update_id = update_id_;
+      touched_voxel_inds_.push_back(voxel_ind);
+    }
+  }
+  void RemoveCloudPoint(int voxel_ind)
+  {
+    int cloud_ind = voxels_[voxel_ind].cloud_ind;
+    int last_voxel_ind = cloud_voxel_inds_.back();
+    cloud_->points[cloud_ind] = cloud_->points.back();
+    cloud_voxel_inds_[cloud_ind] = last_voxel_ind;
+    voxels_[last_voxel_ind].cloud_ind = cloud_ind;
+    cloud_->points.pop_back();
+    cloud_voxel_inds_.pop_back();
+    voxels_[voxel_ind].cloud_ind = -1;
+  }
+
+public:
+  explicit SlidingWindowVoxelMap(int window_size = 1, double leaf_size = 1.0)
+    : window_size_(window_size)
+    , leaf_size_inv_(1.0 / leaf_size)
+    , update_id_(0)
+    , cloud_(new pcl::PointCloud<PCLPointType>())
+  {
+  }
+  ~SlidingWindowVoxelMap() = default;
+  // Both clear the map
+  void SetWindowSize(int window_size)
+  {
+    MY_ASSERT(window_size > 0);
+    window_size_ = window_size;
+    Clear();
+  }
+  void SetLeafSize(double leaf_size)
+  {
+    leaf_size_inv_ = 1.0 / leaf_size;
+    Clear();
+  }
+  // Adds the cloud of a new keypose and evicts the oldest keypose if the window is full
+  template <class InputPCLPointType>
+  void AddCloud(const pcl::PointCloud<InputPCLPointType>& cloud)
+  {
+    update_id_++;
+    touched_voxel_inds_.clear();
+    std::vector<Contribution> contributions;
+    for (const auto& point : cloud.points)
+    {
+      if (!std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z))
+      {
+        continue;
+      }
+      VoxelKey key{ static_cast<int>(std::floor(point.x * leaf_size_inv_)),
+                    static_cast<int>(std::floor(point.y * leaf_size_inv_)),
+                    static_cast<int>(std::floor(point.z * leaf_size_inv_)) };
+      int voxel_ind = GetVoxel(key);
+      if (voxels_[voxel_ind].update_id != update_id_)
+      {
+        Touch(voxel_ind);
+        contribution_inds_[voxel_ind] = contributions.size();
+        contributions.push_back(Contribution{ voxel_ind, 0, 0, 0, 0 });
+        voxels_[voxel_ind].keypose_num++;
+      }
+      Contribution& contribution = contributions[contribution_inds_[voxel_ind]];
+      contribution.x += point.x;
+      contribution.y += point.y;
+      contribution.z += point.z;
+      contribution.point_num++;
+    }
+    for (const auto& contribution : contributions)
+    {
+      Voxel& voxel = voxels_[contribution.voxel_ind];
+      voxel.x += contribution.x;
+      voxel.y += contribution.y;
+      voxel.z += contribution.z;
+      voxel.point_num += contribution.point_num;
+    }
+    window_.push_back(std::move(contributions));
+
+    while (window_.size() > window_size_)
+    {
+      for (const auto& contribution : window_.front())
+      {
+        Voxel& voxel = voxels_[contribution.voxel_ind];
+        voxel.x -= contribution.x;
+        voxel.y -= contribution.y;
+        voxel.z -= contribution.z;
+        voxel.point_num -= contribution.point_num;
+        voxel.keypose_num--;
+        Touch(contribution.voxel_ind);
+      }
+      window_.pop_front();
+    }
+
+    for (const auto& voxel_ind : touched_voxel_inds_)
+    {
+      Voxel& voxel = voxels_[voxel_ind];
+      if (voxel.keypose_num == 0)
+      {
+        if (voxel.cloud_ind >= 0)
+        {
+          RemoveCloudPoint(voxel_ind);
+        }
+        voxel_indices_.erase(voxel.key);
+        free_voxel_inds_.push_back(voxel_ind);
+        continue;
+      }
+      if (voxel.cloud_ind < 0)
+      {
+        voxel.cloud_ind = cloud_->points.size();
+        cloud_->points.emplace_back();
+        cloud_voxel_inds_.push_back(voxel_ind);
+      }
+      PCLPointType& point = cloud_->points[voxel.cloud_ind];
+      point.x = voxel.x / voxel.point_num;
+      point.y = voxel.y / voxel.point_num;
+      point.z = voxel.z / voxel.point_num;
+    }
+    cloud_->width = cloud_->points.size();
+    cloud_->height = 1;
+  }
+  // One point per voxel, updated in place by AddCloud(), not to be modified by the caller
+  const typename pcl::PointCloud<PCLPointType>::Ptr& GetCloud() const
+  {
+    return cloud_;
+  }
+  int GetKeyposeNumber() const
+  {
+    return window_.size();
+  }
+  int GetVoxelNumber() const
+  {
+    return voxel_indices_.size();
+  }
+  // Excluding GetCloud(), which the owner reports with its other clouds
+  uint64_t GetMemoryBytes() const
+  {
+    uint64_t bytes = voxels_.capacity() * sizeof(Voxel) + free_voxel_inds_.capacity() * sizeof(int) +
+                     touched_voxel_inds_.capacity() * sizeof(int) + contribution_inds_.capacity() * sizeof(int) +
+                     cloud_voxel_inds_.capacity() * sizeof(int) +
+                     voxel_indices_.size() * (sizeof(VoxelKey) + sizeof(int) + 2 * sizeof(void*));
+    for (const auto& contributions : window_)
+    {
+      bytes += contributions.capacity() * sizeof(Contribution);
+    }
+    return bytes;
+  }
+  void Clear()
+  {
+    window_.clear();
+    voxel_indices_.clear();
+    voxels_.clear();
+    free_voxel_inds_.clear();
+    touched_voxel_inds_.clear();
+    contribution_inds_.clear();
+    cloud_->clear();
+    cloud_voxel_inds_.clear();
+  }
+};
+
 template <typename PCLPointType>
 struct pointcloud_utils_ns::PCLCloud
 {
@@ -176,6 +719,7 @@ struct pointcloud_utils_ns::PCLCloud
   std::string frame_id_;
   typename pcl::PointCloud<PCLPointType>::Ptr cloud_;
   ros::Publisher cloud_pub_;
+  misc_utils_ns::VisualizationGate gate_;
   PCLCloud(ros::NodeHandle* nh, std::string pub_cloud_topic, std::string frame_id)
     : pub_cloud_topic_(pub_cloud_topic), frame_id_(frame_id)
   {
@@ -189,9 +733,58 @@ struct pointcloud_utils_ns::PCLCloud
     cloud_pub_ = nh.advertise<sensor_msgs::PointCloud2>(pub_cloud_topic_, 2);
   }
   ~PCLCloud() = default;
+  void SetMaxPublishRate(double max_rate)
+  {
+    gate_.SetMaxRate(max_rate);
+  }
+  bool HasSubscribers() const
+  {
+    return gate_.HasSubscribers(cloud_pub_);
+  }
   void Publish()
   {
-    misc_utils_ns::PublishCloud<pcl::PointCloud<PCLPointType>>(cloud_pub_, *cloud_, frame_id_);
+    if (gate_.Open(cloud_pub_))
+    {
+      PublishSnapshot();
+    }
+  }
+  // Runs producer, which refills cloud_ from scratch, only when the cloud is going to be published. Only for clouds
+  // that are not read anywhere else, cloud_ is stale otherwise. Unless the producer shares cloud_ with its owner, the
+  // points are moved to the visualization worker rather than copied and cloud_ is left empty.
+  template <class Producer>
+  void PublishLazily(Producer&& producer)
+  {
+    if (gate_.Open(cloud_pub_))
+    {
+      producer();
+      PublishSnapshot(cloud_.use_count() == 1);
+    }
+  }
+  // Converts and publishes a snapshot of cloud_ on the visualization worker, or right away if the worker is not
+  // running. The snapshot is a copy unless move_cloud is set, then the points are swapped out of cloud_.
+  void PublishSnapshot(bool move_cloud = false)
+  {
+    misc_utils_ns::VisualizationWorker& worker = misc_utils_ns::VisualizationWorker::GetInstance();
+    if (!worker.Enabled())
+    {
+      misc_utils_ns::PublishCloud<pcl::PointCloud<PCLPointType>>(cloud_pub_, *cloud_, frame_id_);
+      return;
+    }
+    std::shared_ptr<pcl::PointCloud<PCLPointType>> snapshot = std::make_shared<pcl::PointCloud<PCLPointType>>();
+    if (move_cloud)
+    {
+      snapshot->swap(*cloud_);
+    }
+    else
+    {
+      *snapshot = *cloud_;
+    }
+    ros::Publisher publisher = cloud_pub_;
+    std::string frame_id = frame_id_;
+    ros::Time stamp = ros::Time::now();
+    worker.Post(this, [snapshot, publisher, frame_id, stamp]() {
+      misc_utils_ns::PublishCloud<pcl::PointCloud<PCLPointType>>(publisher, *snapshot, frame_id, stamp);
+    });
   }
   typedef std::shared_ptr<PCLCloud<PCLPointType>> Ptr;
 };
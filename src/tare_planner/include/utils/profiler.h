@@ -0,0 +1,212 @@
+/**
+ * @file profiler.h
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Scoped zone profiler with per-thread recording, latency histograms and Chrome trace export
+ * @version 0.1
+ * @date 2021-06-14
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// Zone id of a string literal, registered once per call site
+#define PROFILE_ZONE_ID(name)                                                                                          \
+  ([]() {                                                                                                              \
+    static const int zone_id = misc_utils_ns::Profiler::GetInstance().RegisterZone(name);                              \
+    return zone_id;                                                                                                    \
+  }())
+// Profile the rest of the enclosing scope
+#define PROFILE_SCOPE(name) misc_utils_ns::ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(PROFILE_ZONE_ID(name))
+
+namespace misc_utils_ns
+{
+/**
+ * @brief Log-linear latency histogram in nanoseconds.
+ * Values are bucketed by their highest set bit and the next kSubBucketBits bits, bounding the relative error to
+ * 1/2^kSubBucketBits over the full 64-bit range.
+ */
+class LatencyHistogram
+{
+public:
+  static const int kSubBucketBits = 4;
+  static const int kSubBucketCount = 1 << kSubBucketBits;
+  static const int kBucketCount = (64 - kSubBucketBits + 1) * kSubBucketCount;
+
+  LatencyHistogram();
+  ~LatencyHistogram() = default;
+  void Record(uint64_t value);
+  void Merge(const LatencyHistogram& other);
+  void Reset();
+  // Highest value equivalent to the p-th percentile, p in [0, 100]
+  uint64_t GetPercentile(double p) const;
+  uint64_t GetMax() const
+  {
+    return max_;
+  }
+  uint64_t GetCount() const
+  {
+    return count_;
+  }
+
+private:
+  static int GetBucketInd(uint64_t value);
+  static uint64_t GetBucketHighestValue(int bucket_ind);
+
+  std::vector<uint64_t> buckets_;
+  uint64_t count_;
+  uint64_t max_;
+};
+
+struct ProfileEvent
+{
+  int zone_id;
+  int parent_zone_id;
+  int64_t start_ns;
+  int64_t duration_ns;
+};
+
+/**
+ * @brief Single-producer ring buffer of the events of one thread.
+ * Only the owning thread writes, the profiler drains it under its own lock, so recording never blocks. Each slot is a
+ * sequence lock: the writer clears the slot's sequence, writes the fields and then stamps the slot with its write
+ * index, the reader keeps an event only if the stamp is the expected one before and after copying it.
+ */
+class ProfileThreadBuffer
+{
+public:
+  static const int kCapacity = 1 << 14;
+  static const int kMaxDepth = 64;
+
+  explicit ProfileThreadBuffer(int thread_id);
+  ~ProfileThreadBuffer() = default;
+  int GetThreadID() const
+  {
+    return thread_id_;
+  }
+  // Writer side
+  int PushZone(int zone_id);
+  void PopZone();
+  void Record(const ProfileEvent& event);
+  // Reader side, returns the number of events lost to overwriting
+  uint64_t Drain(std::vector<ProfileEvent>& events);
+
+private:
+  struct EventSlot
+  {
+    // Write index + 1 of the event in the slot, 0 while it is being written
+    std::atomic<uint64_t> sequence;
+    std::atomic<int> zone_id;
+    std::atomic<int> parent_zone_id;
+    std::atomic<int64_t> start_ns;
+    std::atomic<int64_t> duration_ns;
+  };
+
+  int thread_id_;
+  std::unique_ptr<EventSlot[]> slots_;
+  std::atomic<uint64_t> write_count_;
+  uint64_t read_count_;
+  int zone_stack_[kMaxDepth];
+  int depth_;
+};
+
+class Profiler
+{
+public:
+  static Profiler& GetInstance();
+  ~Profiler() = default;
+
+  void SetEnabled(bool enabled)
+  {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+  bool IsEnabled() const
+  {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+  void SetHistogramWindow(double window_sec)
+  {
+    histogram_window_sec_ = window_sec;
+  }
+  int RegisterZone(const std::string& name);
+  ProfileThreadBuffer& GetThreadBuffer();
+  int64_t Now() const;
+
+  // Move the recorded events of all threads into the histograms and the trace buffer
+  void Collect();
+  // Print p50/p95/p99/max of every zone as a tree
+  void PrintReport(std::ostream& os);
+  // Write the retained events in Chrome trace-event JSON format, viewable in chrome://tracing or Perfetto
+  bool ExportChromeTrace(const std::string& file_path);
+  // Write count/p50/p95/p99/max of every zone path as JSON, used as a baseline for regression comparison
+  bool ExportSummary(const std::string& file_path);
+
+private:
+  struct ZoneStats
+  {
+    LatencyHistogram current;
+    LatencyHistogram previous;
+  };
+  struct ZoneSummary
+  {
+    std::string path;
+    int depth;
+    LatencyHistogram histogram;
+  };
+
+  Profiler();
+  void RotateHistograms();
+  // Depth-first traversal of the zone tree, histograms of both windows merged
+  void GetZoneSummaries(int parent_zone_id, const std::string& parent_path, int depth, std::vector<bool>& visited,
+                        std::vector<ZoneSummary>& summaries);
+
+  static const int kTraceCapacity = 1 << 17;
+
+  std::mutex mutex_;
+  std::atomic<bool> enabled_;
+  double histogram_window_sec_;
+  std::chrono::steady_clock::time_point start_time_;
+  std::chrono::steady_clock::time_point window_start_time_;
+  std::vector<std::string> zone_names_;
+  std::vector<std::unique_ptr<ProfileThreadBuffer>> thread_buffers_;
+  // Keyed by (parent zone id, zone id), the parent of a root zone is -1
+  std::map<std::pair<int, int>, ZoneStats> zone_stats_;
+  std::deque<std::pair<int, ProfileEvent>> trace_events_;
+  std::vector<ProfileEvent> drain_buffer_;
+  uint64_t dropped_event_num_;
+};
+
+/**
+ * @brief RAII zone, records the time between construction and destruction (or Stop()) on the calling thread
+ */
+class ProfileZone
+{
+public:
+  explicit ProfileZone(int zone_id);
+  ~ProfileZone()
+  {
+    Stop();
+  }
+  void Stop();
+
+private:
+  ProfileThreadBuffer* buffer_;
+  int zone_id_;
+  int parent_zone_id_;
+  int64_t start_ns_;
+};
+}  // namespace misc_utils_ns
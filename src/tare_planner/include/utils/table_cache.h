@@ -0,0 +1,168 @@
+/**
+ * @file table_cache.h
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief On-disk cache of precomputed index tables, addressed by a hash of the parameters they depend on
+ * @version 0.1
+ * @date 2021-06-19
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace misc_utils_ns
+{
+/**
+ * @brief 64-bit FNV-1a hash over the raw bytes of the added values
+ */
+class HashBuilder
+{
+public:
+  HashBuilder() : hash_(kOffsetBasis)
+  {
+  }
+  HashBuilder& AddBytes(const void* data, size_t size);
+  template <class T>
+  HashBuilder& Add(const T& value)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable values can be hashed");
+    return AddBytes(&value, sizeof(T));
+  }
+  uint64_t Get() const
+  {
+    return hash_;
+  }
+
+private:
+  static const uint64_t kOffsetBasis = 14695981039346656037ULL;
+  static const uint64_t kPrime = 1099511628211ULL;
+  uint64_t hash_;
+};
+
+/**
+ * @brief Serializes a sequence of tables into one binary file.
+ * The file is a fixed header (magic, format version, key, payload size, payload checksum) followed by the tables in
+ * the order they were added. Each table is its element count followed by the raw elements, padded to 8 bytes. Nested
+ * tables are flattened into an offset table and a value table.
+ */
+class TableCacheWriter
+{
+public:
+  explicit TableCacheWriter(uint64_t key) : key_(key)
+  {
+  }
+  template <class T>
+  void AddTable(const std::vector<T>& table)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable tables can be cached");
+    AddBytes(table.data(), table.size(), sizeof(T));
+  }
+  template <class T>
+  void AddNestedTable(const std::vector<std::vector<T>>& table)
+  {
+    std::vector<uint32_t> offsets(table.size() + 1, 0);
+    for (size_t i = 0; i < table.size(); i++)
+    {
+      offsets[i + 1] = offsets[i] + table[i].size();
+    }
+    std::vector<T> values;
+    values.reserve(offsets.back());
+    for (const auto& row : table)
+    {
+      values.insert(values.end(), row.begin(), row.end());
+    }
+    AddTable(offsets);
+    AddTable(values);
+  }
+  // Writes to a temporary file next to file_path and renames it, so readers never see a partial file
+  bool Write(const std::string& file_path) const;
+
+private:
+  void AddBytes(const void* data, uint64_t element_num, size_t element_size);
+
+  uint64_t key_;
+  std::vector<char> payload_;
+};
+
+/**
+ * @brief Memory-maps a file written by TableCacheWriter and reads the tables back in the same order.
+ * Any mismatch (missing file, other key or format version, truncation, checksum) makes Open() or the reads fail, and
+ * the caller is expected to recompute the tables.
+ */
+class TableCacheReader
+{
+public:
+  TableCacheReader() : data_(nullptr), size_(0), read_offset_(0)
+  {
+  }
+  ~TableCacheReader()
+  {
+    Close();
+  }
+  TableCacheReader(const TableCacheReader&) = delete;
+  TableCacheReader& operator=(const TableCacheReader&) = delete;
+  bool Open(const std::string& file_path, uint64_t key);
+  void Close();
+  template <class T>
+  bool ReadTable(std::vector<T>& table)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable tables can be cached");
+    uint64_t element_num = 0;
+    const char* elements = ReadBytes(sizeof(T), element_num);
+    if (elements == nullptr)
+    {
+      return false;
+    }
+    table.resize(element_num);
+    if (element_num > 0)
+    {
+      std::memcpy(table.data(), elements, element_num * sizeof(T));
+    }
+    return true;
+  }
+  template <class T>
+  bool ReadNestedTable(std::vector<std::vector<T>>& table)
+  {
+    std::vector<uint32_t> offsets;
+    std::vector<T> values;
+    if (!ReadTable(offsets) || !ReadTable(values) || offsets.empty() || offsets.back() != values.size())
+    {
+      return false;
+    }
+    table.resize(offsets.size() - 1);
+    for (size_t i = 0; i < table.size(); i++)
+    {
+      if (offsets[i] > offsets[i + 1])
+      {
+        return false;
+      }
+      table[i].assign(values.begin() + offsets[i], values.begin() + offsets[i + 1]);
+    }
+    return true;
+  }
+  // Whether every table in the file has been read
+  bool AtEnd() const
+  {
+    return data_ != nullptr && read_offset_ == size_;
+  }
+
+private:
+  // Returns a pointer to the elements of the next table, nullptr if the file is too short
+  const char* ReadBytes(size_t element_size, uint64_t& element_num);
+
+  const char* data_;
+  size_t size_;
+  size_t read_offset_;
+};
+
+// <directory>/<name>_<key in hex>.bin
+std::string GetTableCachePath(const std::string& directory, const std::string& name, uint64_t key);
+// Creates the directory and its missing parents, returns false if it does not exist afterwards
+bool CreateDirectories(const std::string& directory);
+}  // namespace misc_utils_ns
@@ -0,0 +1,75 @@
+/**
+ * @file visited_position_index.h
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Spatial hash of the positions visited by the robot, with far away positions rolled out to an archive
+ * @version 0.1
+ * @date 2021-06-18
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <Eigen/Core>
+
+namespace misc_utils_ns
+{
+/**
+ * @brief Deduplicated visited positions hashed into voxels of the visited radius.
+ * Voxels in the active range are kept in a hash map for O(1) lookup. Voxels outside are moved into an archive of
+ * 2D blocks holding packed positions, which are moved back when the active range comes close again, so the cost per
+ * planning cycle is bounded by the size of the active range rather than the mission length.
+ */
+class VisitedPositionIndex
+{
+public:
+  explicit VisitedPositionIndex(double visited_radius = 1.0, int archive_block_size = 16);
+  ~VisitedPositionIndex() = default;
+  // Adds the position unless one within the visited radius is already stored, returns whether it was added
+  bool Insert(const Eigen::Vector3d& position);
+  // Whether any stored position is within radius of the query, archived positions included
+  bool IsVisited(const Eigen::Vector3d& position, double radius) const;
+  // Keep the blocks overlapping [center - range, center + range] in xy active and archive the rest
+  void UpdateActiveRange(const Eigen::Vector3d& center, const Eigen::Vector3d& range);
+  void GetActivePositions(std::vector<Eigen::Vector3d>& positions) const;
+  int GetPositionNum() const
+  {
+    return active_position_num_ + archived_position_num_;
+  }
+  int GetArchivedPositionNum() const
+  {
+    return archived_position_num_;
+  }
+  double GetVisitedRadius() const
+  {
+    return visited_radius_;
+  }
+  uint64_t GetMemoryBytes() const;
+
+private:
+  typedef std::vector<Eigen::Vector3f> PositionList;
+
+  Eigen::Vector3i GetVoxelSub(const Eigen::Vector3d& position) const;
+  static int64_t GetVoxelKey(const Eigen::Vector3i& voxel_sub);
+  static int64_t GetBlockKey(int block_x, int block_y);
+  int GetBlockIndex(int voxel_index) const;
+  bool BlockActive(int block_x, int block_y) const;
+  bool VoxelActive(const Eigen::Vector3i& voxel_sub) const;
+  static bool InRadius(const PositionList& positions, const Eigen::Vector3f& position, float radius);
+
+  double visited_radius_;
+  int archive_block_size_;
+  std::unordered_map<int64_t, PositionList> active_voxels_;
+  std::unordered_map<int64_t, PositionList> archived_blocks_;
+  // Active block range in xy, inclusive
+  Eigen::Vector2i active_block_min_;
+  Eigen::Vector2i active_block_max_;
+  bool active_range_set_;
+  int active_position_num_;
+  int archived_position_num_;
+};
+}  // namespace misc_utils_ns
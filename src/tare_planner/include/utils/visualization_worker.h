@@ -0,0 +1,56 @@
+/**
+ * @file visualization_worker.h
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Thread that serializes and publishes visualization messages off the planning thread
+ * @version 0.1
+ * @date 2021-06-19
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace misc_utils_ns
+{
+/**
+ * @brief Runs publish tasks on a background thread.
+ * The planner posts a task holding an immutable snapshot of the message, and the worker does the conversion (e.g.
+ * toROSMsg) and the publish. Each output (key) has a single slot: if the worker falls behind, a newer task replaces the
+ * one of the same output that has not started yet, so only the latest snapshot of each output is published.
+ */
+class VisualizationWorker
+{
+public:
+  typedef std::function<void()> PublishTask;
+
+  static VisualizationWorker& GetInstance();
+  ~VisualizationWorker();
+  VisualizationWorker(const VisualizationWorker&) = delete;
+  VisualizationWorker& operator=(const VisualizationWorker&) = delete;
+
+  // Starts or stops the thread, while stopped tasks run on the posting thread
+  void SetEnabled(bool enabled);
+  bool Enabled() const;
+  void Post(const void* key, PublishTask task);
+  // Number of tasks replaced by a newer one before they started
+  int GetDroppedTaskCount() const;
+
+private:
+  VisualizationWorker();
+  void Run();
+
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  std::thread thread_;
+  bool running_;
+  int dropped_task_count_;
+  // Output -> latest task not started yet
+  std::unordered_map<const void*, PublishTask> mailbox_;
+};
+}  // namespace misc_utils_ns
@@ -0,0 +1,59 @@
+/**
+ * @file voxel_bucket_hash.h
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Points bucketed into a voxel hash for fixed radius neighbor tests
+ * @version 0.1
+ * @date 2021-06-19
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <Eigen/Core>
+
+namespace misc_utils_ns
+{
+/**
+ * @brief Points hashed into cubic voxels with the side length of the query radius.
+ * A point within the radius of a query can only be in the query voxel or one of its 26 neighbors, so a radius test
+ * probes 27 buckets instead of searching a tree. Buckets are chained through an index array and Reset() keeps the
+ * allocations, so rebuilding the hash every planning cycle does not reallocate.
+ */
+class VoxelBucketHash
+{
+public:
+  explicit VoxelBucketHash(double radius = 1.0);
+  ~VoxelBucketHash() = default;
+  // Removes all points and sets the radius used for both the voxel size and the queries
+  void Reset(double radius);
+  void Insert(const Eigen::Vector3f& position);
+  // Whether any point is within (<=) the radius of the query
+  bool HasPointInRadius(const Eigen::Vector3f& position) const;
+  int Size() const
+  {
+    return static_cast<int>(positions_.size());
+  }
+  bool Empty() const
+  {
+    return positions_.empty();
+  }
+  uint64_t GetMemoryBytes() const;
+
+private:
+  Eigen::Vector3i GetVoxelSub(const Eigen::Vector3f& position) const;
+  static int64_t GetVoxelKey(const Eigen::Vector3i& voxel_sub);
+
+  float radius_;
+  float radius_sq_;
+  // Voxel key -> index of the last point inserted in the voxel
+  std::unordered_map<int64_t, int> bucket_heads_;
+  std::vector<Eigen::Vector3f> positions_;
+  // Index of the previous point in the same voxel, -1 at the end of the chain
+  std::vector<int> next_indices_;
+};
+}  // namespace misc_utils_ns
@@ -0,0 +1,169 @@
+/**
+ * @file viewpoint_store.h
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Structure-of-arrays storage of the viewpoints in the local planning horizon
+ * @version 0.1
+ * @date 2021-06-19
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <vector>
+
+#include <geometry_msgs/Point.h>
+
+#include <lidar_model/lidar_model.h>
+#include <utils/bitset_utils.h>
+#include <utils/memory_report.h>
+#include <viewpoint/viewpoint.h>
+
+namespace viewpoint_ns
+{
+enum class ViewPointState
+{
+  // Whether this viewpoint is in collision with the environment
+  IN_COLLISION = 0,
+  // Whether this viewpoint has been in the line of sight of the robot
+  IN_LINE_OF_SIGHT = 1,
+  // Whether the viewpoint is in line of sight in the current frame
+  IN_CURRENT_FRAME_LINE_OF_SIGHT = 2,
+  // Whether this viewpoint and the robot’s current location are within the same connected component. It must be true to
+  // have a collision-free path planned from the current robot position to this viewpoint.
+  CONNECTED = 3,
+  // Whether this viewpoint has been visited by the robot. If true, its coverage area will not be updated and it will
+  // not be selected in the sampling process.
+  VISITED = 4,
+  // Whether this viewpoint is selected to form the path.
+  SELECTED = 5,
+  // Whether this viewpoint is a candidate to be selected to form the path.
+  CANDIDATE = 6,
+  // Whether this viewpoint has a height set from terrain analysis
+  HAS_TERRAIN_HEIGHT = 7,
+  // Whether this viewpoint is in an EXPLORING cell
+  IN_EXPLORING_CELL = 8
+};
+
+/**
+ * @brief Viewpoints stored as parallel arrays indexed by array ind.
+ * Each state flag is a packed bitset so that flag scans touch one bit per viewpoint and can be combined word by word.
+ * Positions and counters are contiguous. The LiDAR coverage models, which hold the large coverage arrays, are kept in
+ * a separate pool only touched by coverage updates, with the sensor model type chosen at runtime.
+ */
+class ViewPointStore
+{
+public:
+  static const int kStateNum = 9;
+
+  explicit ViewPointStore(int viewpoint_num = 0,
+                          lidar_model_ns::LiDARModelType lidar_model_type = lidar_model_ns::LiDARModelType::VLP16);
+  ~ViewPointStore() = default;
+  void Resize(int viewpoint_num,
+              lidar_model_ns::LiDARModelType lidar_model_type = lidar_model_ns::LiDARModelType::VLP16);
+  int Size() const
+  {
+    return viewpoint_num_;
+  }
+  bool GetState(ViewPointState state, int array_ind) const
+  {
+    return states_[static_cast<int>(state)].Test(array_ind);
+  }
+  void SetState(ViewPointState state, int array_ind, bool value)
+  {
+    if (value)
+    {
+      states_[static_cast<int>(state)].Set(array_ind);
+    }
+    else
+    {
+      states_[static_cast<int>(state)].Unset(array_ind);
+    }
+  }
+  const misc_utils_ns::DynamicBitset& GetStateSet(ViewPointState state) const
+  {
+    return states_[static_cast<int>(state)];
+  }
+  misc_utils_ns::DynamicBitset& GetStateSet(ViewPointState state)
+  {
+    return states_[static_cast<int>(state)];
+  }
+  // Set the state of all viewpoints to false
+  void ClearState(ViewPointState state)
+  {
+    states_[static_cast<int>(state)].Reset(viewpoint_num_);
+  }
+  int CountState(ViewPointState state) const
+  {
+    return states_[static_cast<int>(state)].Count();
+  }
+  const geometry_msgs::Point& GetPosition(int array_ind) const
+  {
+    return positions_[array_ind];
+  }
+  void SetPosition(int array_ind, const geometry_msgs::Point& position)
+  {
+    positions_[array_ind] = position;
+    lidar_models_.SetPosition(array_ind, position);
+  }
+  double GetHeight(int array_ind) const
+  {
+    return positions_[array_ind].z;
+  }
+  void SetHeight(int array_ind, double height)
+  {
+    positions_[array_ind].z = height;
+    lidar_models_.SetHeight(array_ind, height);
+  }
+  int GetCellInd(int array_ind) const
+  {
+    return cell_indices_[array_ind];
+  }
+  void SetCellInd(int array_ind, int cell_ind)
+  {
+    cell_indices_[array_ind] = cell_ind;
+  }
+  int GetCollisionFrameCount(int array_ind) const
+  {
+    return collision_frame_counts_[array_ind];
+  }
+  void AddCollisionFrame(int array_ind)
+  {
+    collision_frame_counts_[array_ind]++;
+  }
+  void ResetCollisionFrameCount(int array_ind)
+  {
+    collision_frame_counts_[array_ind] = 0;
+  }
+  ViewPoint& GetCoveredPoints(int array_ind)
+  {
+    return covered_points_[array_ind];
+  }
+  const ViewPoint& GetCoveredPoints(int array_ind) const
+  {
+    return covered_points_[array_ind];
+  }
+  lidar_model_ns::LiDARModelArray& GetLiDARModels()
+  {
+    return lidar_models_;
+  }
+  const lidar_model_ns::LiDARModelArray& GetLiDARModels() const
+  {
+    return lidar_models_;
+  }
+  // Clears the states (except the current frame line of sight), cell index, collision count and coverage
+  void Reset(int array_ind);
+  void ResetCoverage();
+  uint64_t GetMemoryBytes() const;
+  uint64_t GetCoveredPointMemoryBytes() const;
+
+private:
+  int viewpoint_num_;
+  std::vector<misc_utils_ns::DynamicBitset> states_;
+  std::vector<geometry_msgs::Point> positions_;
+  std::vector<int> cell_indices_;
+  std::vector<int> collision_frame_counts_;
+  std::vector<ViewPoint> covered_points_;
+  lidar_model_ns::LiDARModelArray lidar_models_;
+};
+}  // namespace viewpoint_ns
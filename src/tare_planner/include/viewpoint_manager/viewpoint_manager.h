@@ -12,6 +12,7 @@
 
 #include <memory>
 #include <cmath>
+#include <unordered_map>
 
 #include <Eigen/Core>
 // ROS
@@ -29,8 +30,12 @@
 
 #include <grid/grid.h>
 #include <rolling_grid/rolling_grid.h>
-#include <viewpoint/viewpoint.h>
+#include <viewpoint/viewpoint_store.h>
+#include <terrain_height_map/terrain_height_map.h>
 #include <utils/misc_utils.h>
+#include <utils/bitset_utils.h>
+#include <utils/memory_report.h>
+#include <utils/table_cache.h>
 #include <grid_world/grid_world.h>
 #include <exploration_path/exploration_path.h>
 
@@ -67,12 +72,16 @@ struct ViewPointManagerParameter
   // Terrain height
   double kViewPointHeightFromTerrain;
   double kViewPointHeightFromTerrainChangeThreshold;
+  int kViewPointHeightSmoothingRadius;
 
   // Coverage
   double kCoverageOcclusionThr;
   double kCoverageDilationRadius;
   double kCoveragePointCloudResolution;
 
+  // Sensor model
+  lidar_model_ns::LiDARModelType kLiDARModelType;
+
   // Distances
   double kSensorRange;
   double kVisitRange;
@@ -80,15 +89,50 @@ struct ViewPointManagerParameter
   double kHeightFromTerrain;
   double kDistanceToIntConst;
 
-  // FOV
-  double kVerticalFOVRatio;
-  double kDiffZMax;
+  // FOV, derived from the vertical field-of-view of kLiDARModel, the upper and lower limits differ for sensors whose
+  // field-of-view is not centered at the horizontal plane
+  double kUpperFOVRatio;
+  double kLowerFOVRatio;
+  double kUpperDiffZMax;
+  double kLowerDiffZMax;
   double kInFovXYDistThreshold;
   double kInFovZDiffThreshold;
 
+  // Startup table cache
+  bool kUseStartupCache;
+  std::string kStartupCacheDirectory;
+
   bool ReadParameters(ros::NodeHandle& nh);
 };
 
+// Non-owning view of a contiguous range of indices
+struct IndexSpan
+{
+  IndexSpan(const int* begin, const int* end) : begin_(begin), end_(end)
+  {
+  }
+  const int* begin() const
+  {
+    return begin_;
+  }
+  const int* end() const
+  {
+    return end_;
+  }
+  int size() const
+  {
+    return end_ - begin_;
+  }
+  bool empty() const
+  {
+    return begin_ == end_;
+  }
+
+private:
+  const int* begin_;
+  const int* end_;
+};
+
 class ViewPointManager
 {
 public:
@@ -109,7 +153,7 @@ public:
   }
   inline int GetViewPointNum()
   {
-    return viewpoints_.size();
+    return viewpoints_.Size();
   }
   Eigen::Vector3d GetResolution()
   {
@@ -140,8 +184,7 @@ public:
   void CheckViewPointCollision(const pcl::PointCloud<pcl::PointXYZI>::Ptr& collision_cloud);
   void CheckViewPointCollisionWithTerrain(const pcl::PointCloud<pcl::PointXYZI>::Ptr& terrain_cloud,
                                           double collision_threshold);
-  void CheckViewPointLineOfSightHelper(const Eigen::Vector3i& start_sub, const Eigen::Vector3i& end_sub,
-                                       const Eigen::Vector3i& max_sub, const Eigen::Vector3i& min_sub);
+  void CheckViewPointLineOfSightHelper(int start_ind, const std::vector<int>& ray_template);
   void CheckViewPointLineOfSight();
   void CheckViewPointInFOV();
   bool InFOV(const Eigen::Vector3d& point_position, const Eigen::Vector3d& viewpoint_position);
@@ -150,70 +193,69 @@ public:
   void CheckViewPointConnectivity();
   void UpdateViewPointVisited(const std::vector<Eigen::Vector3d>& positions);
   void UpdateViewPointVisited(std::unique_ptr<grid_world_ns::GridWorld> const& grid_world);
-  void SetViewPointHeightWithTerrain(const pcl::PointCloud<pcl::PointXYZI>::Ptr& terrain_cloud,
-                                     double terrain_height_threshold = DBL_MAX);
+  void UpdateTerrainHeightMap(const pcl::PointCloud<pcl::PointXYZI>::Ptr& terrain_cloud,
+                              double terrain_height_threshold = DBL_MAX);
+  void SetViewPointHeightWithTerrain();
 
   template <class PCLPointType>
   void UpdateViewPointCoverage(const typename pcl::PointCloud<PCLPointType>::Ptr& cloud)
   {
     // std::cout << "update cloud size: " << cloud->points.size() << std::endl;
-    int update_viewpoint_count = 0;
-    for (auto& viewpoint : viewpoints_)
-    {
-      if (viewpoint.InCollision())
-      {
-        continue;
-      }
-      update_viewpoint_count++;
-    }
+    int update_viewpoint_count =
+        viewpoints_.Size() - viewpoints_.CountState(viewpoint_ns::ViewPointState::IN_COLLISION);
     std::cout << "update viewpoint num: " << update_viewpoint_count << std::endl;
-    // "PlanningEnv::diff_cloud_"
-    for (const auto& point : cloud->points)
-    {
-      for (int i = 0; i < viewpoints_.size(); i++)
-      // for (auto& viewpoint : viewpoints_)
+    // Dispatch to the sensor model once, the loops below run its fixed-size kernel
+    viewpoints_.GetLiDARModels().Visit([&](auto& lidar_models) {
+      // "PlanningEnv::diff_cloud_"
+      for (const auto& point : cloud->points)
       {
-        if (viewpoints_[i].InCollision())
+        for (int i = 0; i < viewpoints_.Size(); i++)
         {
-          continue;
-        }
-        geometry_msgs::Point viewpoint_position = viewpoints_[i].GetPosition();
-        // 只处理距离近的viewpoint
-        if (misc_utils_ns::InFOVSimple(
-                Eigen::Vector3d(point.x, point.y, point.z),
-                Eigen::Vector3d(viewpoint_position.x, viewpoint_position.y, viewpoint_position.z),
-                vp_.kVerticalFOVRatio, vp_.kSensorRange, vp_.kInFovXYDistThreshold, vp_.kInFovZDiffThreshold))
-        {
-          // ？
-          viewpoints_[i].UpdateCoverage<PCLPointType>(point);
+          if (viewpoints_.GetState(viewpoint_ns::ViewPointState::IN_COLLISION, i))
+          {
+            continue;
+          }
+          const geometry_msgs::Point& viewpoint_position = viewpoints_.GetPosition(i);
+          // 只处理距离近的viewpoint
+          if (misc_utils_ns::InFOVSimple(
+                  Eigen::Vector3d(point.x, point.y, point.z),
+                  Eigen::Vector3d(viewpoint_position.x, viewpoint_position.y, viewpoint_position.z),
+                  vp_.kUpperFOVRatio, vp_.kLowerFOVRatio, vp_.kSensorRange, vp_.kInFovXYDistThreshold,
+                  vp_.kInFovZDiffThreshold))
+          {
+            lidar_models[i].template UpdateCoverage<PCLPointType>(point);
+          }
         }
       }
-    }
+    });
   }
 
   template <class PCLPointType>
   void UpdateRolledOverViewPointCoverage(const typename pcl::PointCloud<PCLPointType>::Ptr& cloud)
   {
-    // "PlanningEnv::stacked_cloud_"
-    for (const auto& point : cloud->points)
-    {
-      for (const auto& viewpoint_ind : updated_viewpoint_indices_)
+    viewpoints_.GetLiDARModels().Visit([&](auto& lidar_models) {
+      // "PlanningEnv::stacked_cloud_"
+      for (const auto& point : cloud->points)
       {
-        int array_ind = grid_->GetArrayInd(viewpoint_ind);
-        if (viewpoints_[array_ind].InCollision())
+        for (const auto& viewpoint_ind : updated_viewpoint_indices_)
         {
-          continue;
-        }
-        geometry_msgs::Point viewpoint_position = viewpoints_[array_ind].GetPosition();
-        if (misc_utils_ns::InFOVSimple(
-                Eigen::Vector3d(point.x, point.y, point.z),
-                Eigen::Vector3d(viewpoint_position.x, viewpoint_position.y, viewpoint_position.z),
-                vp_.kVerticalFOVRatio, vp_.kSensorRange, vp_.kInFovXYDistThreshold, vp_.kInFovZDiffThreshold))
-        {
-          viewpoints_[array_ind].UpdateCoverage<PCLPointType>(point);
+          int array_ind = grid_->GetArrayInd(viewpoint_ind);
+          if (viewpoints_.GetState(viewpoint_ns::ViewPointState::IN_COLLISION, array_ind))
+          {
+            continue;
+          }
+          const geometry_msgs::Point& viewpoint_position = viewpoints_.GetPosition(array_ind);
+          if (misc_utils_ns::InFOVSimple(
+                  Eigen::Vector3d(point.x, point.y, point.z),
+                  Eigen::Vector3d(viewpoint_position.x, viewpoint_position.y, viewpoint_position.z),
+                  vp_.kUpperFOVRatio, vp_.kLowerFOVRatio, vp_.kSensorRange, vp_.kInFovXYDistThreshold,
+                  vp_.kInFovZDiffThreshold))
+          {
+            lidar_models[array_ind].template UpdateCoverage<PCLPointType>(point);
+          }
         }
       }
-    }
+    });
   }
 
   inline double GetSensorRange() const
@@ -234,19 +276,21 @@ public:
   {
     MY_ASSERT(grid_->InRange(viewpoint_ind));
     int array_ind = grid_->GetArrayInd(viewpoint_ind);
-    geometry_msgs::Point viewpoint_position = viewpoints_[array_ind].GetPosition();
-    if (std::abs(point.z - viewpoint_position.z) > vp_.kDiffZMax)
+    const geometry_msgs::Point& viewpoint_position = viewpoints_.GetPosition(array_ind);
+    double z_diff = point.z - viewpoint_position.z;
+    if (z_diff > vp_.kUpperDiffZMax || -z_diff > vp_.kLowerDiffZMax)
     {
       return false;
     }
     if (!misc_utils_ns::InFOVSimple(Eigen::Vector3d(point.x, point.y, point.z),
                                     Eigen::Vector3d(viewpoint_position.x, viewpoint_position.y, viewpoint_position.z),
-                                    vp_.kVerticalFOVRatio, vp_.kSensorRange, vp_.kInFovXYDistThreshold,
-                                    vp_.kInFovZDiffThreshold))
+                                    vp_.kUpperFOVRatio, vp_.kLowerFOVRatio, vp_.kSensorRange,
+                                    vp_.kInFovXYDistThreshold, vp_.kInFovZDiffThreshold))
     {
       return false;
     }
-    bool visible = viewpoints_[array_ind].CheckVisibility<PointType>(point, vp_.kCoverageOcclusionThr);
+    bool visible =
+        viewpoints_.GetLiDARModels().CheckVisibility<PointType>(array_ind, point, vp_.kCoverageOcclusionThr);
 
     return visible;
   }
@@ -310,12 +354,26 @@ public:
   void UpdateViewPointCoveredPoint(std::vector<bool>& point_list, int viewpoint_index, bool use_array_ind = false);
   void UpdateViewPointCoveredFrontierPoint(std::vector<bool>& frontier_point_list, int viewpoint_index,
                                            bool use_array_ind = false);
+  // Bitset versions of the above, gain = popcount(viewpoint_set & ~covered_set)
+  int GetViewPointCoveredPointNum(const misc_utils_ns::DynamicBitset& covered_point_set, int viewpoint_index,
+                                  bool use_array_ind = false);
+  int GetViewPointCoveredFrontierPointNum(const misc_utils_ns::DynamicBitset& covered_frontier_point_set,
+                                          int viewpoint_index, bool use_array_ind = false);
+  void UpdateViewPointCoveredPoint(misc_utils_ns::DynamicBitset& covered_point_set, int viewpoint_index,
+                                   bool use_array_ind = false);
+  void UpdateViewPointCoveredFrontierPoint(misc_utils_ns::DynamicBitset& covered_frontier_point_set,
+                                           int viewpoint_index, bool use_array_ind = false);
 
   int GetViewPointCandidate();
   std::vector<int> GetViewPointCandidateIndices() const
   {
     return candidate_indices_;
   }
+  // Incremented whenever a node is added to or removed from the candidate viewpoint graph
+  int GetCandidateViewPointGraphVersion() const
+  {
+    return candidate_graph_version_;
+  }
   nav_msgs::Path GetViewPointShortestPath(int start_viewpoint_ind, int target_viewpoint_ind);
   nav_msgs::Path GetViewPointShortestPath(const Eigen::Vector3d& start_position,
                                           const Eigen::Vector3d& target_position);
@@ -335,9 +393,14 @@ public:
   {
     return vp_.kUseFrontier;
   }
+  lidar_model_ns::LiDARModelType GetLiDARModelType() const
+  {
+    return vp_.kLiDARModelType;
+  }
   // For visualization
   void GetVisualizationCloud(pcl::PointCloud<pcl::PointXYZI>::Ptr& vis_cloud);
   void GetCollisionViewPointVisCloud(pcl::PointCloud<pcl::PointXYZI>::Ptr& cloud);
+  void GetMemoryUsage(misc_utils_ns::MemoryReport& report) const;
 
   typedef std::unique_ptr<ViewPointManager> Ptr;
 
@@ -346,29 +409,71 @@ private:
   void ComputeInRangeNeighborIndices();
   void GetCandidateViewPointGraph(std::vector<std::vector<int>>& graph, std::vector<std::vector<double>>& dist,
                                   std::vector<geometry_msgs::Point>& positions);
+  bool UpdateCandidateViewPointGraph();
+  void AddCandidateViewPointGraphNode(int viewpoint_ind);
+  void RemoveCandidateViewPointGraphNode(int viewpoint_ind);
+  void InitializeCollisionGrid();
   void GetCollisionCorrespondence();
+  void ComputeBoundaryViewPointSubs();
+  // The neighbor, collision correspondence and line of sight tables only depend on the grid parameters, they are
+  // cached on disk under a hash of those parameters
+  uint64_t GetStartupCacheKey() const;
+  bool LoadStartupTables(const std::string& file_path);
+  bool SaveStartupTables(const std::string& file_path) const;
+  const std::vector<int>& GetLineOfSightRayTemplate(const Eigen::Vector3i& start_sub, const Eigen::Vector3i& end_sub);
+  // Incremental connectivity
+  bool ViewPointTraversable(int viewpoint_ind, bool use_array_ind = false);
+  int FindConnectivityLabel(int label);
+  void UpdateConnectivityLabels();
+  void LabelConnectedComponents(const std::vector<int>& seed_array_indices);
+  void CheckViewPointConnectivityFrom(int start_ind);
+  IndexSpan GetCollisionViewPointIndices(int collision_grid_ind) const
+  {
+    return IndexSpan(collision_viewpoint_indices_.data() + collision_cell_offsets_[collision_grid_ind],
+                     collision_viewpoint_indices_.data() + collision_cell_offsets_[collision_grid_ind + 1]);
+  }
 
   bool initialized_;
   ViewPointManagerParameter vp_;
   std::unique_ptr<rolling_grid_ns::RollingGrid> grid_;
-  std::vector<viewpoint_ns::ViewPoint> viewpoints_;
+  viewpoint_ns::ViewPointStore viewpoints_;
+  terrain_height_map_ns::TerrainHeightMap::Ptr terrain_height_map_;
   std::vector<std::vector<int>> connected_neighbor_indices_;
   std::vector<std::vector<double>> connected_neighbor_dist_;
   std::vector<std::vector<int>> in_range_neighbor_indices_;
   std::vector<int> updated_viewpoint_indices_;
+  // Viewpoint ind -> graph node, -1 if the viewpoint is not in the candidate graph
   std::vector<int> graph_index_map_;
+  // Graph node -> viewpoint ind, -1 for a free node slot
+  std::vector<int> candidate_graph_viewpoint_indices_;
+  std::vector<int> candidate_graph_free_nodes_;
+  int candidate_graph_version_;
   Eigen::Vector3d robot_position_;
   Eigen::Vector3d origin_;
   Eigen::Vector3d collision_grid_origin_;
   Eigen::Vector3d local_planning_horizon_size_;
-  std::unique_ptr<grid_ns::Grid<std::vector<int>>> collision_grid_;
+  std::unique_ptr<grid_ns::Grid<int>> collision_grid_;
   std::vector<int> collision_point_count_;
+  // Viewpoints (logical indices) to invalidate for each collision grid cell, stored in CSR form:
+  // the viewpoints of cell i are collision_viewpoint_indices_[collision_cell_offsets_[i], collision_cell_offsets_[i+1])
+  std::vector<int> collision_cell_offsets_;
+  std::vector<int> collision_viewpoint_indices_;
+  // Boundary cells of the viewpoint grid that line of sight rays are cast to
+  std::vector<Eigen::Vector3i> boundary_viewpoint_subs_;
+  // Connected component labelling of traversable viewpoints, indexed by array ind. Labels are merged with a
+  // union-find over connectivity_label_parent_ and only the components touched by changed viewpoints are relabelled.
+  bool connectivity_initialized_;
+  std::vector<int> connectivity_label_;
+  std::vector<int> connectivity_label_parent_;
+  std::vector<bool> connectivity_traversable_;
+  std::vector<double> connectivity_height_;
+  std::vector<int> connectivity_dirty_array_indices_;
+  // Rays only depend on end_sub - start_sub, cached as index offsets relative to the start cell
+  std::unordered_map<int, std::vector<int>> line_of_sight_ray_templates_;
   std::vector<std::vector<int>> candidate_viewpoint_graph_;
   std::vector<std::vector<double>> candidate_viewpoint_dist_;
   std::vector<geometry_msgs::Point> candidate_viewpoint_position_;
-  pcl::KdTreeFLANN<pcl::PointXYZI>::Ptr kdtree_viewpoint_candidate_;
   pcl::KdTreeFLANN<pcl::PointXYZI>::Ptr kdtree_viewpoint_in_collision_;
-  pcl::PointCloud<pcl::PointXYZI>::Ptr viewpoint_candidate_cloud_;
   pcl::PointCloud<pcl::PointXYZI>::Ptr viewpoint_in_collision_cloud_;
 
   geometry_msgs::Polygon viewpoint_boundary_;
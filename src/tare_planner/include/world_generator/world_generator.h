@@ -0,0 +1,315 @@
+/**
+ * @file world_generator.h
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Procedural synthetic worlds and a simulated robot that feeds the planner with scans, terrain maps and
+ * odometry
+ * @version 0.1
+ * @date 2021-06-16
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <Eigen/Core>
+// ROS
+#include <geometry_msgs/PointStamped.h>
+#include <nav_msgs/Odometry.h>
+#include <ros/ros.h>
+#include <rosgraph_msgs/Clock.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <std_msgs/Float32MultiArray.h>
+#include <std_msgs/Header.h>
+// PCL
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl_conversions/pcl_conversions.h>
+
+#include <lidar_model/lidar_model.h>
+#include <utils/misc_utils.h>
+
+namespace world_generator_ns
+{
+enum class WorldType
+{
+  CORRIDOR = 0,
+  ROOMS = 1,
+  FOREST = 2,
+  GARAGE = 3,
+  TUNNEL = 4
+};
+
+struct Box
+{
+  Eigen::Vector3d min;
+  Eigen::Vector3d max;
+};
+
+// Vertical cylinder
+struct Cylinder
+{
+  Eigen::Vector2d center;
+  double radius;
+  double z_min;
+  double z_max;
+};
+
+struct WorldGeneratorParameters
+{
+  std::string kWorldType;
+  // Side length of the square world
+  double kWorldSize;
+  // Amount of clutter in [0, 1]
+  double kClutterDensity;
+  int kSeed;
+  // Cell size of corridors, rooms and tunnels
+  double kCellSize;
+  double kWallHeight;
+  double kWallThickness;
+  // Ratio of extra openings that turn the maze into a graph with loops
+  double kLoopRatio;
+  // Ratio of maze cells that are open in the tunnel world
+  double kTunnelFillRatio;
+  int kLevelNum;
+  double kLevelHeight;
+
+  bool ReadParameters(ros::NodeHandle& nh);
+};
+
+/**
+ * @brief A static world made of axis-aligned boxes and vertical cylinders.
+ * Primitives are bucketed into a 2D grid, rays are traversed through the grid with a DDA.
+ */
+class SyntheticWorld
+{
+public:
+  explicit SyntheticWorld(double index_cell_size = 2.0);
+  ~SyntheticWorld() = default;
+  void Clear();
+  void AddBox(const Eigen::Vector3d& min, const Eigen::Vector3d& max);
+  void AddCylinder(const Eigen::Vector2d& center, double radius, double z_min, double z_max);
+  // Must be called after the primitives are added and before any query
+  void BuildIndex();
+  // Distance along a unit direction to the first surface, false if nothing is hit within max_range
+  bool RayCast(const Eigen::Vector3d& origin, const Eigen::Vector3d& direction, double max_range,
+               double& hit_dist) const;
+  // Whether a sphere overlaps any primitive
+  bool InCollision(const Eigen::Vector3d& position, double radius) const;
+  // Height of the first surface below the query point, false if there is none
+  bool GetGroundHeight(const Eigen::Vector3d& position, double& ground_height) const;
+  // Sample the surfaces of the world, for visualization and offline use
+  void GetPointCloud(pcl::PointCloud<pcl::PointXYZI>::Ptr& cloud, double resolution) const;
+  int GetBoxNum() const
+  {
+    return boxes_.size();
+  }
+  int GetCylinderNum() const
+  {
+    return cylinders_.size();
+  }
+
+private:
+  bool GetIndexCellSub(double x, double y, int& x_sub, int& y_sub) const;
+  bool IntersectPrimitive(int primitive_ind, const Eigen::Vector3d& origin, const Eigen::Vector3d& direction,
+                          double& hit_dist) const;
+  bool RayCastBruteForce(const Eigen::Vector3d& origin, const Eigen::Vector3d& direction, double max_range,
+                         double& hit_dist) const;
+
+  double index_cell_size_;
+  Eigen::Vector2d index_origin_;
+  Eigen::Vector2i index_size_;
+  std::vector<Box> boxes_;
+  std::vector<Cylinder> cylinders_;
+  // Primitive indices in each index cell, boxes first, then cylinders offset by the box number
+  std::vector<std::vector<int>> index_cells_;
+};
+
+class WorldGenerator
+{
+public:
+  explicit WorldGenerator(const WorldGeneratorParameters& wp);
+  ~WorldGenerator() = default;
+  // Returns false if the world type is unknown
+  bool Generate(SyntheticWorld& world, Eigen::Vector3d& start_position);
+  static bool GetWorldType(const std::string& world_type_str, WorldType& world_type);
+
+private:
+  struct MazeCell
+  {
+    bool open = false;
+    // Passage to the +x and +y neighbors
+    bool passage_x = false;
+    bool passage_y = false;
+  };
+
+  void GenerateMaze(int cell_num, double fill_ratio, double loop_ratio, std::vector<MazeCell>& maze);
+  void AddMazeWalls(SyntheticWorld& world, int cell_num, const std::vector<MazeCell>& maze, double door_width);
+  void AddGround(SyntheticWorld& world, double z);
+  void AddBoundaryWalls(SyntheticWorld& world, double z_min, double z_max);
+  void GenerateCorridor(SyntheticWorld& world);
+  void GenerateRooms(SyntheticWorld& world);
+  void GenerateForest(SyntheticWorld& world);
+  void GenerateGarage(SyntheticWorld& world);
+  void GenerateTunnel(SyntheticWorld& world);
+  double Uniform(double min, double max)
+  {
+    return std::uniform_real_distribution<double>(min, max)(rng_);
+  }
+
+  WorldGeneratorParameters wp_;
+  std::mt19937 rng_;
+};
+
+/**
+ * @brief Casts the beams of a spinning LiDAR, using the field of view and resolution of lidar_model_ns::LiDARModel
+ */
+class ScanSimulator
+{
+public:
+  explicit ScanSimulator(lidar_model_ns::LiDARModelType lidar_model_type = lidar_model_ns::LiDARModelType::VLP16,
+                         int horizontal_subdivision = 4, int vertical_subdivision = 1, double max_range = 25.0);
+  ~ScanSimulator() = default;
+  void Scan(const SyntheticWorld& world, const Eigen::Vector3d& sensor_position, double yaw,
+            pcl::PointCloud<pcl::PointXYZ>::Ptr& scan) const;
+  double GetMaxRange() const
+  {
+    return max_range_;
+  }
+  const std::vector<Eigen::Vector3d>& GetRayDirections() const
+  {
+    return ray_directions_;
+  }
+
+private:
+  double max_range_;
+  // Unit directions in the sensor frame
+  std::vector<Eigen::Vector3d> ray_directions_;
+};
+
+struct SimulatorParameters
+{
+  std::string pub_registered_scan_topic_;
+  std::string pub_terrain_map_topic_;
+  std::string pub_terrain_map_ext_topic_;
+  std::string pub_state_estimation_topic_;
+  std::string sub_waypoint_topic_;
+  std::string sub_planning_cycle_topic_;
+  std::string kWorldCloudFile;
+
+  // Sensor whose scan pattern is simulated, same names as the planner's kLiDARModel
+  lidar_model_ns::LiDARModelType kLiDARModelType;
+
+  bool kPublishClock;
+  // Hold the simulation whenever the planner is due to run until it reports the end of its cycle
+  bool kLockstep;
+
+  int kScanHorizontalSubdivision;
+  int kScanVerticalSubdivision;
+  // Number of simulation steps between two terrain_map_ext messages
+  int kTerrainMapExtInterval;
+  // Number of simulation steps between two statistics printouts
+  int kStatsInterval;
+
+  double kSimStep;
+  // Simulated time per wall-clock time, applies when not running in lockstep with the planner
+  double kRealTimeFactor;
+  // Period of the planner's execution timer in simulated time
+  double kPlanningPeriod;
+  // Wall-clock seconds to wait for a planning cycle before free running until the next one arrives
+  double kLockstepTimeout;
+  double kSensorRange;
+  double kSensorHeight;
+  double kRobotSpeed;
+  double kRobotRadius;
+  double kMaxStepHeight;
+  double kTerrainMapRadius;
+  double kTerrainMapExtRadius;
+  double kTerrainMapResolution;
+  double kTerrainMapExtResolution;
+  double kExploredVoxelSize;
+
+  bool ReadParameters(ros::NodeHandle& nh);
+};
+
+/**
+ * @brief Moves a robot towards the planner's waypoints in a synthetic world and publishes the registered scan, terrain
+ * maps and state estimation the planner subscribes to. Run the planner with use_sim_time to go faster than real time.
+ */
+class SyntheticWorldSimulator
+{
+public:
+  explicit SyntheticWorldSimulator(ros::NodeHandle& nh, ros::NodeHandle& nh_p);
+  ~SyntheticWorldSimulator() = default;
+  bool initialize(ros::NodeHandle& nh, ros::NodeHandle& nh_p);
+  // Advance the simulation by one step
+  void Step();
+  /**
+   * @brief Block until the planner has finished the cycle due at the current simulated time
+   *
+   * @return true if the simulation runs in lockstep with the planner and need not be paced by the wall clock
+   */
+  bool WaitForPlanningCycle();
+  double GetSimStep() const
+  {
+    return sp_.kSimStep;
+  }
+  double GetRealTimeFactor() const
+  {
+    return sp_.kRealTimeFactor;
+  }
+
+private:
+  static int64_t VoxelKey(const Eigen::Vector3d& point, double voxel_size);
+  void WaypointCallback(const geometry_msgs::PointStamped::ConstPtr& waypoint_msg);
+  void PlanningCycleCallback(const std_msgs::Header::ConstPtr& planning_cycle_msg);
+  void MoveRobot();
+  void UpdateExploredVoxels();
+  void GetTerrainMap(const pcl::PointCloud<pcl::PointXYZ>& cloud, double radius, double resolution,
+                     pcl::PointCloud<pcl::PointXYZI>::Ptr& terrain_map) const;
+  void PublishOdometry();
+  void PublishStats();
+
+  WorldGeneratorParameters wp_;
+  SimulatorParameters sp_;
+  bool initialized_;
+  SyntheticWorld world_;
+  std::unique_ptr<ScanSimulator> scan_simulator_;
+
+  ros::Time sim_time_;
+  int step_count_;
+  Eigen::Vector3d robot_position_;
+  double robot_yaw_;
+  double robot_speed_;
+  double traveled_distance_;
+  Eigen::Vector3d waypoint_;
+  bool waypoint_received_;
+  // Number of planning cycles received, and the expected time of the last one
+  int planning_cycle_count_;
+  ros::Time planning_cycle_stamp_;
+  bool lockstep_active_;
+
+  pcl::PointCloud<pcl::PointXYZ>::Ptr scan_;
+  // Downsampled map of all the scans, used for the extended terrain map
+  std::unordered_map<int64_t, pcl::PointXYZ> map_voxels_;
+  // Voxels swept by the beams
+  std::unordered_set<int64_t> explored_voxels_;
+
+  ros::Subscriber waypoint_sub_;
+  ros::Subscriber planning_cycle_sub_;
+  ros::Publisher registered_scan_pub_;
+  ros::Publisher terrain_map_pub_;
+  ros::Publisher terrain_map_ext_pub_;
+  ros::Publisher state_estimation_pub_;
+  ros::Publisher clock_pub_;
+  ros::Publisher world_cloud_pub_;
+  ros::Publisher stats_pub_;
+};
+}  // namespace world_generator_ns
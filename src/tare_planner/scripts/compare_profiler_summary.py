@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""Compare two profiler summaries exported by tare_planner against each other.
+
+Usage:
+  rostopic pub -1 /profiler_export std_msgs/String "data: '/tmp/baseline.json'"
+  ... change the code or the parameters, replay the same bag ...
+  rostopic pub -1 /profiler_export std_msgs/String "data: '/tmp/current.json'"
+  compare_profiler_summary.py /tmp/baseline_summary.json /tmp/current_summary.json --threshold 10
+
+The benchmark harness (catkin_make -DBUILD_BENCHMARKS=ON) writes its results in the same format:
+  tare_planner_benchmark --output /tmp/baseline_benchmark.json
+  compare_profiler_summary.py /tmp/baseline_benchmark.json /tmp/current_benchmark.json --percentile p50
+
+Exits with 1 if the chosen percentile of any zone got slower than the threshold (in percent).
+"""
+import argparse
+import json
+import sys
+
+
+def load_zones(file_path):
+    with open(file_path) as f:
+        summary = json.load(f)
+    return {zone["path"]: zone for zone in summary["zones"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline", help="baseline *_summary.json")
+    parser.add_argument("current", help="current *_summary.json")
+    parser.add_argument("--percentile", default="p95", choices=["p50", "p95", "p99", "max"],
+                        help="statistic used to flag regressions")
+    parser.add_argument("--threshold", type=float, default=10.0, help="regression threshold in percent")
+    parser.add_argument("--min-time", type=float, default=0.05,
+                        help="ignore zones faster than this in both runs (ms)")
+    args = parser.parse_args()
+
+    baseline = load_zones(args.baseline)
+    current = load_zones(args.current)
+
+    regressions = []
+    print("{:<60} {:>10} {:>10} {:>9}".format("zone", "base(ms)", "cur(ms)", "change"))
+    for path in sorted(set(baseline) | set(current)):
+        if path not in baseline or path not in current:
+            print("{:<60} {:>10} {:>10} {:>9}".format(path, "-" if path not in baseline else "",
+                                                      "-" if path not in current else "", "n/a"))
+            continue
+        base_time = baseline[path][args.percentile]
+        cur_time = current[path][args.percentile]
+        if base_time < args.min_time and cur_time < args.min_time:
+            continue
+        change = (cur_time - base_time) / base_time * 100.0 if base_time > 0 else float("inf")
+        flag = ""
+        if change > args.threshold:
+            flag = " <-- regression"
+            regressions.append(path)
+        print("{:<60} {:>10.3f} {:>10.3f} {:>8.1f}%{}".format(path, base_time, cur_time, change, flag))
+
+    if regressions:
+        print("\n{} zone(s) regressed by more than {}% on {}".format(len(regressions), args.threshold, args.percentile))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
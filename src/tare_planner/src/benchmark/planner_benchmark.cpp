@@ -0,0 +1,572 @@
+/**
+ * @file planner_benchmark.cpp
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Benchmarks of the planner kernels on generated inputs
+ * @version 0.1
+ * @date 2021-06-19
+ *
+ * @copyright Copyright (c) 2021
+ *
+ * Each case is timed over repeated iterations on inputs generated from a fixed seed, and the latencies are written in
+ * the format of Profiler::ExportSummary so that compare_profiler_summary.py checks a run against a baseline:
+ *   tare_planner_benchmark --output /tmp/baseline.json
+ *   ... change the code ...
+ *   tare_planner_benchmark --output /tmp/current.json
+ *   compare_profiler_summary.py /tmp/baseline.json /tmp/current.json --percentile p50
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+#include <geometry_msgs/Point.h>
+#include <pcl/point_types.h>
+
+#include "keypose_graph/keypose_graph.h"
+#include "lidar_model/lidar_model.h"
+#include "pointcloud_manager/pointcloud_manager.h"
+#include "rolling_grid/rolling_grid.h"
+#include "tsp_solver/tsp_solver.h"
+#include "utils/misc_utils.h"
+#include "utils/pointcloud_utils.h"
+#include "utils/profiler.h"
+
+namespace
+{
+// Results are accumulated here so that the compiler cannot drop the timed work
+volatile double benchmark_sink = 0;
+
+struct BenchmarkOptions
+{
+  std::string output_file = "tare_planner_benchmark.json";
+  std::string filter;
+  double min_time = 0.5;
+  int min_iterations = 10;
+};
+
+struct BenchmarkResult
+{
+  std::string name;
+  misc_utils_ns::LatencyHistogram histogram;
+};
+
+/**
+ * @brief Time one iteration after another until both min_time and min_iterations are reached
+ *
+ * @param name benchmark name, "kernel/parameter"
+ * @param iteration runs the kernel once over the generated input
+ */
+void RunBenchmark(const std::string& name, const std::function<void()>& iteration, const BenchmarkOptions& options,
+                  std::vector<BenchmarkResult>& results)
+{
+  if (!options.filter.empty() && name.find(options.filter) == std::string::npos)
+  {
+    return;
+  }
+  // Warm up the caches and any lazily built state
+  iteration();
+
+  BenchmarkResult result;
+  result.name = name;
+  auto start_time = std::chrono::steady_clock::now();
+  double elapsed_time = 0;
+  while (elapsed_time < options.min_time || result.histogram.GetCount() < options.min_iterations)
+  {
+    auto iteration_start = std::chrono::steady_clock::now();
+    iteration();
+    auto iteration_end = std::chrono::steady_clock::now();
+    result.histogram.Record(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(iteration_end - iteration_start).count());
+    elapsed_time = std::chrono::duration<double>(iteration_end - start_time).count();
+  }
+  std::cout << std::left << std::setw(60) << name << std::right << std::fixed << std::setprecision(3)
+            << std::setw(10) << result.histogram.GetPercentile(50) / 1e6 << " ms (p50) " << std::setw(10)
+            << result.histogram.GetPercentile(95) / 1e6 << " ms (p95) " << result.histogram.GetCount()
+            << " iterations" << std::endl;
+  results.push_back(std::move(result));
+}
+
+std::vector<pcl::PointXYZI> GeneratePoints(int point_num, double range, std::mt19937& generator)
+{
+  std::uniform_real_distribution<double> xy_distribution(-range, range);
+  std::uniform_real_distribution<double> z_distribution(-range / 5, range / 5);
+  std::vector<pcl::PointXYZI> points(point_num);
+  for (auto& point : points)
+  {
+    point.x = xy_distribution(generator);
+    point.y = xy_distribution(generator);
+    point.z = z_distribution(generator);
+    point.intensity = 0;
+  }
+  return points;
+}
+
+template <class SensorModelType>
+void BenchmarkUpdateCoverage(const std::string& sensor_name, const BenchmarkOptions& options,
+                             std::vector<BenchmarkResult>& results)
+{
+  for (int point_num : { 1000, 10000, 100000 })
+  {
+    std::mt19937 generator(point_num);
+    std::vector<pcl::PointXYZI> points = GeneratePoints(point_num, 20.0, generator);
+    SensorModelType lidar_model;
+    RunBenchmark("lidar model update coverage/" + sensor_name + "/" + std::to_string(point_num) + " points",
+                 [&]() {
+                   lidar_model.ResetCoverage();
+                   for (const auto& point : points)
+                   {
+                     lidar_model.template UpdateCoverage<pcl::PointXYZI>(point);
+                   }
+                   benchmark_sink =
+                       benchmark_sink + lidar_model.template CheckVisibility<pcl::PointXYZI>(points[0], 1.0);
+                 },
+                 options, results);
+  }
+}
+
+void BenchmarkRayCast(const BenchmarkOptions& options, std::vector<BenchmarkResult>& results)
+{
+  const int kRayNum = 1000;
+  for (int grid_size : { 50, 100, 200 })
+  {
+    std::mt19937 generator(grid_size);
+    std::uniform_int_distribution<int> sub_distribution(0, grid_size - 1);
+    Eigen::Vector3i max_sub(grid_size - 1, grid_size - 1, grid_size / 5 - 1);
+    Eigen::Vector3i min_sub(0, 0, 0);
+    Eigen::Vector3i start_sub(grid_size / 2, grid_size / 2, grid_size / 10);
+    std::vector<Eigen::Vector3i> end_subs(kRayNum);
+    for (auto& end_sub : end_subs)
+    {
+      end_sub = Eigen::Vector3i(sub_distribution(generator), sub_distribution(generator),
+                                sub_distribution(generator) % (grid_size / 5));
+    }
+    std::vector<Eigen::Vector3i> ray_cast_cells;
+    RunBenchmark("ray cast/" + std::to_string(grid_size) + "x" + std::to_string(grid_size) + "x" +
+                     std::to_string(grid_size / 5) + " grid",
+                 [&]() {
+                   int cell_num = 0;
+                   for (const auto& end_sub : end_subs)
+                   {
+                     misc_utils_ns::RayCast(start_sub, end_sub, max_sub, min_sub, ray_cast_cells);
+                     cell_num += ray_cast_cells.size();
+                   }
+                   benchmark_sink = benchmark_sink + cell_num;
+                 },
+                 options, results);
+  }
+}
+
+void BenchmarkInFOVSimple(const BenchmarkOptions& options, std::vector<BenchmarkResult>& results)
+{
+  // Same constants as the viewpoint manager with the default parameters
+  lidar_model_ns::LiDARScanPattern scan_pattern = lidar_model_ns::GetScanPattern<lidar_model_ns::LiDARModel>();
+  const double kUpperFOVRatio = tan(scan_pattern.GetUpperVerticalAngle() * M_PI / 180);
+  const double kLowerFOVRatio = tan(-scan_pattern.GetLowerVerticalAngle() * M_PI / 180);
+  const double kSensorRange = 10.0;
+  const double kInFovXYDistThreshold = 3 * (1.0 / 2) / std::min(kUpperFOVRatio, kLowerFOVRatio);
+  const double kInFovZDiffThreshold = 3 * 1.0;
+  const int kViewPointNum = 100;
+  for (int point_num : { 1000, 10000, 50000 })
+  {
+    std::mt19937 generator(point_num);
+    std::vector<pcl::PointXYZI> points = GeneratePoints(point_num, 20.0, generator);
+    std::vector<pcl::PointXYZI> viewpoints = GeneratePoints(kViewPointNum, 10.0, generator);
+    RunBenchmark("in fov simple/" + std::to_string(point_num) + " points x " + std::to_string(kViewPointNum) +
+                     " viewpoints",
+                 [&]() {
+                   int in_fov_num = 0;
+                   for (const auto& point : points)
+                   {
+                     Eigen::Vector3d point_position(point.x, point.y, point.z);
+                     for (const auto& viewpoint : viewpoints)
+                     {
+                       if (misc_utils_ns::InFOVSimple(point_position,
+                                                      Eigen::Vector3d(viewpoint.x, viewpoint.y, viewpoint.z),
+                                                      kUpperFOVRatio, kLowerFOVRatio, kSensorRange,
+                                                      kInFovXYDistThreshold, kInFovZDiffThreshold))
+                       {
+                         in_fov_num++;
+                       }
+                     }
+                   }
+                   benchmark_sink = benchmark_sink + in_fov_num;
+                 },
+                 options, results);
+  }
+}
+
+void BenchmarkRollingGridRoll(const BenchmarkOptions& options, std::vector<BenchmarkResult>& results)
+{
+  // A rollover of a few cells, as when the robot moves into the next cell of a rolling grid
+  const Eigen::Vector3i kRollDir(4, -2, 0);
+  for (int grid_size : { 50, 100, 200 })
+  {
+    rolling_grid_ns::RollingGrid rolling_grid(Eigen::Vector3i(grid_size, grid_size, grid_size / 5));
+    std::vector<int> updated_indices;
+    RunBenchmark("rolling grid roll/" + std::to_string(grid_size) + "x" + std::to_string(grid_size) + "x" +
+                     std::to_string(grid_size / 5) + " grid",
+                 [&]() {
+                   rolling_grid.Roll(kRollDir);
+                   rolling_grid.GetUpdatedIndices(updated_indices);
+                   benchmark_sink = benchmark_sink + updated_indices.size();
+                 },
+                 options, results);
+  }
+}
+
+void BenchmarkPointCloudManagerUpdate(const BenchmarkOptions& options, std::vector<BenchmarkResult>& results)
+{
+  for (int point_num : { 1000, 10000, 100000 })
+  {
+    std::mt19937 generator(point_num);
+    std::vector<pcl::PointXYZI> points = GeneratePoints(point_num, 40.0, generator);
+    pcl::PointCloud<pcl::PointXYZI> cloud;
+    cloud.points.assign(points.begin(), points.end());
+    // Same grid as the planning environment with the default parameters
+    pointcloud_manager_ns::PointCloudManager pointcloud_manager(20, 20, 10, 100000, 24.0, 3.0, 5);
+    geometry_msgs::Point robot_position;
+    pointcloud_manager.UpdateRobotPosition(robot_position);
+    // The cells keep the downsized points of the previous iterations, as they do between planning cycles
+    RunBenchmark("pointcloud manager update pointcloud/" + std::to_string(point_num) + " points",
+                 [&]() {
+                   pointcloud_manager.UpdatePointCloud<pcl::PointXYZI>(cloud);
+                   benchmark_sink = benchmark_sink + pointcloud_manager.GetAllPointNum();
+                 },
+                 options, results);
+  }
+}
+
+/**
+ * @brief Generate ground points mixed with points on walls every few meters, so that both kinds of surfaces are
+ * found by the vertical surface extractors
+ */
+pcl::PointCloud<pcl::PointXYZI>::Ptr GenerateSurfacePoints(int point_num, double range, std::mt19937& generator)
+{
+  const double kWallSpacing = 4.0;
+  const double kWallHeight = 2.0;
+  std::uniform_real_distribution<double> xy_distribution(-range, range);
+  std::uniform_real_distribution<double> ground_z_distribution(-0.05, 0.05);
+  std::uniform_real_distribution<double> wall_z_distribution(0, kWallHeight);
+  std::bernoulli_distribution on_wall_distribution(0.5);
+  pcl::PointCloud<pcl::PointXYZI>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZI>);
+  cloud->points.resize(point_num);
+  for (auto& point : cloud->points)
+  {
+    point.x = xy_distribution(generator);
+    point.y = xy_distribution(generator);
+    if (on_wall_distribution(generator))
+    {
+      point.y = std::round(point.y / kWallSpacing) * kWallSpacing;
+      point.z = wall_z_distribution(generator);
+    }
+    else
+    {
+      point.z = ground_z_distribution(generator);
+    }
+    point.intensity = 0;
+  }
+  return cloud;
+}
+
+void BenchmarkVerticalSurfaceExtractor(const BenchmarkOptions& options, std::vector<BenchmarkResult>& results)
+{
+  // Same thresholds as the planning environment with the default parameters
+  const double kRadiusThreshold = 0.2;
+  const double kZDiffMax = 2.0;
+  const double kZDiffMin = 0.2;
+  pointcloud_utils_ns::VerticalSurfaceExtractor vertical_surface_extractor;
+  vertical_surface_extractor.SetRadiusThreshold(kRadiusThreshold);
+  vertical_surface_extractor.SetZDiffMax(kZDiffMax);
+  vertical_surface_extractor.SetZDiffMin(kZDiffMin);
+  pointcloud_utils_ns::ColumnVerticalSurfaceExtractor column_vertical_surface_extractor;
+  column_vertical_surface_extractor.SetRadiusThreshold(kRadiusThreshold);
+  column_vertical_surface_extractor.SetZDiffMax(kZDiffMax);
+  column_vertical_surface_extractor.SetZDiffMin(kZDiffMin);
+  for (int point_num : { 1000, 10000, 100000 })
+  {
+    std::mt19937 generator(point_num);
+    pcl::PointCloud<pcl::PointXYZI>::Ptr cloud = GenerateSurfacePoints(point_num, 20.0, generator);
+    pcl::PointCloud<pcl::PointXYZI>::Ptr vertical_surface_cloud(new pcl::PointCloud<pcl::PointXYZI>);
+    RunBenchmark("vertical surface extractor/kdtree/" + std::to_string(point_num) + " points",
+                 [&]() {
+                   vertical_surface_extractor.ExtractVerticalSurface<pcl::PointXYZI, pcl::PointXYZI>(
+                       cloud, vertical_surface_cloud);
+                   benchmark_sink = benchmark_sink + vertical_surface_cloud->points.size();
+                 },
+                 options, results);
+    RunBenchmark("vertical surface extractor/column/" + std::to_string(point_num) + " points",
+                 [&]() {
+                   column_vertical_surface_extractor.ExtractVerticalSurface<pcl::PointXYZI, pcl::PointXYZI>(
+                       cloud, vertical_surface_cloud);
+                   benchmark_sink = benchmark_sink + vertical_surface_cloud->points.size();
+                 },
+                 options, results);
+  }
+}
+
+/**
+ * @brief Generate a connected graph of jittered lattice nodes linked to their 8 neighbors, the way the viewpoint
+ * manager connects candidate viewpoints
+ */
+void GenerateGraph(int side_length, std::mt19937& generator, std::vector<std::vector<int>>& graph,
+                   std::vector<std::vector<double>>& node_dist, std::vector<geometry_msgs::Point>& node_positions)
+{
+  const double kSpacing = 1.0;
+  std::uniform_real_distribution<double> jitter_distribution(-0.2, 0.2);
+  int node_num = side_length * side_length;
+  graph.assign(node_num, std::vector<int>());
+  node_dist.assign(node_num, std::vector<double>());
+  node_positions.resize(node_num);
+  for (int i = 0; i < node_num; i++)
+  {
+    node_positions[i].x = (i % side_length) * kSpacing + jitter_distribution(generator);
+    node_positions[i].y = (i / side_length) * kSpacing + jitter_distribution(generator);
+    node_positions[i].z = 0;
+  }
+  for (int i = 0; i < node_num; i++)
+  {
+    int x = i % side_length;
+    int y = i / side_length;
+    for (int dx = -1; dx <= 1; dx++)
+    {
+      for (int dy = -1; dy <= 1; dy++)
+      {
+        int neighbor_x = x + dx;
+        int neighbor_y = y + dy;
+        if ((dx == 0 && dy == 0) || neighbor_x < 0 || neighbor_x >= side_length || neighbor_y < 0 ||
+            neighbor_y >= side_length)
+        {
+          continue;
+        }
+        int neighbor_ind = neighbor_y * side_length + neighbor_x;
+        graph[i].push_back(neighbor_ind);
+        node_dist[i].push_back(misc_utils_ns::PointXYZDist<geometry_msgs::Point, geometry_msgs::Point>(
+            node_positions[i], node_positions[neighbor_ind]));
+      }
+    }
+  }
+}
+
+void BenchmarkAStarSearch(const BenchmarkOptions& options, std::vector<BenchmarkResult>& results)
+{
+  const int kQueryNum = 20;
+  for (int side_length : { 10, 32, 71 })
+  {
+    std::mt19937 generator(side_length);
+    std::vector<std::vector<int>> graph;
+    std::vector<std::vector<double>> node_dist;
+    std::vector<geometry_msgs::Point> node_positions;
+    GenerateGraph(side_length, generator, graph, node_dist, node_positions);
+    std::uniform_int_distribution<int> node_distribution(0, graph.size() - 1);
+    std::vector<std::pair<int, int>> queries(kQueryNum);
+    for (auto& query : queries)
+    {
+      query = std::make_pair(node_distribution(generator), node_distribution(generator));
+    }
+    std::vector<int> path_indices;
+    std::string graph_size = std::to_string(graph.size()) + " nodes";
+    RunBenchmark("astar search/" + graph_size,
+                 [&]() {
+                   double path_length = 0;
+                   for (const auto& query : queries)
+                   {
+                     path_length += misc_utils_ns::AStarSearch(graph, node_dist, node_positions, query.first,
+                                                               query.second, true, path_indices);
+                   }
+                   benchmark_sink = benchmark_sink + path_length;
+                 },
+                 options, results);
+    RunBenchmark("astar search with max path length/" + graph_size,
+                 [&]() {
+                   double path_length = 0;
+                   for (const auto& query : queries)
+                   {
+                     double shortest_dist = 0;
+                     misc_utils_ns::AStarSearchWithMaxPathLength(graph, node_dist, node_positions, query.first,
+                                                                 query.second, true, path_indices, shortest_dist,
+                                                                 side_length * 2.0);
+                     path_length += shortest_dist;
+                   }
+                   benchmark_sink = benchmark_sink + path_length;
+                 },
+                 options, results);
+  }
+}
+
+// KeyposeGraph::AddKeyposeNode is not covered: its edge collision checks need a PlanningEnv, which can only be
+// constructed from the node handles of a running ROS master
+void BenchmarkKeyposeGraphShortestPath(const BenchmarkOptions& options, std::vector<BenchmarkResult>& results)
+{
+  const int kQueryNum = 20;
+  for (int side_length : { 10, 32, 71 })
+  {
+    std::mt19937 generator(side_length);
+    std::vector<std::vector<int>> graph;
+    std::vector<std::vector<double>> node_dist;
+    std::vector<geometry_msgs::Point> node_positions;
+    GenerateGraph(side_length, generator, graph, node_dist, node_positions);
+    keypose_graph_ns::KeyposeGraph keypose_graph;
+    for (int i = 0; i < node_positions.size(); i++)
+    {
+      keypose_graph.AddNode(node_positions[i], i, i, true);
+    }
+    for (int i = 0; i < graph.size(); i++)
+    {
+      for (int j = 0; j < graph[i].size(); j++)
+      {
+        // AddEdge connects both directions
+        if (graph[i][j] > i)
+        {
+          keypose_graph.AddEdge(i, graph[i][j], node_dist[i][j]);
+        }
+      }
+    }
+    std::uniform_real_distribution<double> position_distribution(0, side_length - 1);
+    std::vector<std::pair<geometry_msgs::Point, geometry_msgs::Point>> queries(kQueryNum);
+    for (auto& query : queries)
+    {
+      query.first.x = position_distribution(generator);
+      query.first.y = position_distribution(generator);
+      query.second.x = position_distribution(generator);
+      query.second.y = position_distribution(generator);
+    }
+    nav_msgs::Path path;
+    RunBenchmark("keypose graph get shortest path/" + std::to_string(node_positions.size()) + " nodes",
+                 [&]() {
+                   double path_length = 0;
+                   for (const auto& query : queries)
+                   {
+                     path_length += keypose_graph.GetShortestPath(query.first, query.second, true, path);
+                   }
+                   benchmark_sink = benchmark_sink + path_length;
+                 },
+                 options, results);
+  }
+}
+
+void BenchmarkTSP(const BenchmarkOptions& options, std::vector<BenchmarkResult>& results)
+{
+  for (int node_num : { 10, 30, 60 })
+  {
+    std::mt19937 generator(node_num);
+    std::uniform_real_distribution<double> position_distribution(0, 100.0);
+    std::vector<Eigen::Vector2d> positions(node_num);
+    for (auto& position : positions)
+    {
+      position = Eigen::Vector2d(position_distribution(generator), position_distribution(generator));
+    }
+    tsp_solver_ns::DataModel data_model;
+    data_model.distance_matrix.assign(node_num, std::vector<int>(node_num, 0));
+    for (int i = 0; i < node_num; i++)
+    {
+      for (int j = 0; j < node_num; j++)
+      {
+        // Decimeters, as in the planner
+        data_model.distance_matrix[i][j] = static_cast<int>(10 * (positions[i] - positions[j]).norm());
+      }
+    }
+    RunBenchmark("tsp/" + std::to_string(node_num) + " nodes",
+                 [&]() {
+                   tsp_solver_ns::TSPSolver tsp_solver(data_model);
+                   tsp_solver.Solve();
+                   benchmark_sink = benchmark_sink + tsp_solver.getPathLength();
+                 },
+                 options, results);
+  }
+}
+
+bool ExportResults(const std::vector<BenchmarkResult>& results, const std::string& file_path)
+{
+  std::ofstream file(file_path);
+  if (!file.is_open())
+  {
+    std::cout << "Benchmark: cannot open " << file_path << std::endl;
+    return false;
+  }
+  file << "{\"unit\":\"ms\",\"dropped_events\":0,\"zones\":[";
+  file << std::fixed << std::setprecision(6);
+  for (int i = 0; i < results.size(); i++)
+  {
+    const misc_utils_ns::LatencyHistogram& histogram = results[i].histogram;
+    if (i > 0)
+    {
+      file << ",";
+    }
+    file << "\n{\"path\":\"" << results[i].name << "\",\"count\":" << histogram.GetCount()
+         << ",\"p50\":" << histogram.GetPercentile(50) / 1e6 << ",\"p95\":" << histogram.GetPercentile(95) / 1e6
+         << ",\"p99\":" << histogram.GetPercentile(99) / 1e6 << ",\"max\":" << histogram.GetMax() / 1e6 << "}";
+  }
+  file << "\n]}" << std::endl;
+  return file.good();
+}
+
+void PrintUsage(const char* program_name)
+{
+  std::cout << "Usage: " << program_name << " [--output file.json] [--filter substring] [--min-time seconds]"
+            << " [--min-iterations n]" << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  BenchmarkOptions options;
+  for (int i = 1; i < argc; i++)
+  {
+    bool has_value = i + 1 < argc;
+    if (std::strcmp(argv[i], "--output") == 0 && has_value)
+    {
+      options.output_file = argv[++i];
+    }
+    else if (std::strcmp(argv[i], "--filter") == 0 && has_value)
+    {
+      options.filter = argv[++i];
+    }
+    else if (std::strcmp(argv[i], "--min-time") == 0 && has_value)
+    {
+      options.min_time = std::atof(argv[++i]);
+    }
+    else if (std::strcmp(argv[i], "--min-iterations") == 0 && has_value)
+    {
+      options.min_iterations = std::atoi(argv[++i]);
+    }
+    else
+    {
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  // Keep the zones inside the kernels out of the measurements
+  misc_utils_ns::Profiler::GetInstance().SetEnabled(false);
+  lidar_model_ns::LiDARModelBase::setCloudDWZResol(1.0);
+
+  std::vector<BenchmarkResult> results;
+  BenchmarkUpdateCoverage<lidar_model_ns::LiDARModel>("vlp16", options, results);
+  BenchmarkUpdateCoverage<lidar_model_ns::Mid360LiDARModel>("mid360", options, results);
+  BenchmarkUpdateCoverage<lidar_model_ns::OS1LiDARModel>("os1_128", options, results);
+  BenchmarkRayCast(options, results);
+  BenchmarkInFOVSimple(options, results);
+  BenchmarkRollingGridRoll(options, results);
+  BenchmarkPointCloudManagerUpdate(options, results);
+  BenchmarkVerticalSurfaceExtractor(options, results);
+  BenchmarkAStarSearch(options, results);
+  BenchmarkKeyposeGraphShortestPath(options, results);
+  BenchmarkTSP(options, results);
+
+  if (!ExportResults(results, options.output_file))
+  {
+    return 1;
+  }
+  std::cout << "Wrote " << results.size() << " benchmarks to " << options.output_file << std::endl;
+  return 0;
+}
@@ -729,6 +729,7 @@ exploration_path_ns::ExplorationPath GridWorld::SolveGlobalTSP(
     const std::shared_ptr<viewpoint_manager_ns::ViewPointManager>& viewpoint_manager,
     std::vector<int>& ordered_cell_indices, const std::unique_ptr<keypose_graph_ns::KeyposeGraph>& keypose_graph)
 {
+  PROFILE_SCOPE("solve global tsp");
   /****** Get the node on keypose graph associated with the robot position *****/
   double min_dist_to_robot = DBL_MAX;
   geometry_msgs::Point global_path_robot_position = robot_position_;
@@ -894,6 +895,8 @@ exploration_path_ns::ExplorationPath GridWorld::SolveGlobalTSP(
   exploring_cell_indices.push_back(-1);
 
   /******* Construct the distance matrix *****/
+  // One zone for the whole matrix, the keypose graph shortest path below runs O(cells^2) times
+  misc_utils_ns::ProfileZone distance_matrix_zone(PROFILE_ZONE_ID("global tsp distance matrix"));
   std::vector<std::vector<int>> distance_matrix(exploring_cell_positions.size(),
                                                 std::vector<int>(exploring_cell_positions.size(), 0));
   for (int i = 0; i < exploring_cell_positions.size(); i++)
@@ -926,6 +929,8 @@ exploration_path_ns::ExplorationPath GridWorld::SolveGlobalTSP(
     }
   }
 
+  distance_matrix_zone.Stop();
+
   /****** Solve the TSP ******/
   tsp_solver_ns::DataModel data_model;
   data_model.distance_matrix = distance_matrix;
@@ -1268,4 +1273,29 @@ bool GridWorld::HasDirectKeyposeGraphConnection(const std::unique_ptr<keypose_gr
   return found_path;
 }
 
+void GridWorld::GetMemoryUsage(misc_utils_ns::MemoryReport& report) const
+{
+  const std::string kModule = "grid_world";
+  uint64_t cell_bytes = misc_utils_ns::GetVectorBytes(cells_) + subspaces_->GetMemoryBytes();
+  for (const auto& cell : cells_)
+  {
+    cell_bytes += cell.GetMemoryBytes();
+  }
+  for (int i = 0; i < subspaces_->GetCellNumber(); i++)
+  {
+    cell_bytes += subspaces_->GetCell(i).GetMemoryBytes();
+  }
+  report.Add(kModule, "cells", cell_bytes);
+  uint64_t path_bytes = misc_utils_ns::GetVectorBytes(to_connect_cell_indices_) +
+                        misc_utils_ns::GetVectorBytes(to_connect_cell_paths_);
+  for (const auto& path : to_connect_cell_paths_)
+  {
+    path_bytes += misc_utils_ns::GetVectorBytes(path.poses);
+  }
+  report.Add(kModule, "paths between cells", path_bytes);
+  report.Add(kModule, "cell indices",
+             misc_utils_ns::GetVectorBytes(neighbor_cell_indices_) +
+                 misc_utils_ns::GetVectorBytes(almost_covered_cell_indices_));
+}
+
 }  // namespace grid_world_ns
\ No newline at end of file
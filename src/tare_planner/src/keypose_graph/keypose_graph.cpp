@@ -481,6 +481,7 @@ void KeyposeGraph::CheckConnectivity(const geometry_msgs::Point& robot_position)
 
 int KeyposeGraph::AddKeyposeNode(const nav_msgs::Odometry& keypose, const planning_env_ns::PlanningEnv& planning_env)
 {
+  PROFILE_SCOPE("keypose graph add keypose node");
   current_keypose_position_ = keypose.pose.pose.position;
   current_keypose_id_ = static_cast<int>(keypose.pose.covariance[0]);
   int new_node_ind = nodes_.size();
@@ -989,4 +990,18 @@ geometry_msgs::Point KeyposeGraph::GetNodePosition(int node_ind)
   return node_position;
 }
 
+void KeyposeGraph::GetMemoryUsage(misc_utils_ns::MemoryReport& report) const
+{
+  const std::string kModule = "keypose_graph";
+  report.Add(kModule, "nodes",
+             misc_utils_ns::GetVectorBytes(nodes_) + misc_utils_ns::GetVectorBytes(node_positions_) +
+                 in_local_planning_horizon_.capacity() / 8 + misc_utils_ns::GetVectorBytes(connected_node_indices_));
+  report.Add(kModule, "edges",
+             misc_utils_ns::GetNestedVectorBytes(graph_) + misc_utils_ns::GetNestedVectorBytes(dist_));
+  report.Add(kModule, "kdtrees and clouds",
+             misc_utils_ns::GetKdTreeBytes(kdtree_connected_nodes_) + misc_utils_ns::GetKdTreeBytes(kdtree_nodes_) +
+                 misc_utils_ns::GetCloudPtrBytes(connected_nodes_cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(nodes_cloud_));
+}
+
 }  // namespace keypose_graph_ns
\ No newline at end of file
@@ -1,7 +1,7 @@
 /**
  * @file lidar_model.cpp
  * @author Chao Cao (ccao1@andrew.cmu.edu)
- * @brief Class that implements the sensor model of a LiDAR
+ * @brief Class template that implements the sensor model of a LiDAR, with instantiations for common sensors
  * @version 0.1
  * @date 2019-09-26
  *
@@ -13,88 +13,95 @@
 
 namespace lidar_model_ns
 {
-const double LiDARModel::kToDegreeConst = 57.2957;
-const double LiDARModel::kToRadianConst = 0.01745;
-const double LiDARModel::kEpsilon = 1e-4;
-const double LiDARModel::kCloudInflateRatio = 2;
-double LiDARModel::pointcloud_resolution_ = 0.2;
+const double LiDARModelBase::kToDegreeConst = 57.2957;
+const double LiDARModelBase::kToRadianConst = 0.01745;
+const double LiDARModelBase::kEpsilon = 1e-4;
+const double LiDARModelBase::kCloudInflateRatio = 2;
+const double LiDARModelBase::kDistanceResolution = 0.01;
+double LiDARModelBase::pointcloud_resolution_ = 0.2;
 
-int LiDARModel::sub2ind(int row_index, int column_index) const
+bool GetLiDARModelType(const std::string& name, LiDARModelType& type)
 {
-  return row_index * kHorizontalVoxelSize + column_index;
+  if (name == "vlp16")
+  {
+    type = LiDARModelType::VLP16;
+  }
+  else if (name == "mid360")
+  {
+    type = LiDARModelType::MID360;
+  }
+  else if (name == "os1_128")
+  {
+    type = LiDARModelType::OS1_128;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
 }
 
-void LiDARModel::ind2sub(int ind, int& row_index, int& column_index) const
+LiDARScanPattern GetScanPattern(LiDARModelType type)
 {
-  row_index = ind / kHorizontalVoxelSize;
-  column_index = ind % kHorizontalVoxelSize;
+  switch (type)
+  {
+    case LiDARModelType::MID360:
+      return GetScanPattern<Mid360LiDARModel>();
+    case LiDARModelType::OS1_128:
+      return GetScanPattern<OS1LiDARModel>();
+    case LiDARModelType::VLP16:
+    default:
+      return GetScanPattern<LiDARModel>();
+  }
 }
 
-LiDARModel::LiDARModel(double px, double py, double pz, double rw, double rx, double ry, double rz)
+LiDARModelArray::LiDARModelArray(LiDARModelType type, int size) : type_(type), size_(0)
 {
-  pose_.position.x = px;
-  pose_.position.y = py;
-  pose_.position.z = pz;
-  pose_.orientation.w = rw;
-  pose_.orientation.x = rx;
-  pose_.orientation.y = ry;
-  pose_.orientation.z = rz;
-  ResetCoverage();
+  Resize(type, size);
 }
 
-LiDARModel::LiDARModel(const geometry_msgs::Pose& pose)
-  : LiDARModel(pose.position.x, pose.position.y, pose.position.z, pose.orientation.w, pose.orientation.x,
-               pose.orientation.y, pose.orientation.z)
+void LiDARModelArray::Resize(LiDARModelType type, int size)
 {
+  type_ = type;
+  size_ = size;
+  vlp16_models_.clear();
+  mid360_models_.clear();
+  os1_models_.clear();
+  Visit([&](auto& models) { models.resize(size_); });
 }
 
-void LiDARModel::ResetCoverage()
+geometry_msgs::Point LiDARModelArray::GetPosition(int ind) const
 {
-  reset_.fill(true);
+  return Visit([&](const auto& models) { return models[ind].getPosition(); });
 }
 
-void LiDARModel::GetVisualizationCloud(pcl::PointCloud<pcl::PointXYZI>::Ptr& visualization_cloud, double resol,
-                                       double max_range) const
+void LiDARModelArray::SetPosition(int ind, const geometry_msgs::Point& position)
 {
-  visualization_cloud->clear();
-  geometry_msgs::Point start_point = pose_.position;
-  for (int i = 0; i < covered_voxel_.size(); i++)
-  {
-    int row_index, column_index;
-    ind2sub(i, row_index, column_index);
-    double phi = (column_index * kHorizontalResolution - 180) * M_PI / 180;
-    double theta = (row_index * kVerticalResolution - kVerticalAngleOffset) * M_PI / 180;
+  Visit([&](auto& models) { models[ind].setPosition(position); });
+}
 
-    double r = covered_voxel_[i];
-    if (isZero(covered_voxel_[i]) || reset_[i])
-    {
-      r = max_range;
-    }
-    geometry_msgs::Point end_point;
-    end_point.x = r * sin(theta) * cos(phi) + pose_.position.x;
-    end_point.y = r * sin(theta) * sin(phi) + pose_.position.y;
-    end_point.z = r * cos(theta) + pose_.position.z;
-    pcl::PointXYZI point;
-    point.x = end_point.x;
-    point.y = end_point.y;
-    point.z = end_point.z;
-    point.intensity = 0.0;
+void LiDARModelArray::SetHeight(int ind, double height)
+{
+  Visit([&](auto& models) { models[ind].SetHeight(height); });
+}
+
+void LiDARModelArray::ResetCoverage(int ind)
+{
+  Visit([&](auto& models) { models[ind].ResetCoverage(); });
+}
 
-    visualization_cloud->points.push_back(point);
-    pcl::PointCloud<pcl::PointXYZI>::Ptr tmp_cloud(new pcl::PointCloud<pcl::PointXYZI>());
-    misc_utils_ns::LinInterpPoints<pcl::PointXYZI>(start_point, end_point, resol, tmp_cloud);
-    for (auto& tmp_point : tmp_cloud->points)
+void LiDARModelArray::ResetCoverage()
+{
+  Visit([](auto& models) {
+    for (auto& model : models)
     {
-      if (isZero(covered_voxel_[i]) || reset_[i])
-      {
-        tmp_point.intensity = 0.0;
-      }
-      else
-      {
-        tmp_point.intensity = 10.0;
-      }
+      model.ResetCoverage();
     }
-    *visualization_cloud += *tmp_cloud;
-  }
+  });
+}
+
+uint64_t LiDARModelArray::GetMemoryBytes() const
+{
+  return Visit([](const auto& models) -> uint64_t { return models.capacity() * sizeof(models[0]); });
 }
 }  // namespace lidar_model_ns
@@ -79,29 +79,21 @@ void LocalCoveragePlanner::GetNavigationViewPointIndices(exploration_path_ns::Ex
   navigation_viewpoint_indices.push_back(lookahead_viewpoint_ind_);
 }
 
-void LocalCoveragePlanner::UpdateViewPointCoveredPoint(std::vector<bool>& point_list, int viewpoint_index,
-                                                       bool use_array_ind)
+void LocalCoveragePlanner::UpdateViewPointCoveredPoint(misc_utils_ns::DynamicBitset& covered_point_set,
+                                                       int viewpoint_index, bool use_array_ind)
 {
-  for (const auto& point_ind : viewpoint_manager_->GetViewPointCoveredPointList(viewpoint_index, use_array_ind))
-  {
-    MY_ASSERT(misc_utils_ns::InRange<bool>(point_list, point_ind));
-    point_list[point_ind] = true;
-  }
+  viewpoint_manager_->UpdateViewPointCoveredPoint(covered_point_set, viewpoint_index, use_array_ind);
 }
-void LocalCoveragePlanner::UpdateViewPointCoveredFrontierPoint(std::vector<bool>& frontier_point_list,
+void LocalCoveragePlanner::UpdateViewPointCoveredFrontierPoint(misc_utils_ns::DynamicBitset& covered_frontier_point_set,
                                                                int viewpoint_index, bool use_array_ind)
 {
-  for (const auto& point_ind : viewpoint_manager_->GetViewPointCoveredFrontierPointList(viewpoint_index, use_array_ind))
-  {
-    MY_ASSERT(misc_utils_ns::InRange<bool>(frontier_point_list, point_ind));
-    frontier_point_list[point_ind] = true;
-  }
+  viewpoint_manager_->UpdateViewPointCoveredFrontierPoint(covered_frontier_point_set, viewpoint_index, use_array_ind);
 }
 
 void LocalCoveragePlanner::EnqueueViewpointCandidates(std::vector<std::pair<int, int>>& cover_point_queue,
                                                       std::vector<std::pair<int, int>>& frontier_queue,
-                                                      const std::vector<bool>& covered_point_list,
-                                                      const std::vector<bool>& covered_frontier_point_list,
+                                                      const misc_utils_ns::DynamicBitset& covered_point_set,
+                                                      const misc_utils_ns::DynamicBitset& covered_frontier_point_set,
                                                       const std::vector<int>& selected_viewpoint_array_indices)
 {
   for (const auto& viewpoint_index : viewpoint_manager_->GetViewPointCandidateIndices())
@@ -118,7 +110,7 @@ void LocalCoveragePlanner::EnqueueViewpointCandidates(std::vector<std::pair<int,
       continue;
     }
     int covered_point_num =
-        viewpoint_manager_->GetViewPointCoveredPointNum(covered_point_list, viewpoint_array_index, true);
+        viewpoint_manager_->GetViewPointCoveredPointNum(covered_point_set, viewpoint_array_index, true);
     if (covered_point_num >= parameters_.kMinAddPointNum)
     {
       cover_point_queue.emplace_back(covered_point_num, viewpoint_index);
@@ -126,7 +118,7 @@ void LocalCoveragePlanner::EnqueueViewpointCandidates(std::vector<std::pair<int,
     else if (use_frontier_)
     {
       int covered_frontier_point_num = viewpoint_manager_->GetViewPointCoveredFrontierPointNum(
-          covered_frontier_point_list, viewpoint_array_index, true);
+          covered_frontier_point_set, viewpoint_array_index, true);
       if (covered_frontier_point_num >= parameters_.kMinAddFrontierPointNum)
       {
         frontier_queue.emplace_back(covered_frontier_point_num, viewpoint_index);
@@ -143,7 +135,7 @@ void LocalCoveragePlanner::EnqueueViewpointCandidates(std::vector<std::pair<int,
 }
 
 void LocalCoveragePlanner::SelectViewPoint(const std::vector<std::pair<int, int>>& queue,
-                                           const std::vector<bool>& covered,
+                                           const misc_utils_ns::DynamicBitset& covered,
                                            std::vector<int>& selected_viewpoint_indices, bool use_frontier)
 {
   if (use_frontier)
@@ -161,11 +153,7 @@ void LocalCoveragePlanner::SelectViewPoint(const std::vector<std::pair<int, int>
     }
   }
 
-  std::vector<bool> covered_copy;
-  for (int i = 0; i < covered.size(); i++)
-  {
-    covered_copy.push_back(covered[i]);
-  }
+  misc_utils_ns::DynamicBitset covered_copy = covered;
   std::vector<std::pair<int, int>> queue_copy;
   for (int i = 0; i < queue.size(); i++)
   {
@@ -203,26 +191,11 @@ void LocalCoveragePlanner::SelectViewPoint(const std::vector<std::pair<int, int>
     int cur_array_ind = viewpoint_manager_->GetViewPointArrayInd(cur_ind);
     if (use_frontier)
     {
-      for (const auto& point_ind : viewpoint_manager_->GetViewPointCoveredFrontierPointList(cur_array_ind, true))
-
-      {
-        MY_ASSERT(misc_utils_ns::InRange<bool>(covered_copy, point_ind));
-        if (!covered_copy[point_ind])
-        {
-          covered_copy[point_ind] = true;
-        }
-      }
+      UpdateViewPointCoveredFrontierPoint(covered_copy, cur_array_ind, true);
     }
     else
     {
-      for (const auto& point_ind : viewpoint_manager_->GetViewPointCoveredPointList(cur_array_ind, true))
-      {
-        MY_ASSERT(misc_utils_ns::InRange<bool>(covered_copy, point_ind));
-        if (!covered_copy[point_ind])
-        {
-          covered_copy[point_ind] = true;
-        }
-      }
+      UpdateViewPointCoveredPoint(covered_copy, cur_array_ind, true);
     }
     selected_viewpoint_indices.push_back(cur_ind);
     queue_copy.erase(queue_copy.begin() + queue_idx);
@@ -235,25 +208,11 @@ void LocalCoveragePlanner::SelectViewPoint(const std::vector<std::pair<int, int>
       int array_ind = viewpoint_manager_->GetViewPointArrayInd(ind);
       if (use_frontier)
       {
-        for (const auto& point_ind : viewpoint_manager_->GetViewPointCoveredFrontierPointList(array_ind, true))
-        {
-          MY_ASSERT(misc_utils_ns::InRange<bool>(covered_copy, point_ind));
-          if (!covered_copy[point_ind])
-          {
-            add_point_num++;
-          }
-        }
+        add_point_num = viewpoint_manager_->GetViewPointCoveredFrontierPointNum(covered_copy, array_ind, true);
       }
       else
       {
-        for (const auto& point_ind : viewpoint_manager_->GetViewPointCoveredPointList(array_ind, true))
-        {
-          MY_ASSERT(misc_utils_ns::InRange<bool>(covered_copy, point_ind));
-          if (!covered_copy[point_ind])
-          {
-            add_point_num++;
-          }
-        }
+        add_point_num = viewpoint_manager_->GetViewPointCoveredPointNum(covered_copy, array_ind, true);
       }
 
       queue_copy[i].first = add_point_num;
@@ -300,7 +259,7 @@ void LocalCoveragePlanner::SelectViewPoint(const std::vector<std::pair<int, int>
 }
 
 void LocalCoveragePlanner::SelectViewPointFromFrontierQueue(std::vector<std::pair<int, int>>& frontier_queue,
-                                                            std::vector<bool>& frontier_covered,
+                                                            misc_utils_ns::DynamicBitset& frontier_covered,
                                                             std::vector<int>& selected_viewpoint_indices)
 {
   if (use_frontier_ && !frontier_queue.empty() && frontier_queue[0].first > parameters_.kMinAddFrontierPointNum)
@@ -325,6 +284,7 @@ exploration_path_ns::ExplorationPath LocalCoveragePlanner::SolveTSP(const std::v
                                                                     std::vector<int>& ordered_viewpoint_indices)
 
 {
+  PROFILE_SCOPE("solve tsp");
   // nav_msgs::Path tsp_path;
   exploration_path_ns::ExplorationPath tsp_path;
 
@@ -378,6 +338,7 @@ exploration_path_ns::ExplorationPath LocalCoveragePlanner::SolveTSP(const std::v
   }
   misc_utils_ns::Timer find_path_timer("find path");
   find_path_timer.Start();
+  misc_utils_ns::ProfileZone find_path_zone(PROFILE_ZONE_ID("tsp distance matrix"));
   std::vector<std::vector<int>> distance_matrix(node_size, std::vector<int>(node_size, 0));
   std::vector<int> tmp;
   for (int i = 0; i < selected_viewpoint_indices.size(); i++)
@@ -472,11 +433,13 @@ exploration_path_ns::ExplorationPath LocalCoveragePlanner::SolveTSP(const std::v
     }
   }
 
+  find_path_zone.Stop();
   find_path_timer.Stop(false);
   find_path_runtime_ += find_path_timer.GetDuration(kRuntimeUnit);
 
   misc_utils_ns::Timer tsp_timer("tsp");
   tsp_timer.Start();
+  misc_utils_ns::ProfileZone tsp_zone(PROFILE_ZONE_ID("local tsp"));
 
   tsp_solver_ns::DataModel data;
   data.distance_matrix = distance_matrix;
@@ -517,6 +480,7 @@ exploration_path_ns::ExplorationPath LocalCoveragePlanner::SolveTSP(const std::v
     path_index.push_back(path_index[0]);
   }
 
+  tsp_zone.Stop();
   tsp_timer.Stop(false);
   tsp_runtime_ += tsp_timer.GetDuration(kRuntimeUnit);
 
@@ -628,6 +592,7 @@ exploration_path_ns::ExplorationPath LocalCoveragePlanner::SolveTSP(const std::v
 exploration_path_ns::ExplorationPath LocalCoveragePlanner::SolveLocalCoverageProblem(
     const exploration_path_ns::ExplorationPath& global_path, int uncovered_point_num, int uncovered_frontier_point_num)
 {
+  PROFILE_SCOPE("solve local coverage problem");
   exploration_path_ns::ExplorationPath local_path;
 
   find_path_runtime_ = 0;
@@ -638,19 +603,22 @@ exploration_path_ns::ExplorationPath LocalCoveragePlanner::SolveLocalCoveragePro
 
   misc_utils_ns::Timer find_path_timer("find path");
   find_path_timer.Start();
+  misc_utils_ns::ProfileZone find_path_zone(PROFILE_ZONE_ID("get navigation viewpoints"));
 
   std::vector<int> navigation_viewpoint_indices;
   GetNavigationViewPointIndices(global_path, navigation_viewpoint_indices);
 
+  find_path_zone.Stop();
   find_path_timer.Stop(false);
   find_path_runtime_ += find_path_timer.GetDuration(kRuntimeUnit);
 
   // Sampling viewpoints
   misc_utils_ns::Timer viewpoint_sampling_timer("viewpoint sampling");
   viewpoint_sampling_timer.Start();
+  misc_utils_ns::ProfileZone viewpoint_sampling_zone(PROFILE_ZONE_ID("viewpoint sampling"));
 
-  std::vector<bool> covered(uncovered_point_num, false);
-  std::vector<bool> frontier_covered(uncovered_frontier_point_num, false);
+  misc_utils_ns::DynamicBitset covered(uncovered_point_num);
+  misc_utils_ns::DynamicBitset frontier_covered(uncovered_frontier_point_num);
 
   std::vector<int> pre_selected_viewpoint_array_indices;
   std::vector<int> reused_viewpoint_indices;
@@ -704,6 +672,7 @@ exploration_path_ns::ExplorationPath LocalCoveragePlanner::SolveLocalCoveragePro
   std::vector<std::pair<int, int>> frontier_queue;
   EnqueueViewpointCandidates(queue, frontier_queue, covered, frontier_covered, pre_selected_viewpoint_array_indices);
 
+  viewpoint_sampling_zone.Stop();
   viewpoint_sampling_timer.Stop(false, kRuntimeUnit);
   viewpoint_sampling_runtime_ += viewpoint_sampling_timer.GetDuration(kRuntimeUnit);
 
@@ -718,6 +687,7 @@ exploration_path_ns::ExplorationPath LocalCoveragePlanner::SolveLocalCoveragePro
       // Select from the queue
       misc_utils_ns::Timer select_viewpoint_timer("select viewpoints");
       select_viewpoint_timer.Start();
+      misc_utils_ns::ProfileZone select_viewpoint_zone(PROFILE_ZONE_ID("select viewpoints"));
       SelectViewPoint(queue, covered, selected_viewpoint_indices_itr, false);
       SelectViewPointFromFrontierQueue(frontier_queue, frontier_covered, selected_viewpoint_indices_itr);
 
@@ -734,6 +704,7 @@ exploration_path_ns::ExplorationPath LocalCoveragePlanner::SolveLocalCoveragePro
 
       misc_utils_ns::UniquifyIntVector(selected_viewpoint_indices_itr);
 
+      select_viewpoint_zone.Stop();
       select_viewpoint_timer.Stop(false, kRuntimeUnit);
       viewpoint_sampling_runtime_ += select_viewpoint_timer.GetDuration(kRuntimeUnit);
 
@@ -755,6 +726,7 @@ exploration_path_ns::ExplorationPath LocalCoveragePlanner::SolveLocalCoveragePro
   {
     misc_utils_ns::Timer select_viewpoint_timer("viewpoint sampling");
     select_viewpoint_timer.Start();
+    misc_utils_ns::ProfileZone select_viewpoint_zone(PROFILE_ZONE_ID("select viewpoints"));
 
     // std::cout << "entering tsp routine" << std::endl;
     std::vector<int> selected_viewpoint_indices_itr;
@@ -779,6 +751,7 @@ exploration_path_ns::ExplorationPath LocalCoveragePlanner::SolveLocalCoveragePro
 
     misc_utils_ns::UniquifyIntVector(selected_viewpoint_indices_itr);
 
+    select_viewpoint_zone.Stop();
     select_viewpoint_timer.Stop(false, kRuntimeUnit);
     viewpoint_sampling_runtime_ += select_viewpoint_timer.GetDuration(kRuntimeUnit);
 
@@ -841,4 +814,11 @@ void LocalCoveragePlanner::GetSelectedViewPointVisCloud(pcl::PointCloud<pcl::Poi
   }
 }
 
+void LocalCoveragePlanner::GetMemoryUsage(misc_utils_ns::MemoryReport& report) const
+{
+  report.Add("local_coverage_planner", "selected viewpoints",
+             misc_utils_ns::GetVectorBytes(last_selected_viewpoint_indices_) +
+                 misc_utils_ns::GetVectorBytes(last_selected_viewpoint_array_indices_));
+}
+
 }  // namespace local_coverage_planner_ns
\ No newline at end of file
@@ -33,6 +33,8 @@ void PlanningEnvParameters::ReadParameters(ros::NodeHandle& nh)
   kPointCloudCellHeight = misc_utils_ns::getParam<double>(nh, "kPointCloudCellHeight", 3.0);
   kPointCloudManagerNeighborCellNum = misc_utils_ns::getParam<int>(nh, "kPointCloudManagerNeighborCellNum", 5);
   kCoverCloudZSqueezeRatio = misc_utils_ns::getParam<double>(nh, "kCoverCloudZSqueezeRatio", 2.0);
+  kUseVoxelHashCoverageDilation = misc_utils_ns::getParam<bool>(nh, "kUseVoxelHashCoverageDilation", true);
+  kUseColumnVerticalSurfaceExtractor = misc_utils_ns::getParam<bool>(nh, "kUseColumnVerticalSurfaceExtractor", true);
 
   kUseFrontier = misc_utils_ns::getParam<bool>(nh, "kUseFrontier", false);
   kFrontierClusterTolerance = misc_utils_ns::getParam<double>(nh, "kFrontierClusterTolerance", 1.0);
@@ -40,32 +42,32 @@ void PlanningEnvParameters::ReadParameters(ros::NodeHandle& nh)
   kExtractFrontierRange.x() = misc_utils_ns::getParam<double>(nh, "kExtractFrontierRangeX", 30);
   kExtractFrontierRange.y() = misc_utils_ns::getParam<double>(nh, "kExtractFrontierRangeY", 30);
   kExtractFrontierRange.z() = misc_utils_ns::getParam<double>(nh, "kExtractFrontierRangeZ", 3);
+  kRollingOccupancyGridCloudPublishRate =
+      misc_utils_ns::getParam<double>(nh, "kRollingOccupancyGridCloudPublishRate", 1.0);
 }
 
 PlanningEnv::PlanningEnv(ros::NodeHandle nh, ros::NodeHandle nh_private, std::string world_frame_id)
-  : keypose_cloud_count_(0)
-  , vertical_surface_extractor_()
+  : vertical_surface_extractor_()
   , vertical_frontier_extractor_()
   , robot_position_update_(false)
 {
   parameters_.ReadParameters(nh_private);
-  keypose_cloud_stack_.resize(parameters_.kKeyposeCloudStackNum);
-  for (int i = 0; i < keypose_cloud_stack_.size(); i++)
-  {
-    keypose_cloud_stack_[i].reset(new pcl::PointCloud<PlannerCloudPointType>());
-  }
-
-  vertical_surface_cloud_stack_.resize(parameters_.kKeyposeCloudStackNum);
-  for (int i = 0; i < vertical_surface_cloud_stack_.size(); i++)
-  {
-    vertical_surface_cloud_stack_[i].reset(new pcl::PointCloud<PlannerCloudPointType>());
-  }
+  stacked_cloud_map_.SetWindowSize(parameters_.kKeyposeCloudStackNum);
+  stacked_cloud_map_.SetLeafSize(parameters_.kStackedCloudDwzLeafSize);
+  stacked_vertical_surface_cloud_map_.SetWindowSize(parameters_.kKeyposeCloudStackNum);
+  stacked_vertical_surface_cloud_map_.SetLeafSize(parameters_.kStackedCloudDwzLeafSize);
+  collision_cloud_map_.SetWindowSize(parameters_.kKeyposeCloudStackNum);
+  collision_cloud_map_.SetLeafSize(parameters_.kCollisionCloudDwzLeafSize);
+  stacked_cloud_downsizer_.SetLeafSize(parameters_.kStackedCloudDwzLeafSize, parameters_.kStackedCloudDwzLeafSize,
+                                       parameters_.kStackedCloudDwzLeafSize);
   keypose_cloud_ = std::make_unique<pointcloud_utils_ns::PCLCloud<PlannerCloudPointType>>(
       nh, "planning_env/keypose_cloud", world_frame_id);
   stacked_cloud_ = std::make_unique<pointcloud_utils_ns::PCLCloud<PlannerCloudPointType>>(
       nh, "planning_env/stacked_cloud", world_frame_id);
+  stacked_cloud_->cloud_ = stacked_cloud_map_.GetCloud();
   stacked_vertical_surface_cloud_ = std::make_unique<pointcloud_utils_ns::PCLCloud<PlannerCloudPointType>>(
       nh, "planning_env/stacked_vertical_surface_cloud", world_frame_id);
+  stacked_vertical_surface_cloud_->cloud_ = stacked_vertical_surface_cloud_map_.GetCloud();
 
   stacked_vertical_surface_cloud_kdtree_ =
       pcl::KdTreeFLANN<PlannerCloudPointType>::Ptr(new pcl::KdTreeFLANN<PlannerCloudPointType>());
@@ -73,7 +75,7 @@ PlanningEnv::PlanningEnv(ros::NodeHandle nh, ros::NodeHandle nh_private, std::st
       nh, "planning_env/coverage_cloud", world_frame_id);
   diff_cloud_ = std::make_unique<pointcloud_utils_ns::PCLCloud<PlannerCloudPointType>>(
       nh, "planning_env/diff_cloud", world_frame_id);
-  collision_cloud_ = pcl::PointCloud<pcl::PointXYZI>::Ptr(new pcl::PointCloud<pcl::PointXYZI>);
+  collision_cloud_ = collision_cloud_map_.GetCloud();
   terrain_cloud_ = std::make_unique<pointcloud_utils_ns::PCLCloud<pcl::PointXYZI>>(
       nh, "planning_env/terrain_cloud", world_frame_id);
   planner_cloud_ = std::make_unique<pointcloud_utils_ns::PCLCloud<PlannerCloudPointType>>(
@@ -109,6 +111,7 @@ PlanningEnv::PlanningEnv(ros::NodeHandle nh, ros::NodeHandle nh_private, std::st
 
   rolling_occupancy_grid_cloud_ = std::make_unique<pointcloud_utils_ns::PCLCloud<pcl::PointXYZI>>(
       nh, "planning_env/rolling_occupancy_grid_cloud", world_frame_id);
+  rolling_occupancy_grid_cloud_->SetMaxPublishRate(parameters_.kRollingOccupancyGridCloudPublishRate);
   rolling_frontier_cloud_ = std::make_unique<pointcloud_utils_ns::PCLCloud<pcl::PointXYZI>>(
       nh, "planning_env/rolling_frontier_cloud", world_frame_id);
   rolling_filtered_frontier_cloud_ = std::make_unique<pointcloud_utils_ns::PCLCloud<pcl::PointXYZI>>(
@@ -129,6 +132,9 @@ PlanningEnv::PlanningEnv(ros::NodeHandle nh, ros::NodeHandle nh_private, std::st
   vertical_surface_extractor_.SetZDiffMax(2.0);
   vertical_surface_extractor_.SetZDiffMin(parameters_.kStackedCloudDwzLeafSize);
   vertical_frontier_extractor_.SetNeighborThreshold(2);
+  column_vertical_surface_extractor_.SetRadiusThreshold(0.2);
+  column_vertical_surface_extractor_.SetZDiffMax(2.0);
+  column_vertical_surface_extractor_.SetZDiffMin(parameters_.kStackedCloudDwzLeafSize);
 
   Eigen::Vector3d rolling_occupancy_grid_resolution = rolling_occupancy_grid_->GetResolution();
   double vertical_frontier_neighbor_search_radius =
@@ -141,19 +147,15 @@ PlanningEnv::PlanningEnv(ros::NodeHandle nh, ros::NodeHandle nh_private, std::st
   vertical_frontier_extractor_.SetZDiffMax(z_diff_max);
   vertical_frontier_extractor_.SetZDiffMin(z_diff_min);
   vertical_frontier_extractor_.SetNeighborThreshold(2);
+  column_vertical_frontier_extractor_.SetRadiusThreshold(vertical_frontier_neighbor_search_radius);
+  column_vertical_frontier_extractor_.SetZDiffMax(z_diff_max);
+  column_vertical_frontier_extractor_.SetZDiffMin(z_diff_min);
+  column_vertical_frontier_extractor_.SetNeighborThreshold(2);
 }
 
 void PlanningEnv::UpdateCollisionCloud()
 {
-  collision_cloud_->clear();
-  for (int i = 0; i < parameters_.kKeyposeCloudStackNum; i++)
-  {
-    pcl::PointCloud<pcl::PointXYZI>::Ptr cloud_tmp(new pcl::PointCloud<pcl::PointXYZI>());
-    pcl::copyPointCloud<PlannerCloudPointType, pcl::PointXYZI>(*vertical_surface_cloud_stack_[i], *cloud_tmp);
-    *(collision_cloud_) += *cloud_tmp;
-  }
-  collision_cloud_downsizer_.Downsize(collision_cloud_, parameters_.kCollisionCloudDwzLeafSize,
-                                      parameters_.kCollisionCloudDwzLeafSize, parameters_.kCollisionCloudDwzLeafSize);
+  collision_cloud_map_.AddCloud(*(vertical_surface_cloud_->cloud_));
 }
 
 // "PlanningEnv::UpdateKeyposeCloud"中调用
@@ -166,8 +168,16 @@ void PlanningEnv::UpdateFrontiers()
 
     if (!frontier_cloud_->cloud_->points.empty())
     {
-      vertical_frontier_extractor_.ExtractVerticalSurface<pcl::PointXYZI, pcl::PointXYZI>(
-          frontier_cloud_->cloud_, filtered_frontier_cloud_->cloud_);
+      if (parameters_.kUseColumnVerticalSurfaceExtractor)
+      {
+        column_vertical_frontier_extractor_.ExtractVerticalSurface<pcl::PointXYZI, pcl::PointXYZI>(
+            frontier_cloud_->cloud_, filtered_frontier_cloud_->cloud_);
+      }
+      else
+      {
+        vertical_frontier_extractor_.ExtractVerticalSurface<pcl::PointXYZI, pcl::PointXYZI>(
+            frontier_cloud_->cloud_, filtered_frontier_cloud_->cloud_);
+      }
     }
 
     // Cluster frontiers
@@ -209,6 +219,18 @@ void PlanningEnv::UpdateFrontiers()
   }
 }
 
+void PlanningEnv::PublishRollingOccupancyGridCloud()
+{
+  if (!rolling_occupancy_grid_cloud_->HasSubscribers())
+  {
+    // Stop tracking changes, a new subscriber gets the cloud rebuilt from the grid
+    rolling_occupancy_grid_->ResetVisualizationCloud();
+    return;
+  }
+  rolling_occupancy_grid_cloud_->PublishLazily(
+      [&]() { rolling_occupancy_grid_cloud_->cloud_ = rolling_occupancy_grid_->UpdateVisualizationCloud(); });
+}
+
 void PlanningEnv::UpdateTerrainCloud(const pcl::PointCloud<pcl::PointXYZI>::Ptr& cloud)
 {
   if (cloud->points.empty())
@@ -247,7 +269,7 @@ bool PlanningEnv::InCollision(double x, double y, double z) const
 }
 
 // "SensorCoveragePlanner3D::UpdateCoveredAreas"中调用
-void PlanningEnv::UpdateCoveredArea(const lidar_model_ns::LiDARModel& robot_viewpoint,
+void PlanningEnv::UpdateCoveredArea(const lidar_model_ns::LiDARModelArray& robot_viewpoint,
                                     const std::shared_ptr<viewpoint_manager_ns::ViewPointManager>& viewpoint_manager)
 {
   if (planner_cloud_->cloud_->points.empty())
@@ -255,14 +277,20 @@ void PlanningEnv::UpdateCoveredArea(const lidar_model_ns::LiDARModel& robot_view
     std::cout << "Planning cloud empty, cannot update covered area" << std::endl;
     return;
   }
-  geometry_msgs::Point robot_position = robot_viewpoint.getPosition();
+  geometry_msgs::Point robot_position = robot_viewpoint.GetPosition(0);
   double sensor_range = viewpoint_manager->GetSensorRange();  // param: "kSensorRange"(10.0)
   double coverage_occlusion_thr = viewpoint_manager->GetCoverageOcclusionThr();
   double coverage_dilation_radius = viewpoint_manager->GetCoverageDilationRadius();  // "kCoverageDilationRadius"(1.0)
   std::vector<int> covered_point_indices;
-  double vertical_fov_ratio = 0.3;  // bigger fov than viewpoints
-  double diff_z_max = sensor_range * vertical_fov_ratio;
-  double xy_dist_threshold = 3 * (parameters_.kPlannerCloudDwzLeafSize / 2) / 0.3;
+  // bigger fov than viewpoints
+  const double kFOVMargin = 5.0;
+  lidar_model_ns::LiDARScanPattern scan_pattern = lidar_model_ns::GetScanPattern(robot_viewpoint.GetType());
+  double upper_fov_ratio = tan((scan_pattern.GetUpperVerticalAngle() + kFOVMargin) * M_PI / 180);
+  double lower_fov_ratio = tan((-scan_pattern.GetLowerVerticalAngle() + kFOVMargin) * M_PI / 180);
+  double upper_diff_z_max = sensor_range * upper_fov_ratio;
+  double lower_diff_z_max = sensor_range * lower_fov_ratio;
+  double min_fov_ratio = std::min(upper_fov_ratio, lower_fov_ratio);
+  double xy_dist_threshold = min_fov_ratio > 0 ? 3 * (parameters_.kPlannerCloudDwzLeafSize / 2) / min_fov_ratio : 0;
   double z_diff_threshold = 3 * parameters_.kPlannerCloudDwzLeafSize;  // "kPlannerCloudDwzLeafSize"(0.2)
   for (int i = 0; i < planner_cloud_->cloud_->points.size(); i++)
   {
@@ -273,13 +301,15 @@ void PlanningEnv::UpdateCoveredArea(const lidar_model_ns::LiDARModel& robot_view
       continue;
     }
     // 当前FOV内可见的点云设置为covered
-    if (std::abs(point.z - robot_position.z) < diff_z_max)
+    double z_diff = point.z - robot_position.z;
+    if (z_diff < upper_diff_z_max && -z_diff < lower_diff_z_max)
     {
       if (misc_utils_ns::InFOVSimple(Eigen::Vector3d(point.x, point.y, point.z),
                                      Eigen::Vector3d(robot_position.x, robot_position.y, robot_position.z),
-                                     vertical_fov_ratio, sensor_range, xy_dist_threshold, z_diff_threshold))
+                                     upper_fov_ratio, lower_fov_ratio, sensor_range, xy_dist_threshold,
+                                     z_diff_threshold))
       {
-        if (robot_viewpoint.CheckVisibility<PlannerCloudPointType>(point, coverage_occlusion_thr))
+        if (robot_viewpoint.CheckVisibility<PlannerCloudPointType>(0, point, coverage_occlusion_thr))
         {
           planner_cloud_->cloud_->points[i].g = 255;
           covered_point_indices.push_back(i);
@@ -303,28 +333,53 @@ void PlanningEnv::UpdateCoveredArea(const lidar_model_ns::LiDARModel& robot_view
   }
 
   // Dilate the covered area
-  squeezed_planner_cloud_->cloud_->clear();
-  for (const auto& point : planner_cloud_->cloud_->points)
+  if (parameters_.kUseVoxelHashCoverageDilation)
   {
-    PlannerCloudPointType squeezed_point = point;
-    squeezed_point.z = point.z / parameters_.kCoverCloudZSqueezeRatio;  // (2.0)
-    squeezed_planner_cloud_->cloud_->points.push_back(squeezed_point);
+    // Same neighborhood as the kdtree search below: the covered points are the queries and the candidates are
+    // squeezed in z, so the covered points are hashed as is and each uncovered point is probed squeezed
+    covered_point_hash_.Reset(coverage_dilation_radius);
+    for (const auto& ind : covered_point_indices)
+    {
+      const PlannerCloudPointType& point = planner_cloud_->cloud_->points[ind];
+      covered_point_hash_.Insert(Eigen::Vector3f(point.x, point.y, point.z));
+    }
+    if (!covered_point_hash_.Empty())
+    {
+      for (auto& point : planner_cloud_->cloud_->points)
+      {
+        if (point.g == 0 && covered_point_hash_.HasPointInRadius(Eigen::Vector3f(
+                                point.x, point.y, point.z / parameters_.kCoverCloudZSqueezeRatio)))
+        {
+          point.g = 255;
+        }
+      }
+    }
   }
-  squeezed_planner_cloud_kdtree_->setInputCloud(squeezed_planner_cloud_->cloud_);
-
-  // 确保附近的点也都mark(填充)为covered
-  for (const auto& ind : covered_point_indices)
+  else
   {
-    PlannerCloudPointType point = planner_cloud_->cloud_->points[ind];
-    std::vector<int> nearby_indices;
-    std::vector<float> nearby_sqdist;
-    squeezed_planner_cloud_kdtree_->radiusSearch(point, coverage_dilation_radius, nearby_indices, nearby_sqdist);
-    if (!nearby_indices.empty())
+    squeezed_planner_cloud_->cloud_->clear();
+    for (const auto& point : planner_cloud_->cloud_->points)
+    {
+      PlannerCloudPointType squeezed_point = point;
+      squeezed_point.z = point.z / parameters_.kCoverCloudZSqueezeRatio;  // (2.0)
+      squeezed_planner_cloud_->cloud_->points.push_back(squeezed_point);
+    }
+    squeezed_planner_cloud_kdtree_->setInputCloud(squeezed_planner_cloud_->cloud_);
+
+    // 确保附近的点也都mark(填充)为covered
+    for (const auto& ind : covered_point_indices)
     {
-      for (const auto& idx : nearby_indices)
+      PlannerCloudPointType point = planner_cloud_->cloud_->points[ind];
+      std::vector<int> nearby_indices;
+      std::vector<float> nearby_sqdist;
+      squeezed_planner_cloud_kdtree_->radiusSearch(point, coverage_dilation_radius, nearby_indices, nearby_sqdist);
+      if (!nearby_indices.empty())
       {
-        MY_ASSERT(idx >= 0 && idx < planner_cloud_->cloud_->points.size());
-        planner_cloud_->cloud_->points[idx].g = 255;
+        for (const auto& idx : nearby_indices)
+        {
+          MY_ASSERT(idx >= 0 && idx < planner_cloud_->cloud_->points.size());
+          planner_cloud_->cloud_->points[idx].g = 255;
+        }
       }
     }
   }
@@ -332,13 +387,9 @@ void PlanningEnv::UpdateCoveredArea(const lidar_model_ns::LiDARModel& robot_view
   // 更新"pointcloud_manager_"中的"pointcloud_grid_"信息
   for (int i = 0; i < planner_cloud_->cloud_->points.size(); i++)
   {
-    PlannerCloudPointType point = planner_cloud_->cloud_->points[i];
-    if (point.g > 0)
+    if (planner_cloud_->cloud_->points[i].g > 0)
     {
-      int cloud_idx = 0;
-      int cloud_point_idx = 0;
-      pointcloud_manager_->GetCloudPointIndex(i, cloud_idx, cloud_point_idx);
-      pointcloud_manager_->UpdateCoveredCloudPoints(cloud_idx, cloud_point_idx);
+      pointcloud_manager_->SetCloudPointCovered(i);
     }
   }
 }
@@ -444,4 +495,45 @@ void PlanningEnv::PublishUncoveredFrontierCloud()
   uncovered_frontier_cloud_->Publish();
 }
 
+void PlanningEnv::GetMemoryUsage(misc_utils_ns::MemoryReport& report) const
+{
+  const std::string kModule = "planning_env";
+  report.Add(kModule, "cloud stacks",
+             stacked_cloud_map_.GetMemoryBytes() + stacked_vertical_surface_cloud_map_.GetMemoryBytes() +
+                 collision_cloud_map_.GetMemoryBytes());
+  report.Add(kModule, "stacked clouds",
+             misc_utils_ns::GetCloudPtrBytes(keypose_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(stacked_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(stacked_vertical_surface_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(vertical_surface_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(diff_cloud_->cloud_) +
+                 misc_utils_ns::GetKdTreeBytes(stacked_vertical_surface_cloud_kdtree_));
+  report.Add(kModule, "planner clouds",
+             misc_utils_ns::GetCloudPtrBytes(planner_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(squeezed_planner_cloud_->cloud_) +
+                 misc_utils_ns::GetKdTreeBytes(squeezed_planner_cloud_kdtree_) + covered_point_hash_.GetMemoryBytes() +
+                 misc_utils_ns::GetCloudPtrBytes(uncovered_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(uncovered_frontier_cloud_->cloud_));
+  report.Add(kModule, "collision and terrain clouds",
+             misc_utils_ns::GetCloudPtrBytes(collision_cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(terrain_cloud_->cloud_));
+  report.Add(kModule, "frontier clouds",
+             misc_utils_ns::GetCloudPtrBytes(frontier_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(filtered_frontier_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(rolling_frontier_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(rolling_filtered_frontier_cloud_->cloud_) +
+                 misc_utils_ns::GetKdTreeBytes(kdtree_frontier_cloud_) +
+                 misc_utils_ns::GetKdTreeBytes(kdtree_rolling_frontier_cloud_));
+  report.Add(kModule, "debug clouds",
+             misc_utils_ns::GetCloudPtrBytes(rolling_occupancy_grid_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(rolled_in_occupancy_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(rolled_out_occupancy_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(pointcloud_manager_occupancy_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(occupied_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(free_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(unknown_cloud_->cloud_));
+  pointcloud_manager_->GetMemoryUsage(report);
+  rolling_occupancy_grid_->GetMemoryUsage(report);
+}
+
 }  // namespace planning_env_ns
\ No newline at end of file
@@ -129,9 +129,15 @@ bool PointCloudManager::UpdateRobotPosition(const geometry_msgs::Point& robot_po
 void PointCloudManager::GetPointCloud(PCLCloudType& cloud_out)
 {
   cloud_out.clear();
+  point_handles_.clear();
   for (const auto& neighbor_ind : neighbor_indices_)
   {
     cloud_out += *(pointcloud_grid_->GetCell(neighbor_ind));
+    int point_num = pointcloud_grid_->GetCell(neighbor_ind)->points.size();
+    for (int i = 0; i < point_num; i++)
+    {
+      point_handles_.push_back({ neighbor_ind, i });
+    }
   }
 }
 
@@ -266,6 +272,25 @@ int PointCloudManager::GetAllPointNum()
   return num;
 }
 
+void PointCloudManager::GetMemoryUsage(misc_utils_ns::MemoryReport& report) const
+{
+  const std::string kModule = "pointcloud_manager";
+  uint64_t cell_cloud_bytes = 0;
+  for (int i = 0; i < pointcloud_grid_->GetCellNumber(); ++i)
+  {
+    cell_cloud_bytes += misc_utils_ns::GetCloudPtrBytes(pointcloud_grid_->GetCell(i));
+  }
+  uint64_t occupancy_cloud_bytes = 0;
+  for (int i = 0; i < occupancy_cloud_grid_->GetCellNumber(); ++i)
+  {
+    occupancy_cloud_bytes += misc_utils_ns::GetCloudPtrBytes(occupancy_cloud_grid_->GetCell(i));
+  }
+  report.Add(kModule, "cell clouds",
+             pointcloud_grid_->GetMemoryBytes() + cell_cloud_bytes + misc_utils_ns::GetVectorBytes(point_handles_));
+  report.Add(kModule, "occupancy clouds", occupancy_cloud_grid_->GetMemoryBytes() + occupancy_cloud_bytes +
+                                               misc_utils_ns::GetCloudPtrBytes(rolled_in_occupancy_cloud_));
+}
+
 void PointCloudManager::UpdateOldCloudPoints()
 {
   for (int i = 0; i < pointcloud_grid_->GetCellNumber(); ++i)
@@ -40,6 +40,7 @@ void RollingGrid::Roll(const Eigen::Vector3i& roll_dir)
   {
     return;
   }
+  PROFILE_SCOPE("rolling grid roll");
   if (which_grid_)
   {
     RollHelper(grid1_, grid0_, roll_dir);
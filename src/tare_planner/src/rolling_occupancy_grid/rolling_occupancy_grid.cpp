@@ -10,10 +10,18 @@
  */
 
 #include "rolling_occupancy_grid/rolling_occupancy_grid.h"
+#include <algorithm>
+#include <cmath>
 
 namespace rolling_occupancy_grid_ns
 {
-RollingOccupancyGrid::RollingOccupancyGrid(ros::NodeHandle& nh) : initialized_(false), dimension_(3)
+RollingOccupancyGrid::RollingOccupancyGrid(ros::NodeHandle& nh)
+  : initialized_(false)
+  , dimension_(3)
+  , ray_trace_epoch_(0)
+  , ray_trace_generation_(0)
+  , ray_trace_busy_worker_num_(0)
+  , ray_trace_workers_stopping_(false)
 {
   double pointcloud_cell_size = misc_utils_ns::getParam<double>(nh, "kPointCloudCellSize", 18);
   double pointcloud_cell_height = misc_utils_ns::getParam<double>(nh, "kPointCloudCellHeight", 1.8);
@@ -25,6 +33,9 @@ RollingOccupancyGrid::RollingOccupancyGrid(ros::NodeHandle& nh) : initialized_(f
   resolution_.x() = misc_utils_ns::getParam<double>(nh, "rolling_occupancy_grid/resolution_x", 0.3);
   resolution_.y() = misc_utils_ns::getParam<double>(nh, "rolling_occupancy_grid/resolution_y", 0.3);
   resolution_.z() = misc_utils_ns::getParam<double>(nh, "rolling_occupancy_grid/resolution_z", 0.3);
+  ray_trace_thread_num_ =
+      std::max(1, misc_utils_ns::getParam<int>(nh, "rolling_occupancy_grid/ray_trace_thread_num", 1));
+  ray_trace_early_out_ = misc_utils_ns::getParam<bool>(nh, "rolling_occupancy_grid/ray_trace_early_out", false);
 
   rollover_range_.x() = pointcloud_cell_size;
   rollover_range_.y() = pointcloud_cell_size;
@@ -38,11 +49,37 @@ RollingOccupancyGrid::RollingOccupancyGrid(ros::NodeHandle& nh) : initialized_(f
   }
 
   rolling_grid_ = std::make_unique<rolling_grid_ns::RollingGrid>(grid_size_);
-  occupancy_array_ = std::make_unique<grid_ns::Grid<CellState>>(grid_size_, UNKNOWN, origin_, resolution_);
+  occupancy_array_ = std::make_unique<grid_ns::PackedGrid<CellState>>(grid_size_, UNKNOWN, origin_, resolution_);
+  if (ray_trace_thread_num_ > 1)
+  {
+    if (ray_trace_early_out_)
+    {
+      free_epoch_.assign(occupancy_array_->GetCellNumber(), 0);
+    }
+    ray_cell_buffers_.resize(ray_trace_thread_num_);
+    for (int i = 1; i < ray_trace_thread_num_; i++)
+    {
+      ray_trace_workers_.emplace_back(&RollingOccupancyGrid::RayTraceWorker, this, i);
+    }
+  }
 
   robot_position_ = Eigen::Vector3d(0, 0, 0);
 
   occupancy_cloud_ = pcl::PointCloud<pcl::PointXYZI>::Ptr(new pcl::PointCloud<pcl::PointXYZI>);
+  vis_cloud_ = pcl::PointCloud<pcl::PointXYZI>::Ptr(new pcl::PointCloud<pcl::PointXYZI>);
+}
+
+RollingOccupancyGrid::~RollingOccupancyGrid()
+{
+  {
+    std::lock_guard<std::mutex> lock(ray_trace_mutex_);
+    ray_trace_workers_stopping_ = true;
+  }
+  ray_trace_start_condition_.notify_all();
+  for (auto& worker : ray_trace_workers_)
+  {
+    worker.join();
+  }
 }
 
 void RollingOccupancyGrid::InitializeOrigin(const Eigen::Vector3d& origin)
@@ -130,9 +167,24 @@ bool RollingOccupancyGrid::UpdateRobotPosition(const Eigen::Vector3d& robot_posi
   std::vector<int> updated_grid_indices;
   rolling_grid_->GetUpdatedArrayIndices(updated_grid_indices);
 
-  for (const auto& ind : updated_grid_indices)
+  // The rolled in cells form runs of consecutive array inds, which are cleared whole words at a time
+  std::sort(updated_grid_indices.begin(), updated_grid_indices.end());
+  for (int i = 0; i < updated_grid_indices.size();)
   {
-    occupancy_array_->SetCellValue(ind, CellState::UNKNOWN);
+    int run_end = i + 1;
+    while (run_end < updated_grid_indices.size() &&
+           updated_grid_indices[run_end] == updated_grid_indices[run_end - 1] + 1)
+    {
+      run_end++;
+    }
+    occupancy_array_->SetCellValueRange(updated_grid_indices[i], updated_grid_indices[run_end - 1] + 1,
+                                        CellState::UNKNOWN);
+    if (vis_cell_states_ != nullptr)
+    {
+      vis_cell_states_->SetCellValueRange(updated_grid_indices[i], updated_grid_indices[run_end - 1] + 1,
+                                          CellState::NOT_FRONTIER);
+    }
+    i = run_end;
   }
 
   return true;
@@ -177,6 +229,12 @@ void RollingOccupancyGrid::RayTrace(const Eigen::Vector3d& origin, const Eigen::
 
   misc_utils_ns::UniquifyIntVector(updated_grid_indices_);
 
+  if (ray_trace_thread_num_ > 1)
+  {
+    RayTraceParallel(origin_sub);
+    return;
+  }
+
   for (const auto& ind : updated_grid_indices_)
   {
     if (occupancy_array_->InRange(ind))
@@ -216,6 +274,165 @@ void RollingOccupancyGrid::RayTrace(const Eigen::Vector3d& origin, const Eigen::
   }
 }
 
+void RollingOccupancyGrid::RayTraceParallel(const Eigen::Vector3i& origin_sub)
+{
+  if (ray_trace_early_out_)
+  {
+    // Advance the epoch, stamps of a wrapped epoch are cleared so that they never match again
+    ray_trace_epoch_++;
+    if (ray_trace_epoch_ == 0)
+    {
+      std::fill(free_epoch_.begin(), free_epoch_.end(), 0);
+      ray_trace_epoch_ = 1;
+    }
+  }
+
+  // Bucket the rays by azimuth so that each thread gets a contiguous angular sector. Rays in different sectors only
+  // share cells close to the robot, and neighboring rays in a sector hit each other's free cells for the early-out.
+  const int kSectorNum = 64 * ray_trace_thread_num_;
+  std::vector<int> sector_offsets(kSectorNum + 1, 0);
+  std::vector<std::pair<int, int>> ray_sectors;
+  ray_sectors.reserve(updated_grid_indices_.size());
+  for (const auto& ind : updated_grid_indices_)
+  {
+    if (!occupancy_array_->InRange(ind) || occupancy_array_->GetCellValue(rolling_grid_->GetArrayInd(ind)) != OCCUPIED)
+    {
+      continue;
+    }
+    Eigen::Vector3i diff_sub = occupancy_array_->Ind2Sub(ind) - origin_sub;
+    double azimuth = std::atan2(static_cast<double>(diff_sub.y()), static_cast<double>(diff_sub.x()));
+    int sector = static_cast<int>((azimuth + M_PI) / (2 * M_PI) * kSectorNum);
+    sector = std::min(std::max(sector, 0), kSectorNum - 1);
+    ray_sectors.emplace_back(ind, sector);
+    sector_offsets[sector + 1]++;
+  }
+  for (int i = 0; i < kSectorNum; i++)
+  {
+    sector_offsets[i + 1] += sector_offsets[i];
+  }
+  ray_end_indices_.resize(ray_sectors.size());
+  for (const auto& ray_sector : ray_sectors)
+  {
+    ray_end_indices_[sector_offsets[ray_sector.second]++] = ray_sector.first;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(ray_trace_mutex_);
+    ray_trace_origin_sub_ = origin_sub;
+    ray_trace_busy_worker_num_ = ray_trace_workers_.size();
+    ray_trace_generation_++;
+  }
+  ray_trace_start_condition_.notify_all();
+
+  const int* ray_end_begin;
+  const int* ray_end_end;
+  RayTraceThreadShare(0, ray_end_begin, ray_end_end);
+  RayTraceRays(origin_sub, ray_end_begin, ray_end_end, ray_cell_buffers_[0]);
+
+  std::unique_lock<std::mutex> lock(ray_trace_mutex_);
+  ray_trace_done_condition_.wait(lock, [this]() { return ray_trace_busy_worker_num_ == 0; });
+}
+
+void RollingOccupancyGrid::RayTraceWorker(int thread_ind)
+{
+  int generation = 0;
+  while (true)
+  {
+    Eigen::Vector3i origin_sub;
+    {
+      std::unique_lock<std::mutex> lock(ray_trace_mutex_);
+      ray_trace_start_condition_.wait(
+          lock, [&]() { return ray_trace_workers_stopping_ || ray_trace_generation_ != generation; });
+      if (ray_trace_workers_stopping_)
+      {
+        return;
+      }
+      generation = ray_trace_generation_;
+      origin_sub = ray_trace_origin_sub_;
+    }
+    const int* ray_end_begin;
+    const int* ray_end_end;
+    RayTraceThreadShare(thread_ind, ray_end_begin, ray_end_end);
+    RayTraceRays(origin_sub, ray_end_begin, ray_end_end, ray_cell_buffers_[thread_ind]);
+    {
+      std::lock_guard<std::mutex> lock(ray_trace_mutex_);
+      ray_trace_busy_worker_num_--;
+      if (ray_trace_busy_worker_num_ == 0)
+      {
+        ray_trace_done_condition_.notify_one();
+      }
+    }
+  }
+}
+
+void RollingOccupancyGrid::RayTraceThreadShare(int thread_ind, const int*& ray_end_begin,
+                                               const int*& ray_end_end) const
+{
+  int ray_num = ray_end_indices_.size();
+  int ray_num_per_thread = (ray_num + ray_trace_thread_num_ - 1) / ray_trace_thread_num_;
+  int begin = std::min(thread_ind * ray_num_per_thread, ray_num);
+  int end = std::min(begin + ray_num_per_thread, ray_num);
+  ray_end_begin = ray_end_indices_.data() + begin;
+  ray_end_end = ray_end_indices_.data() + end;
+}
+
+void RollingOccupancyGrid::RayTraceRays(const Eigen::Vector3i& origin_sub, const int* ray_end_begin,
+                                        const int* ray_end_end, std::vector<int>& ray_cells)
+{
+  // Threads only write FREE over cells that are not OCCUPIED and never write OCCUPIED, so concurrent writes to shared
+  // cells near the robot store the same value and the result does not depend on the interleaving. Cells are packed 32
+  // to a word, so the writes are atomic to keep the other cells of the word intact.
+  if (!ray_trace_early_out_)
+  {
+    // Same as the serial ray trace: free the cells from the robot up to the first occupied cell
+    for (const int* ray_end = ray_end_begin; ray_end != ray_end_end; ++ray_end)
+    {
+      TraverseRay(origin_sub, occupancy_array_->Ind2Sub(*ray_end), [&](int ind) {
+        int array_ind = rolling_grid_->GetArrayIndUnchecked(ind);
+        CellState cell_state = occupancy_array_->GetCellValue(array_ind);
+        if (cell_state == OCCUPIED)
+        {
+          return false;
+        }
+        if (cell_state != FREE)
+        {
+          occupancy_array_->SetCellValueAtomic(array_ind, FREE);
+        }
+        return true;
+      });
+    }
+    return;
+  }
+
+  // Rays are walked from the occupied end back to the robot. Cells behind an occupied cell are dropped, and once the
+  // ray enters a cell freed in this epoch the rest towards the robot is taken as already cleared by a neighboring ray.
+  // This is an approximation: the neighboring ray took a slightly different path, so cells on this ray may be missed
+  // and cells behind an occluder that only this ray crosses may be freed.
+  for (const int* ray_end = ray_end_begin; ray_end != ray_end_end; ++ray_end)
+  {
+    ray_cells.clear();
+    TraverseRay(occupancy_array_->Ind2Sub(*ray_end), origin_sub, [&](int ind) {
+      int array_ind = rolling_grid_->GetArrayIndUnchecked(ind);
+      if (occupancy_array_->GetCellValue(array_ind) == OCCUPIED)
+      {
+        ray_cells.clear();
+        return true;
+      }
+      if (free_epoch_[array_ind] == ray_trace_epoch_)
+      {
+        return false;
+      }
+      ray_cells.push_back(array_ind);
+      return true;
+    });
+    for (const auto& array_ind : ray_cells)
+    {
+      occupancy_array_->SetCellValueAtomic(array_ind, FREE);
+      free_epoch_[array_ind] = ray_trace_epoch_;
+    }
+  }
+}
+
 void RollingOccupancyGrid::RayTrace(const Eigen::Vector3d& origin)
 {
   if (!initialized_)
@@ -306,129 +523,202 @@ void RollingOccupancyGrid::GetFrontier(pcl::PointCloud<pcl::PointXYZI>::Ptr& fro
     ROS_WARN("RollingOccupancyGrid::GetFrontierInRange(), robot not in range");
     return;
   }
-  int ray_trace_count = 0;
 
-  int cell_num = occupancy_array_->GetCellNumber();
-  for (int ind = 0; ind < cell_num; ind++)
+  // A frontier is an unknown cell with a free neighbor in xy and none in z. The candidates are gathered from the free
+  // cells, which are found a word of the packed array at a time, so the large unknown regions are skipped 32 cells at
+  // once instead of being tested cell by cell.
+  const Eigen::Vector3i kXYNeighborOffsets[4] = { Eigen::Vector3i(-1, 0, 0), Eigen::Vector3i(1, 0, 0),
+                                                  Eigen::Vector3i(0, -1, 0), Eigen::Vector3i(0, 1, 0) };
+  frontier_checked_.Reset(occupancy_array_->GetCellNumber());
+  int word_num = occupancy_array_->GetWordNumber();
+  for (int word_ind = 0; word_ind < word_num; word_ind++)
   {
-    Eigen::Vector3i cur_sub = occupancy_array_->Ind2Sub(ind);
-    if (!occupancy_array_->InRange(cur_sub))
+    uint32_t free_mask = occupancy_array_->GetValueMask(word_ind, FREE);
+    while (free_mask != 0)
     {
-      continue;
-    }
-    if (!InRange(cur_sub, sub_min, sub_max))
-    {
-      continue;
-    }
-    int array_ind = rolling_grid_->GetArrayInd(cur_sub);
-    if (occupancy_array_->GetCellValue(array_ind) == UNKNOWN)
-    {
-      bool z_free = false;
-      bool xy_free = false;
-      // If the unknown cell has neighboring free cells in xy but not z direction
-      cur_sub(2)--;
-      if (occupancy_array_->InRange(cur_sub))
+      int free_array_ind = word_ind * grid_ns::PackedGrid<CellState>::kCellsPerWord + __builtin_ctz(free_mask);
+      free_mask &= free_mask - 1;
+      Eigen::Vector3i free_sub = occupancy_array_->Ind2Sub(rolling_grid_->GetInd(free_array_ind));
+      for (const auto& offset : kXYNeighborOffsets)
       {
-        array_ind = rolling_grid_->GetArrayInd(cur_sub);
-        if (occupancy_array_->GetCellValue(array_ind) == FREE)
+        Eigen::Vector3i cur_sub = free_sub + offset;
+        if (!occupancy_array_->InRange(cur_sub) || !InRange(cur_sub, sub_min, sub_max))
         {
-          z_free = true;
           continue;
         }
-      }
-      cur_sub(2) += 2;
-      if (occupancy_array_->InRange(cur_sub))
-      {
-        array_ind = rolling_grid_->GetArrayInd(cur_sub);
-        if (occupancy_array_->GetCellValue(array_ind) == FREE)
+        int array_ind = rolling_grid_->GetArrayInd(cur_sub);
+        if (frontier_checked_.Test(array_ind))
         {
-          z_free = true;
           continue;
         }
-      }
-      cur_sub(2)--;
-
-      for (int i = 0; i < 2; i++)
-      {
-        cur_sub(i)--;
-        if (occupancy_array_->InRange(cur_sub))
+        frontier_checked_.Set(array_ind);
+        if (occupancy_array_->GetCellValue(array_ind) != UNKNOWN)
         {
-          array_ind = rolling_grid_->GetArrayInd(cur_sub);
-          if (occupancy_array_->GetCellValue(array_ind) == FREE)
-          {
-            xy_free = true;
-            cur_sub(i)++;
-            break;
-          }
+          continue;
         }
-        cur_sub(i) += 2;
-        if (occupancy_array_->InRange(cur_sub))
+        bool z_free = false;
+        for (int z_offset = -1; z_offset <= 1 && !z_free; z_offset += 2)
         {
-          array_ind = rolling_grid_->GetArrayInd(cur_sub);
-          if (occupancy_array_->GetCellValue(array_ind) == FREE)
-          {
-            xy_free = true;
-            cur_sub(i)--;
-            break;
-          }
+          Eigen::Vector3i z_neighbor_sub(cur_sub.x(), cur_sub.y(), cur_sub.z() + z_offset);
+          z_free = occupancy_array_->InRange(z_neighbor_sub) &&
+                   occupancy_array_->GetCellValue(rolling_grid_->GetArrayInd(z_neighbor_sub)) == FREE;
+        }
+        if (!z_free)
+        {
+          Eigen::Vector3d position = occupancy_array_->Sub2Pos(cur_sub);
+          pcl::PointXYZI point;
+          point.x = position.x();
+          point.y = position.y();
+          point.z = position.z();
+          point.intensity = 0;
+          frontier_cloud->points.push_back(point);
         }
-        cur_sub(i)--;
       }
-      if (xy_free && !z_free)
+    }
+  }
+}
+
+void RollingOccupancyGrid::GetVisualizationCloud(pcl::PointCloud<pcl::PointXYZI>::Ptr& vis_cloud)
+{
+  vis_cloud->clear();
+  int word_num = occupancy_array_->GetWordNumber();
+  for (int word_ind = 0; word_ind < word_num; word_ind++)
+  {
+    // Occupied cells get intensity 0 and free cells 1, words with only unknown cells are skipped
+    uint32_t state_masks[2] = { occupancy_array_->GetValueMask(word_ind, CellState::OCCUPIED),
+                                occupancy_array_->GetValueMask(word_ind, CellState::FREE) };
+    for (int i = 0; i < 2; i++)
+    {
+      uint32_t mask = state_masks[i];
+      while (mask != 0)
       {
-        Eigen::Vector3d position = occupancy_array_->Sub2Pos(cur_sub);
+        int array_ind = word_ind * grid_ns::PackedGrid<CellState>::kCellsPerWord + __builtin_ctz(mask);
+        mask &= mask - 1;
+        Eigen::Vector3d position = occupancy_array_->Ind2Pos(rolling_grid_->GetInd(array_ind));
         pcl::PointXYZI point;
         point.x = position.x();
         point.y = position.y();
         point.z = position.z();
-        point.intensity = 0;
-        frontier_cloud->points.push_back(point);
+        point.intensity = i;
+        vis_cloud->points.push_back(point);
       }
     }
   }
 }
 
-void RollingOccupancyGrid::GetVisualizationCloud(pcl::PointCloud<pcl::PointXYZI>::Ptr& vis_cloud)
+bool RollingOccupancyGrid::InRange(const Eigen::Vector3i& sub, const Eigen::Vector3i& sub_min,
+                                   const Eigen::Vector3i& sub_max)
 {
-  vis_cloud->clear();
-  int cell_number = occupancy_array_->GetCellNumber();
-  for (int i = 0; i < cell_number; i++)
+  bool in_range = true;
+  for (int i = 0; i < 3; i++)
+  {
+    in_range &= (sub(i) >= sub_min(i) && sub(i) <= sub_max(i));
+  }
+  return in_range;
+}
+
+const pcl::PointCloud<pcl::PointXYZI>::Ptr& RollingOccupancyGrid::UpdateVisualizationCloud()
+{
+  if (vis_cell_states_ == nullptr)
   {
-    int array_ind = rolling_grid_->GetArrayInd(i);
-    if (occupancy_array_->GetCellValue(array_ind) == CellState::OCCUPIED ||
-        occupancy_array_->GetCellValue(array_ind) == CellState::FREE)
+    // An all unknown snapshot matches the empty cloud, so the first update adds every known cell
+    vis_cell_states_ = std::make_unique<grid_ns::PackedGrid<CellState>>(grid_size_, UNKNOWN);
+    vis_point_indices_.assign(occupancy_array_->GetCellNumber(), -1);
+    vis_point_array_inds_.clear();
+    vis_cloud_->clear();
+  }
+  int word_num = occupancy_array_->GetWordNumber();
+  int cell_num = occupancy_array_->GetCellNumber();
+  for (int word_ind = 0; word_ind < word_num; word_ind++)
+  {
+    grid_ns::PackedGrid<CellState>::WordType word = occupancy_array_->GetWord(word_ind);
+    grid_ns::PackedGrid<CellState>::WordType previous_word = vis_cell_states_->GetWord(word_ind);
+    uint32_t changed_mask = grid_ns::PackedGrid<CellState>::GetDiffMask(word, previous_word);
+    if (changed_mask == 0)
     {
-      Eigen::Vector3d position = occupancy_array_->Ind2Pos(i);
-      pcl::PointXYZI point;
-      point.x = position.x();
-      point.y = position.y();
-      point.z = position.z();
-      if (occupancy_array_->GetCellValue(array_ind) == CellState::OCCUPIED)
+      continue;
+    }
+    vis_cell_states_->SetWord(word_ind, word);
+    while (changed_mask != 0)
+    {
+      int lane = __builtin_ctz(changed_mask);
+      changed_mask &= changed_mask - 1;
+      int array_ind = word_ind * grid_ns::PackedGrid<CellState>::kCellsPerWord + lane;
+      if (array_ind >= cell_num)
       {
-        point.intensity = 0.0;
+        break;
       }
-      else if (occupancy_array_->GetCellValue(array_ind) == CellState::FREE)
+      CellState cell_state = occupancy_array_->GetCellValue(array_ind);
+      bool known = cell_state == OCCUPIED || cell_state == FREE;
+      bool rolled = ((previous_word >> (lane * 2)) & 0x3) == NOT_FRONTIER;
+      int point_ind = vis_point_indices_[array_ind];
+      if (point_ind >= 0 && (!known || rolled))
       {
-        point.intensity = 1.0;
+        // Remove the point by moving the last point into its place
+        int last_point_ind = vis_cloud_->points.size() - 1;
+        vis_cloud_->points[point_ind] = vis_cloud_->points[last_point_ind];
+        vis_point_array_inds_[point_ind] = vis_point_array_inds_[last_point_ind];
+        vis_point_indices_[vis_point_array_inds_[point_ind]] = point_ind;
+        vis_point_indices_[array_ind] = -1;
+        vis_cloud_->points.pop_back();
+        vis_point_array_inds_.pop_back();
+        point_ind = -1;
+      }
+      if (!known)
+      {
+        continue;
+      }
+      if (point_ind >= 0)
+      {
+        // Same cell, only the state changed
+        vis_cloud_->points[point_ind].intensity = cell_state == OCCUPIED ? 0 : 1;
       }
       else
       {
-        point.intensity = 2.0;
+        Eigen::Vector3d position = occupancy_array_->Ind2Pos(rolling_grid_->GetInd(array_ind));
+        pcl::PointXYZI point;
+        point.x = position.x();
+        point.y = position.y();
+        point.z = position.z();
+        point.intensity = cell_state == OCCUPIED ? 0 : 1;
+        vis_point_indices_[array_ind] = vis_cloud_->points.size();
+        vis_point_array_inds_.push_back(array_ind);
+        vis_cloud_->points.push_back(point);
       }
-      vis_cloud->points.push_back(point);
     }
   }
+  vis_cloud_->width = vis_cloud_->points.size();
+  vis_cloud_->height = 1;
+  return vis_cloud_;
 }
 
-bool RollingOccupancyGrid::InRange(const Eigen::Vector3i& sub, const Eigen::Vector3i& sub_min,
-                                   const Eigen::Vector3i& sub_max)
+void RollingOccupancyGrid::ResetVisualizationCloud()
 {
-  bool in_range = true;
-  for (int i = 0; i < 3; i++)
+  if (vis_cell_states_ == nullptr)
   {
-    in_range &= (sub(i) >= sub_min(i) && sub(i) <= sub_max(i));
+    return;
   }
-  return in_range;
+  vis_cell_states_.reset();
+  vis_cloud_->clear();
+  vis_cloud_->points.shrink_to_fit();
+  std::vector<int>().swap(vis_point_indices_);
+  std::vector<int>().swap(vis_point_array_inds_);
+}
+
+void RollingOccupancyGrid::GetMemoryUsage(misc_utils_ns::MemoryReport& report) const
+{
+  const std::string kModule = "rolling_occupancy_grid";
+  report.Add(kModule, "occupancy array", occupancy_array_->GetMemoryBytes() + rolling_grid_->GetMemoryBytes());
+  report.Add(kModule, "updated indices", misc_utils_ns::GetVectorBytes(updated_grid_indices_));
+  report.Add(kModule, "ray trace buffers",
+             misc_utils_ns::GetVectorBytes(free_epoch_) + misc_utils_ns::GetVectorBytes(ray_end_indices_) +
+                 misc_utils_ns::GetNestedVectorBytes(ray_cell_buffers_));
+  report.Add(kModule, "occupancy cloud", misc_utils_ns::GetCloudPtrBytes(occupancy_cloud_));
+  // vis_cloud_ itself is reported by the owner that publishes it
+  report.Add(kModule, "visualization index",
+             (vis_cell_states_ != nullptr ? vis_cell_states_->GetMemoryBytes() : 0) +
+                 misc_utils_ns::GetVectorBytes(vis_point_indices_) +
+                 misc_utils_ns::GetVectorBytes(vis_point_array_inds_));
 }
 
 }  // namespace rolling_occupancy_grid_ns
\ No newline at end of file
@@ -10,6 +10,7 @@
  */
 
 #include "sensor_coverage_planner/sensor_coverage_planner_ground.h"
+#include <sstream>
 
 namespace sensor_coverage_planner_3d_ns
 {
@@ -31,12 +32,23 @@ bool PlannerParameters::ReadParameters(ros::NodeHandle& nh)
       misc_utils_ns::getParam<std::string>(nh, "sub_viewpoint_boundary_topic_", "/viewpoint_boundary");
   sub_nogo_boundary_topic_ =
       misc_utils_ns::getParam<std::string>(nh, "sub_nogo_boundary_topic_", "/nogo_boundary");
+  sub_profiler_export_topic_ =
+      misc_utils_ns::getParam<std::string>(nh, "sub_profiler_export_topic_", "profiler_export");
+  sub_memory_report_export_topic_ =
+      misc_utils_ns::getParam<std::string>(nh, "sub_memory_report_export_topic_", "memory_report_export");
   pub_exploration_finish_topic_ =
       misc_utils_ns::getParam<std::string>(nh, "pub_exploration_finish_topic_", "exploration_finish");
   pub_runtime_breakdown_topic_ =
       misc_utils_ns::getParam<std::string>(nh, "pub_runtime_breakdown_topic_", "runtime_breakdown");
   pub_runtime_topic_ = misc_utils_ns::getParam<std::string>(nh, "pub_runtime_topic_", "/runtime");
   pub_waypoint_topic_ = misc_utils_ns::getParam<std::string>(nh, "pub_waypoint_topic_", "/way_point");
+  pub_memory_report_topic_ = misc_utils_ns::getParam<std::string>(nh, "pub_memory_report_topic_", "memory_report");
+  pub_planning_cycle_topic_ =
+      misc_utils_ns::getParam<std::string>(nh, "pub_planning_cycle_topic_", "/planning_cycle");
+  kProfilerTraceFile =
+      misc_utils_ns::getParam<std::string>(nh, "kProfilerTraceFile", "/tmp/tare_planner_trace.json");
+  kMemoryReportFile =
+      misc_utils_ns::getParam<std::string>(nh, "kMemoryReportFile", "/tmp/tare_planner_memory.json");
 
   // Bool
   kAutoStart = misc_utils_ns::getParam<bool>(nh, "kAutoStart", false);
@@ -45,6 +57,13 @@ bool PlannerParameters::ReadParameters(ros::NodeHandle& nh)
   kCheckTerrainCollision = misc_utils_ns::getParam<bool>(nh, "kCheckTerrainCollision", true);
   kExtendWayPoint = misc_utils_ns::getParam<bool>(nh, "kExtendWayPoint", true);
   kUseLineOfSightLookAheadPoint = misc_utils_ns::getParam<bool>(nh, "kUseLineOfSightLookAheadPoint", true);
+  kEnableProfiler = misc_utils_ns::getParam<bool>(nh, "kEnableProfiler", true);
+  kHeadless = misc_utils_ns::getParam<bool>(nh, "kHeadless", false);
+  kUseVisualizationThread = misc_utils_ns::getParam<bool>(nh, "kUseVisualizationThread", true);
+
+  // Int
+  kProfilerReportInterval = misc_utils_ns::getParam<int>(nh, "kProfilerReportInterval", 0);
+  kMemoryReportInterval = misc_utils_ns::getParam<int>(nh, "kMemoryReportInterval", 20);
 
   // Double
   kKeyposeCloudDwzFilterLeafSize = misc_utils_ns::getParam<double>(nh, "kKeyposeCloudDwzFilterLeafSize", 0.2);
@@ -53,6 +72,8 @@ bool PlannerParameters::ReadParameters(ros::NodeHandle& nh)
   kTerrainCollisionThreshold = misc_utils_ns::getParam<double>(nh, "kTerrainCollisionThreshold", 0.5);
   kLookAheadDistance = misc_utils_ns::getParam<double>(nh, "kLookAheadDistance", 5.0);
   kExtendWayPointDistance = misc_utils_ns::getParam<double>(nh, "kExtendWayPointDistance", 8.0);
+  kProfilerHistogramWindow = misc_utils_ns::getParam<double>(nh, "kProfilerHistogramWindow", 60.0);
+  kVisualizationMaxRate = misc_utils_ns::getParam<double>(nh, "kVisualizationMaxRate", 0.0);
 
   return true;
 }
@@ -140,6 +161,37 @@ void PlannerData::Initialize(ros::NodeHandle& nh, ros::NodeHandle& nh_p)
   keypose_graph_->SetAddNonKeyposeNodeMinDist() = add_non_keypose_node_min_dist;
 }
 
+void PlannerData::GetMemoryUsage(misc_utils_ns::MemoryReport& report) const
+{
+  const std::string kModule = "planner_data";
+  report.Add(kModule, "visited positions",
+             visited_positions_.GetMemoryBytes() + misc_utils_ns::GetVectorBytes(active_visited_positions_));
+  report.Add(kModule, "keypose and scan clouds",
+             misc_utils_ns::GetCloudPtrBytes(keypose_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(registered_scan_stack_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(registered_cloud_->cloud_));
+  report.Add(kModule, "terrain clouds",
+             misc_utils_ns::GetCloudPtrBytes(large_terrain_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(terrain_collision_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(terrain_ext_collision_cloud_->cloud_));
+  report.Add(kModule, "visualization clouds",
+             misc_utils_ns::GetCloudPtrBytes(viewpoint_vis_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(grid_world_vis_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(selected_viewpoint_vis_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(exploring_cell_vis_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(exploration_path_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(collision_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(lookahead_point_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(keypose_graph_vis_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(viewpoint_in_collision_cloud_->cloud_) +
+                 misc_utils_ns::GetCloudPtrBytes(point_cloud_manager_neighbor_cloud_->cloud_));
+  planning_env_->GetMemoryUsage(report);
+  viewpoint_manager_->GetMemoryUsage(report);
+  local_coverage_planner_->GetMemoryUsage(report);
+  keypose_graph_->GetMemoryUsage(report);
+  grid_world_->GetMemoryUsage(report);
+}
+
 SensorCoveragePlanner3D::SensorCoveragePlanner3D(ros::NodeHandle& nh, ros::NodeHandle& nh_p)
   : keypose_cloud_update_(false)
   , initialized_(false)
@@ -155,11 +207,20 @@ SensorCoveragePlanner3D::SensorCoveragePlanner3D(ros::NodeHandle& nh, ros::NodeH
   , step_(false)
   , registered_cloud_count_(0)
   , keypose_count_(0)
+  , profiler_report_count_(0)
+  , memory_report_count_(0)
 {
   initialize(nh, nh_p);
   PrintExplorationStatus("Exploration Started", false);
 }
 
+SensorCoveragePlanner3D::~SensorCoveragePlanner3D()
+{
+  // Join the visualization worker while ROS is still up, its function-local instance would otherwise be joined during
+  // static destruction
+  misc_utils_ns::VisualizationWorker::GetInstance().SetEnabled(false);
+}
+
 bool SensorCoveragePlanner3D::initialize(ros::NodeHandle& nh, ros::NodeHandle& nh_p)
 {
   if (!pp_.ReadParameters(nh_p))
@@ -168,12 +229,26 @@ bool SensorCoveragePlanner3D::initialize(ros::NodeHandle& nh, ros::NodeHandle& n
     return false;
   }
 
+  misc_utils_ns::VisualizationGate::SetHeadless(pp_.kHeadless);
+  misc_utils_ns::VisualizationGate::SetDefaultMaxRate(pp_.kVisualizationMaxRate);
+  misc_utils_ns::VisualizationWorker::GetInstance().SetEnabled(pp_.kUseVisualizationThread && !pp_.kHeadless);
+
   pd_.Initialize(nh, nh_p);
 
+  scan_stack_downsizer_.SetLeafSize(pp_.kKeyposeCloudDwzFilterLeafSize, pp_.kKeyposeCloudDwzFilterLeafSize,
+                                    pp_.kKeyposeCloudDwzFilterLeafSize);
+  registered_cloud_downsizer_.SetLeafSize(pp_.kKeyposeCloudDwzFilterLeafSize, pp_.kKeyposeCloudDwzFilterLeafSize,
+                                          pp_.kKeyposeCloudDwzFilterLeafSize);
+
   pd_.keypose_graph_->SetAllowVerticalEdge(false);
 
   // pd_.robot_viewpoint_.setCloudDWZResol(pp_.kKeyposeCloudDwzFilterLeafSize);
   lidar_model_ns::LiDARModel::setCloudDWZResol(pd_.planning_env_->GetPlannerCloudResolution());
+  // The robot uses the same sensor model as the viewpoints
+  pd_.robot_viewpoint_.Resize(pd_.viewpoint_manager_->GetLiDARModelType(), 1);
+
+  misc_utils_ns::Profiler::GetInstance().SetEnabled(pp_.kEnableProfiler);
+  misc_utils_ns::Profiler::GetInstance().SetHistogramWindow(pp_.kProfilerHistogramWindow);
 
   execution_timer_ = nh.createTimer(ros::Duration(0.5), &SensorCoveragePlanner3D::execute, this);
 
@@ -192,6 +267,10 @@ bool SensorCoveragePlanner3D::initialize(ros::NodeHandle& nh, ros::NodeHandle& n
       nh.subscribe(pp_.sub_viewpoint_boundary_topic_, 1, &SensorCoveragePlanner3D::ViewPointBoundaryCallback, this);
   nogo_boundary_sub_ =
       nh.subscribe(pp_.sub_nogo_boundary_topic_, 1, &SensorCoveragePlanner3D::NogoBoundaryCallback, this);
+  profiler_export_sub_ =
+      nh.subscribe(pp_.sub_profiler_export_topic_, 1, &SensorCoveragePlanner3D::ProfilerExportCallback, this);
+  memory_report_export_sub_ = nh.subscribe(pp_.sub_memory_report_export_topic_, 1,
+                                           &SensorCoveragePlanner3D::MemoryReportExportCallback, this);
 
   global_path_full_publisher_ = nh.advertise<nav_msgs::Path>("global_path_full", 1);
   global_path_publisher_ = nh.advertise<nav_msgs::Path>("global_path", 1);
@@ -201,6 +280,8 @@ bool SensorCoveragePlanner3D::initialize(ros::NodeHandle& nh, ros::NodeHandle& n
   exploration_finish_pub_ = nh.advertise<std_msgs::Bool>(pp_.pub_exploration_finish_topic_, 2);
   runtime_breakdown_pub_ = nh.advertise<std_msgs::Int32MultiArray>(pp_.pub_runtime_breakdown_topic_, 2);
   runtime_pub_ = nh.advertise<std_msgs::Float32>(pp_.pub_runtime_topic_, 2);
+  memory_report_pub_ = nh.advertise<std_msgs::String>(pp_.pub_memory_report_topic_, 1);
+  planning_cycle_pub_ = nh.advertise<std_msgs::Header>(pp_.pub_planning_cycle_topic_, 5);
   // Debug
   pointcloud_manager_neighbor_cells_origin_pub_ =
       nh.advertise<geometry_msgs::PointStamped>("pointcloud_manager_neighbor_cells_origin", 1);
@@ -252,32 +333,43 @@ void SensorCoveragePlanner3D::RegisteredScanCallback(const sensor_msgs::PointClo
   {
     return;
   }
-  pcl::PointCloud<pcl::PointXYZ>::Ptr registered_scan_tmp(new pcl::PointCloud<pcl::PointXYZ>());
-  pcl::fromROSMsg(*registered_scan_msg, *registered_scan_tmp);
-  if (registered_scan_tmp->points.empty())
+  PROFILE_SCOPE("registered scan callback");
+  // 一次遍历消息: 拼接传感器输入的点云, 同时对当前帧点云降采样
+  pointcloud_utils_ns::PointCloud2Reader scan_reader(*registered_scan_msg);
+  scan_reader.ForEach([&](float x, float y, float z, float /*intensity*/) {
+    pcl::PointXYZ stack_point;
+    stack_point.x = x;
+    stack_point.y = y;
+    stack_point.z = z;
+    scan_stack_downsizer_.Add(stack_point);
+    pcl::PointXYZI point;
+    point.x = x;
+    point.y = y;
+    point.z = z;
+    point.intensity = 0;
+    registered_cloud_downsizer_.Add(point);
+  });
+  if (registered_cloud_downsizer_.GetVoxelNumber() == 0)
   {
     return;
   }
-  // 拼接传感器输入的点云
-  *(pd_.registered_scan_stack_->cloud_) += *(registered_scan_tmp);
-  pointcloud_downsizer_.Downsize(registered_scan_tmp, pp_.kKeyposeCloudDwzFilterLeafSize,
-                                 pp_.kKeyposeCloudDwzFilterLeafSize, pp_.kKeyposeCloudDwzFilterLeafSize);
-  pd_.registered_cloud_->cloud_->clear();
-  pcl::copyPointCloud(*registered_scan_tmp, *(pd_.registered_cloud_->cloud_));
+  registered_cloud_downsizer_.Flush(*(pd_.registered_cloud_->cloud_));
 
+  misc_utils_ns::ProfileZone update_planning_env_zone(PROFILE_ZONE_ID("update planning env"));
   pd_.planning_env_->UpdateRobotPosition(pd_.robot_position_);
   pd_.planning_env_->UpdateRegisteredCloud<pcl::PointXYZI>(pd_.registered_cloud_->cloud_);
+  update_planning_env_zone.Stop();
 
   registered_cloud_count_ = (registered_cloud_count_ + 1) % 5;
   if (registered_cloud_count_ == 0)
   {
     // initialized_ = true;
+    PROFILE_SCOPE("add keypose");
     pd_.keypose_.pose.pose.position = pd_.robot_position_;
     pd_.keypose_.pose.covariance[0] = keypose_count_++;
     pd_.cur_keypose_node_ind_ = pd_.keypose_graph_->AddKeyposeNode(pd_.keypose_, *(pd_.planning_env_));
 
-    pointcloud_downsizer_.Downsize(pd_.registered_scan_stack_->cloud_, pp_.kKeyposeCloudDwzFilterLeafSize,
-                                   pp_.kKeyposeCloudDwzFilterLeafSize, pp_.kKeyposeCloudDwzFilterLeafSize);
+    scan_stack_downsizer_.Flush(*(pd_.registered_scan_stack_->cloud_));
     // 连续5帧拼接点云
     pd_.keypose_cloud_->cloud_->clear();
     pcl::copyPointCloud(*(pd_.registered_scan_stack_->cloud_), *(pd_.keypose_cloud_->cloud_));
@@ -289,38 +381,73 @@ void SensorCoveragePlanner3D::RegisteredScanCallback(const sensor_msgs::PointClo
 
 void SensorCoveragePlanner3D::TerrainMapCallback(const sensor_msgs::PointCloud2ConstPtr& terrain_map_msg)
 {
+  PROFILE_SCOPE("terrain map callback");
   if (pp_.kCheckTerrainCollision)
   {
-    pcl::PointCloud<pcl::PointXYZI>::Ptr terrain_map_tmp(new pcl::PointCloud<pcl::PointXYZI>());
-    pcl::fromROSMsg<pcl::PointXYZI>(*terrain_map_msg, *terrain_map_tmp);
-    pd_.terrain_collision_cloud_->cloud_->clear();
-    for (auto& point : terrain_map_tmp->points)
-    {
-      if (point.intensity > pp_.kTerrainCollisionThreshold)
+    pcl::PointCloud<pcl::PointXYZI>::Ptr& collision_cloud = pd_.terrain_collision_cloud_->cloud_;
+    collision_cloud->clear();
+    pointcloud_utils_ns::PointCloud2Reader terrain_reader(*terrain_map_msg);
+    terrain_reader.ForEach([&](float x, float y, float z, float intensity) {
+      if (intensity > pp_.kTerrainCollisionThreshold)
       {
-        pd_.terrain_collision_cloud_->cloud_->points.push_back(point);
+        pcl::PointXYZI point;
+        point.x = x;
+        point.y = y;
+        point.z = z;
+        point.intensity = intensity;
+        collision_cloud->points.push_back(point);
       }
-    }
+    });
+    collision_cloud->width = collision_cloud->points.size();
+    collision_cloud->height = 1;
   }
 }
 
 void SensorCoveragePlanner3D::TerrainMapExtCallback(const sensor_msgs::PointCloud2ConstPtr& terrain_map_ext_msg)
 {
+  PROFILE_SCOPE("terrain map ext callback");
+  if (!pp_.kUseTerrainHeight && !pp_.kCheckTerrainCollision)
+  {
+    return;
+  }
+  // 一次遍历消息同时得到地形高度点云和碰撞点云
+  pcl::PointCloud<pcl::PointXYZI>::Ptr& terrain_cloud = pd_.large_terrain_cloud_->cloud_;
+  pcl::PointCloud<pcl::PointXYZI>::Ptr& collision_cloud = pd_.terrain_ext_collision_cloud_->cloud_;
+  pointcloud_utils_ns::PointCloud2Reader terrain_reader(*terrain_map_ext_msg);
+  terrain_cloud->clear();
   if (pp_.kUseTerrainHeight)
   {
-    pcl::fromROSMsg<pcl::PointXYZI>(*terrain_map_ext_msg, *(pd_.large_terrain_cloud_->cloud_));
+    terrain_cloud->points.reserve(terrain_reader.GetPointNumber());
   }
   if (pp_.kCheckTerrainCollision)
   {
-    pcl::fromROSMsg<pcl::PointXYZI>(*terrain_map_ext_msg, *(pd_.large_terrain_cloud_->cloud_));
-    pd_.terrain_ext_collision_cloud_->cloud_->clear();
-    for (auto& point : pd_.large_terrain_cloud_->cloud_->points)
+    collision_cloud->clear();
+  }
+  terrain_reader.ForEach([&](float x, float y, float z, float intensity) {
+    pcl::PointXYZI point;
+    point.x = x;
+    point.y = y;
+    point.z = z;
+    point.intensity = intensity;
+    if (pp_.kUseTerrainHeight)
     {
-      if (point.intensity > pp_.kTerrainCollisionThreshold)
-      {
-        pd_.terrain_ext_collision_cloud_->cloud_->points.push_back(point);
-      }
+      terrain_cloud->points.push_back(point);
     }
+    if (pp_.kCheckTerrainCollision && intensity > pp_.kTerrainCollisionThreshold)
+    {
+      collision_cloud->points.push_back(point);
+    }
+  });
+  terrain_cloud->width = terrain_cloud->points.size();
+  terrain_cloud->height = 1;
+  if (pp_.kCheckTerrainCollision)
+  {
+    collision_cloud->width = collision_cloud->points.size();
+    collision_cloud->height = 1;
+  }
+  if (pp_.kUseTerrainHeight)
+  {
+    pd_.viewpoint_manager_->UpdateTerrainHeightMap(terrain_cloud);
   }
 }
 
@@ -361,6 +488,7 @@ void SensorCoveragePlanner3D::NogoBoundaryCallback(const geometry_msgs::PolygonS
   nogo_boundary.push_back(polygon);
   pd_.viewpoint_manager_->UpdateNogoBoundary(nogo_boundary);
 
+  // The marker accumulates every boundary received, so it is extended even when nothing is published
   geometry_msgs::Point point;
   for (int i = 0; i < nogo_boundary.size(); i++)
   {
@@ -387,6 +515,45 @@ void SensorCoveragePlanner3D::NogoBoundaryCallback(const geometry_msgs::PolygonS
   pd_.nogo_boundary_marker_->Publish();
 }
 
+void SensorCoveragePlanner3D::ProfilerExportCallback(const std_msgs::String::ConstPtr& file_path_msg)
+{
+  std::string file_path = file_path_msg->data.empty() ? pp_.kProfilerTraceFile : file_path_msg->data;
+  if (misc_utils_ns::Profiler::GetInstance().ExportChromeTrace(file_path))
+  {
+    ROS_INFO_STREAM("Profiler trace exported to " << file_path);
+  }
+  else
+  {
+    ROS_WARN_STREAM("Failed to export profiler trace to " << file_path);
+  }
+  // Per-zone percentiles next to the trace, e.g. trace.json -> trace_summary.json
+  std::string summary_file_path = file_path;
+  std::size_t extension_pos = summary_file_path.rfind(".json");
+  if (extension_pos != std::string::npos)
+  {
+    summary_file_path.erase(extension_pos);
+  }
+  summary_file_path += "_summary.json";
+  if (misc_utils_ns::Profiler::GetInstance().ExportSummary(summary_file_path))
+  {
+    ROS_INFO_STREAM("Profiler summary exported to " << summary_file_path);
+  }
+}
+
+void SensorCoveragePlanner3D::MemoryReportExportCallback(const std_msgs::String::ConstPtr& file_path_msg)
+{
+  std::string file_path = file_path_msg->data.empty() ? pp_.kMemoryReportFile : file_path_msg->data;
+  UpdateMemoryReport(true);
+  if (memory_report_.Export(file_path))
+  {
+    ROS_INFO_STREAM("Memory report exported to " << file_path);
+  }
+  else
+  {
+    ROS_WARN_STREAM("Failed to export memory report to " << file_path);
+  }
+}
+
 // step1
 void SensorCoveragePlanner3D::SendInitialWaypoint()
 {
@@ -408,6 +575,7 @@ void SensorCoveragePlanner3D::SendInitialWaypoint()
 // step2
 void SensorCoveragePlanner3D::UpdateGlobalRepresentation()
 {
+  PROFILE_SCOPE("update global representation");
   pd_.local_coverage_planner_->SetRobotPosition(
       Eigen::Vector3d(pd_.robot_position_.x, pd_.robot_position_.y, pd_.robot_position_.z));
   // 机器人移动后，判断局部viewpoint地图是否滚动(更新)
@@ -416,21 +584,25 @@ void SensorCoveragePlanner3D::UpdateGlobalRepresentation()
 
   misc_utils_ns::Timer grid_world_timer("update grid_world");
   grid_world_timer.Start();
+  misc_utils_ns::ProfileZone grid_world_zone(PROFILE_ZONE_ID("update grid_world"));
 
   // "grid_world_"管理global的subspaces(以cell为单位)
   if (!pd_.grid_world_->Initialized() || viewpoint_rollover)
   {
     pd_.grid_world_->UpdateNeighborCells(pd_.robot_position_);
   }
+  grid_world_zone.Stop();
   grid_world_timer.Stop(true);
 
   misc_utils_ns::Timer pointcloud_manager_timer("update pointcloud_manager");
   pointcloud_manager_timer.Start();
+  misc_utils_ns::ProfileZone pointcloud_manager_zone(PROFILE_ZONE_ID("update pointcloud_manager"));
 
   // 其中的"pointcloud_manager_"维护一个全局的点云地图
   pd_.planning_env_->UpdateRobotPosition(pd_.robot_position_);
-  pd_.planning_env_->GetVisualizationPointCloud(pd_.point_cloud_manager_neighbor_cloud_->cloud_);
-  pd_.point_cloud_manager_neighbor_cloud_->Publish();  // topic_name: "/pointcloud_manager_cloud"
+  // topic_name: "/pointcloud_manager_cloud"
+  pd_.point_cloud_manager_neighbor_cloud_->PublishLazily(
+      [&]() { pd_.planning_env_->GetVisualizationPointCloud(pd_.point_cloud_manager_neighbor_cloud_->cloud_); });
 
   // DEBUG
   Eigen::Vector3d pointcloud_manager_neighbor_cells_origin =
@@ -450,6 +622,7 @@ void SensorCoveragePlanner3D::UpdateGlobalRepresentation()
   }
   // pub "~/planner_cloud" and "~/filtered_frontier_cloud"
   pd_.planning_env_->UpdateKeyposeCloud<PlannerCloudPointType>(pd_.keypose_cloud_->cloud_);
+  pointcloud_manager_zone.Stop();
   pointcloud_manager_timer.Stop(true);
 
   int closest_node_ind = pd_.keypose_graph_->GetClosestNodeInd(pd_.robot_position_);
@@ -481,16 +654,18 @@ void SensorCoveragePlanner3D::UpdateGlobalRepresentation()
 // step3, update viewpoint manager
 int SensorCoveragePlanner3D::UpdateViewPoints()
 {
+  PROFILE_SCOPE("update viewpoints");
   misc_utils_ns::Timer collision_cloud_timer("update collision cloud");
   collision_cloud_timer.Start();
-  pd_.collision_cloud_->cloud_ = pd_.planning_env_->GetCollisionCloud();
+  // Copied, the terrain collision points are added below and the planning env cloud is a view of its voxel map
+  *(pd_.collision_cloud_->cloud_) = *(pd_.planning_env_->GetCollisionCloud());
   collision_cloud_timer.Stop(false);
 
   misc_utils_ns::Timer viewpoint_manager_update_timer("update viewpoint manager");
   viewpoint_manager_update_timer.Start();
   if (pp_.kUseTerrainHeight)
   {
-    pd_.viewpoint_manager_->SetViewPointHeightWithTerrain(pd_.large_terrain_cloud_->cloud_);
+    pd_.viewpoint_manager_->SetViewPointHeightWithTerrain();
   }
   if (pp_.kCheckTerrainCollision)
   {
@@ -500,21 +675,35 @@ int SensorCoveragePlanner3D::UpdateViewPoints()
   pd_.collision_cloud_->Publish();  // topic_name: "collision_cloud"
   // pd_.collision_grid_cloud_->Publish();
 
-  pd_.viewpoint_manager_->CheckViewPointCollision(pd_.collision_cloud_->cloud_);
-  pd_.viewpoint_manager_->CheckViewPointLineOfSight();
-  pd_.viewpoint_manager_->CheckViewPointConnectivity();
+  {
+    PROFILE_SCOPE("check viewpoint collision");
+    pd_.viewpoint_manager_->CheckViewPointCollision(pd_.collision_cloud_->cloud_);
+  }
+  {
+    PROFILE_SCOPE("check viewpoint line of sight");
+    pd_.viewpoint_manager_->CheckViewPointLineOfSight();
+  }
+  {
+    PROFILE_SCOPE("check viewpoint connectivity");
+    pd_.viewpoint_manager_->CheckViewPointConnectivity();
+  }
+  misc_utils_ns::ProfileZone viewpoint_candidate_zone(PROFILE_ZONE_ID("get viewpoint candidate"));
   int viewpoint_candidate_count = pd_.viewpoint_manager_->GetViewPointCandidate();
+  viewpoint_candidate_zone.Stop();
 
+  misc_utils_ns::ProfileZone viewpoint_visited_zone(PROFILE_ZONE_ID("update viewpoint visited"));
   UpdateVisitedPositions();  // push "robot_position_" to "visited_positions_"
   // 当前位置周围以及当前cell内的viewpoint都设置为visited
-  pd_.viewpoint_manager_->UpdateViewPointVisited(pd_.visited_positions_);
+  pd_.viewpoint_manager_->UpdateViewPointVisited(pd_.active_visited_positions_);
   pd_.viewpoint_manager_->UpdateViewPointVisited(pd_.grid_world_);
-  pd_.viewpoint_manager_->GetVisualizationCloud(pd_.viewpoint_vis_cloud_->cloud_);
+  viewpoint_visited_zone.Stop();
   // 包含I通道数据，已访问的vp为-1(可视化为红色)，其余表示"CoveredPointNum"(s紫色最大)
-  pd_.viewpoint_vis_cloud_->Publish();
+  pd_.viewpoint_vis_cloud_->PublishLazily(
+      [&]() { pd_.viewpoint_manager_->GetVisualizationCloud(pd_.viewpoint_vis_cloud_->cloud_); });
 
-  pd_.viewpoint_manager_->GetCollisionViewPointVisCloud(pd_.viewpoint_in_collision_cloud_->cloud_);
-  pd_.viewpoint_in_collision_cloud_->Publish();  // "viewpoint_in_collision_cloud_"
+  // "viewpoint_in_collision_cloud_"
+  pd_.viewpoint_in_collision_cloud_->PublishLazily(
+      [&]() { pd_.viewpoint_manager_->GetCollisionViewPointVisCloud(pd_.viewpoint_in_collision_cloud_->cloud_); });
 
   viewpoint_manager_update_timer.Stop(true);
   return viewpoint_candidate_count;
@@ -524,38 +713,34 @@ int SensorCoveragePlanner3D::UpdateViewPoints()
 void SensorCoveragePlanner3D::UpdateVisitedPositions()
 {
   Eigen::Vector3d robot_current_position(pd_.robot_position_.x, pd_.robot_position_.y, pd_.robot_position_.z);
-  bool existing = false;
-  for (int i = 0; i < pd_.visited_positions_.size(); i++)
-  {
-    // TODO: parameterize this
-    if ((robot_current_position - pd_.visited_positions_[i]).norm() < 1)
-    {
-      existing = true;
-      break;
-    }
-  }
-  if (!existing)
-  {
-    pd_.visited_positions_.push_back(robot_current_position);
-  }
+  // Only positions within the local planning horizon can mark viewpoints visited, the rest stay archived
+  pd_.visited_positions_.UpdateActiveRange(robot_current_position,
+                                           pd_.viewpoint_manager_->GetLocalPlanningHorizonSize());
+  pd_.visited_positions_.Insert(robot_current_position);
+  pd_.visited_positions_.GetActivePositions(pd_.active_visited_positions_);
 }
 
 // step4
 void SensorCoveragePlanner3D::UpdateKeyposeGraph()
 {
+  PROFILE_SCOPE("update keypose graph");
   misc_utils_ns::Timer update_keypose_graph_timer("update keypose graph");
   update_keypose_graph_timer.Start();
 
   // graph_node可视化，绿色表示已经connected的node，红色未连接
-  pd_.keypose_graph_->GetMarker(pd_.keypose_graph_node_marker_->marker_, pd_.keypose_graph_edge_marker_->marker_);
-  pd_.keypose_graph_node_marker_->Publish();
-  pd_.keypose_graph_edge_marker_->Publish();
+  if (pd_.keypose_graph_node_marker_->HasSubscribers() || pd_.keypose_graph_edge_marker_->HasSubscribers())
+  {
+    pd_.keypose_graph_->GetMarker(pd_.keypose_graph_node_marker_->marker_, pd_.keypose_graph_edge_marker_->marker_);
+    pd_.keypose_graph_node_marker_->Publish();
+    pd_.keypose_graph_edge_marker_->Publish();
+  }
 
-  pd_.keypose_graph_vis_cloud_->cloud_->clear();
   pd_.keypose_graph_->CheckLocalCollision(pd_.robot_position_, pd_.viewpoint_manager_);
   pd_.keypose_graph_->CheckConnectivity(pd_.robot_position_);
-  pd_.keypose_graph_->GetVisualizationCloud(pd_.keypose_graph_vis_cloud_->cloud_);
-  pd_.keypose_graph_vis_cloud_->Publish();
+  pd_.keypose_graph_vis_cloud_->PublishLazily([&]() {
+    pd_.keypose_graph_vis_cloud_->cloud_->clear();
+    pd_.keypose_graph_->GetVisualizationCloud(pd_.keypose_graph_vis_cloud_->cloud_);
+  });
 
   update_keypose_graph_timer.Stop(true);
 }
@@ -563,6 +748,7 @@ void SensorCoveragePlanner3D::UpdateKeyposeGraph()
 // step5
 void SensorCoveragePlanner3D::UpdateViewPointCoverage()
 {
+  PROFILE_SCOPE("update viewpoint coverage");
   // Update viewpoint coverage
   misc_utils_ns::Timer update_coverage_timer("update viewpoint coverage");
   update_coverage_timer.Start();
@@ -573,10 +759,8 @@ void SensorCoveragePlanner3D::UpdateViewPointCoverage()
   // std::cout << "collision cloud size: " << pd_.planning_env_->GetCollisionCloud()->points.size() << std::endl;
   // std::cout << "planner cloud size: " << pd_.planning_env_->GetPlannerCloud()->points.size() << std::endl;
   // Update robot coverage
-  pd_.robot_viewpoint_.ResetCoverage();
-  geometry_msgs::Pose robot_pose;
-  robot_pose.position = pd_.robot_position_;
-  pd_.robot_viewpoint_.setPose(robot_pose);
+  pd_.robot_viewpoint_.ResetCoverage(0);
+  pd_.robot_viewpoint_.SetPosition(0, pd_.robot_position_);
   UpdateRobotViewPointCoverage();
   update_coverage_timer.Stop(true);
 }
@@ -584,34 +768,42 @@ void SensorCoveragePlanner3D::UpdateViewPointCoverage()
 // "UpdateViewPointCoverage(step5)"中调用
 void SensorCoveragePlanner3D::UpdateRobotViewPointCoverage()
 {
+  PROFILE_SCOPE("update robot viewpoint coverage");
   pcl::PointCloud<pcl::PointXYZI>::Ptr cloud = pd_.planning_env_->GetCollisionCloud();
-  for (const auto& point : cloud->points)
-  {
-    if (pd_.viewpoint_manager_->InFOVAndRange(
-            Eigen::Vector3d(point.x, point.y, point.z),
-            Eigen::Vector3d(pd_.robot_position_.x, pd_.robot_position_.y, pd_.robot_position_.z)))
+  pd_.robot_viewpoint_.Visit([&](auto& lidar_models) {
+    for (const auto& point : cloud->points)
     {
-      pd_.robot_viewpoint_.UpdateCoverage<pcl::PointXYZI>(point);
+      if (pd_.viewpoint_manager_->InFOVAndRange(
+              Eigen::Vector3d(point.x, point.y, point.z),
+              Eigen::Vector3d(pd_.robot_position_.x, pd_.robot_position_.y, pd_.robot_position_.z)))
+      {
+        lidar_models[0].template UpdateCoverage<pcl::PointXYZI>(point);
+      }
     }
-  }
+  });
 }
 
 // step6
 void SensorCoveragePlanner3D::UpdateCoveredAreas(int& uncovered_point_num, int& uncovered_frontier_point_num)
 {
+  PROFILE_SCOPE("update covered areas");
   // Update covered area
   misc_utils_ns::Timer update_coverage_area_timer("update covered area");
   update_coverage_area_timer.Start();
+  misc_utils_ns::ProfileZone update_coverage_area_zone(PROFILE_ZONE_ID("update covered area"));
   // 更新"PlanningEnv::planner_cloud_"，当前位置以及已访问的viewpoints视野内的点云mark为covered(g=255)
   pd_.planning_env_->UpdateCoveredArea(pd_.robot_viewpoint_, pd_.viewpoint_manager_);
+  update_coverage_area_zone.Stop();
   update_coverage_area_timer.Stop(true);
 
   misc_utils_ns::Timer get_uncovered_area_timer("get uncovered area");
   get_uncovered_area_timer.Start();
+  misc_utils_ns::ProfileZone get_uncovered_area_zone(PROFILE_ZONE_ID("get uncovered area"));
   // 更新"PlanningEnv::uncovered_cloud_"以及"uncovered_frontier_cloud_"
   pd_.planning_env_->GetUncoveredArea(pd_.viewpoint_manager_, uncovered_point_num, uncovered_frontier_point_num);
   // std::cout << "uncovered point number: " << uncovered_point_num << std::endl;
   // std::cout << "uncovered frontier point number: " << uncovered_frontier_point_num << std::endl;
+  get_uncovered_area_zone.Stop();
   get_uncovered_area_timer.Stop(true);
 
   // pd_.planning_env_->PublishUncoveredCloud();  // topic: "uncovered_cloud"
@@ -622,12 +814,18 @@ void SensorCoveragePlanner3D::UpdateCoveredAreas(int& uncovered_point_num, int&
 void SensorCoveragePlanner3D::GlobalPlanning(std::vector<int>& global_cell_tsp_order,
                                              exploration_path_ns::ExplorationPath& global_path)
 {
+  PROFILE_SCOPE("global planning");
   misc_utils_ns::Timer global_tsp_timer("Global planning");
   global_tsp_timer.Start();
 
+  misc_utils_ns::ProfileZone update_cell_zone(PROFILE_ZONE_ID("update cells"));
   pd_.grid_world_->UpdateCellStatus(pd_.viewpoint_manager_);
   pd_.grid_world_->UpdateCellKeyposeGraphNodes(pd_.keypose_graph_);
-  pd_.grid_world_->AddPathsInBetweenCells(pd_.viewpoint_manager_, pd_.keypose_graph_);
+  update_cell_zone.Stop();
+  {
+    PROFILE_SCOPE("add paths in between cells");
+    pd_.grid_world_->AddPathsInBetweenCells(pd_.viewpoint_manager_, pd_.keypose_graph_);
+  }
 
   pd_.viewpoint_manager_->UpdateCandidateViewPointCellStatus(pd_.grid_world_);
 
@@ -641,6 +839,7 @@ void SensorCoveragePlanner3D::GlobalPlanning(std::vector<int>& global_cell_tsp_o
 void SensorCoveragePlanner3D::PublishGlobalPlanningVisualization(
     const exploration_path_ns::ExplorationPath& global_path, const exploration_path_ns::ExplorationPath& local_path)
 {
+  PROFILE_SCOPE("publish global planning visualization");
   // "~/global_path_full"(nav_msgs::Path)
   nav_msgs::Path global_path_full = global_path.GetPath();
   global_path_full.header.frame_id = "map";
@@ -702,11 +901,11 @@ void SensorCoveragePlanner3D::PublishGlobalPlanningVisualization(
   // "~/global_path"(nav_msgs::Path) 局部地图范围外的全局travel path
   global_path_publisher_.publish(global_path_trim);
 
-  pd_.grid_world_->GetVisualizationCloud(pd_.grid_world_vis_cloud_->cloud_);
-  pd_.grid_world_vis_cloud_->Publish();  // topic: "~/grid_world_vis_cloud"
-  pd_.grid_world_->GetMarker(pd_.grid_world_marker_->marker_);
+  // topic: "~/grid_world_vis_cloud"
+  pd_.grid_world_vis_cloud_->PublishLazily(
+      [&]() { pd_.grid_world_->GetVisualizationCloud(pd_.grid_world_vis_cloud_->cloud_); });
   // "~/grid_world_marker"(visualization_msgs::Marker) 黄色Marker表示"Covered"，绿色"Exploring"
-  pd_.grid_world_marker_->Publish();
+  pd_.grid_world_marker_->PublishLazily([&]() { pd_.grid_world_->GetMarker(pd_.grid_world_marker_->marker_); });
 
   // topic: "~/exploration_path"
   nav_msgs::Path full_path = pd_.exploration_path_.GetPath();
@@ -715,8 +914,8 @@ void SensorCoveragePlanner3D::PublishGlobalPlanningVisualization(
   exploration_path_publisher_.publish(full_path);
 
   // topic: "bspline_path_cloud"
-  pd_.exploration_path_.GetVisualizationCloud(pd_.exploration_path_cloud_->cloud_);
-  pd_.exploration_path_cloud_->Publish();
+  pd_.exploration_path_cloud_->PublishLazily(
+      [&]() { pd_.exploration_path_.GetVisualizationCloud(pd_.exploration_path_cloud_->cloud_); });
   // pd_.planning_env_->PublishStackedCloud();
 }
 
@@ -725,6 +924,7 @@ void SensorCoveragePlanner3D::LocalPlanning(int uncovered_point_num, int uncover
                                             const exploration_path_ns::ExplorationPath& global_path,
                                             exploration_path_ns::ExplorationPath& local_path)
 {
+  PROFILE_SCOPE("local planning");
   misc_utils_ns::Timer local_tsp_timer("Local planning");
   local_tsp_timer.Start();
   if (lookahead_point_update_)
@@ -739,6 +939,7 @@ void SensorCoveragePlanner3D::LocalPlanning(int uncovered_point_num, int uncover
 
 void SensorCoveragePlanner3D::PublishLocalPlanningVisualization(const exploration_path_ns::ExplorationPath& local_path)
 {
+  PROFILE_SCOPE("publish local planning visualization");
   // pd_.viewpoint_manager_->GetVisualizationCloud(pd_.viewpoint_vis_cloud_->cloud_);
   // // 包含I通道数据，已访问的vp为-1(可视化为红色)，其余表示"CoveredPointNum"(s紫色最大)
   // pd_.viewpoint_vis_cloud_->Publish();
@@ -750,9 +951,9 @@ void SensorCoveragePlanner3D::PublishLocalPlanningVisualization(const exploratio
   local_tsp_path.header.stamp = ros::Time::now();
   local_tsp_path_publisher_.publish(local_tsp_path);  // "~/local_path"，连接viewpoints
 
-  pd_.local_coverage_planner_->GetSelectedViewPointVisCloud(pd_.selected_viewpoint_vis_cloud_->cloud_);
   // "selected_viewpoint"可视化，红色是当前vp，绿色青色为局部边缘的vp(连接global path)，其余紫色
-  pd_.selected_viewpoint_vis_cloud_->Publish();
+  pd_.selected_viewpoint_vis_cloud_->PublishLazily(
+      [&]() { pd_.local_coverage_planner_->GetSelectedViewPointVisCloud(pd_.selected_viewpoint_vis_cloud_->cloud_); });
 
   // Visualize local planning horizon box
 }
@@ -829,6 +1030,7 @@ bool SensorCoveragePlanner3D::GetLookAheadPoint(const exploration_path_ns::Explo
                                                 const exploration_path_ns::ExplorationPath& global_path,
                                                 Eigen::Vector3d& lookahead_point)
 {
+  PROFILE_SCOPE("get lookahead point");
   misc_utils_ns::Timer lookahead_timer("get lookahead point");
   lookahead_timer.Start();
 
@@ -1159,6 +1361,7 @@ bool SensorCoveragePlanner3D::GetLookAheadPoint(const exploration_path_ns::Explo
 
 void SensorCoveragePlanner3D::PublishWaypoint()
 {
+  PROFILE_SCOPE("publish waypoint");
   geometry_msgs::PointStamped waypoint;
   if (exploration_finished_ && near_home_ && pp_.kRushHome)
   {
@@ -1219,6 +1422,51 @@ void SensorCoveragePlanner3D::PublishRuntime()
   runtime_pub_.publish(runtime_msg);  // topic: "/runtime"
 }
 
+void SensorCoveragePlanner3D::UpdateProfiler()
+{
+  misc_utils_ns::Profiler& profiler = misc_utils_ns::Profiler::GetInstance();
+  if (!profiler.IsEnabled())
+  {
+    return;
+  }
+  profiler.Collect();
+  if (pp_.kProfilerReportInterval > 0)
+  {
+    profiler_report_count_ = (profiler_report_count_ + 1) % pp_.kProfilerReportInterval;
+    if (profiler_report_count_ == 0)
+    {
+      std::stringstream report_stream;
+      profiler.PrintReport(report_stream);
+      ROS_INFO_STREAM("Profiler report:\n" << report_stream.str());
+    }
+  }
+}
+
+void SensorCoveragePlanner3D::UpdateMemoryReport(bool force)
+{
+  if (!force)
+  {
+    if (pp_.kMemoryReportInterval <= 0)
+    {
+      return;
+    }
+    memory_report_count_ = (memory_report_count_ + 1) % pp_.kMemoryReportInterval;
+    if (memory_report_count_ != 0)
+    {
+      return;
+    }
+  }
+  memory_report_.BeginSample();
+  pd_.GetMemoryUsage(memory_report_);
+  memory_report_.EndSample();
+
+  std::stringstream report_stream;
+  memory_report_.Print(report_stream);
+  std_msgs::String report_msg;
+  report_msg.data = report_stream.str();
+  memory_report_pub_.publish(report_msg);
+}
+
 double SensorCoveragePlanner3D::GetRobotToHomeDistance()
 {
   Eigen::Vector3d robot_position(pd_.robot_position_.x, pd_.robot_position_.y, pd_.robot_position_.z);
@@ -1245,7 +1493,17 @@ void SensorCoveragePlanner3D::PrintExplorationStatus(std::string status, bool cl
 }
 
 // timer, 1s执行周期
-void SensorCoveragePlanner3D::execute(const ros::TimerEvent&)
+void SensorCoveragePlanner3D::execute(const ros::TimerEvent& event)
+{
+  PlanningCycle();
+  // Also sent for skipped cycles, a lockstep simulator waits for one message per timer period
+  std_msgs::Header planning_cycle_msg;
+  planning_cycle_msg.stamp = event.current_expected;
+  planning_cycle_msg.frame_id = "map";
+  planning_cycle_pub_.publish(planning_cycle_msg);
+}
+
+void SensorCoveragePlanner3D::PlanningCycle()
 {
   ROS_INFO("SensorCoveragePlanner3D: Executing...");
   if (!pp_.kAutoStart && !start_exploration_)
@@ -1274,9 +1532,11 @@ void SensorCoveragePlanner3D::execute(const ros::TimerEvent&)
   {
     // 在RegisteredScanCallback中更新，关键帧
     keypose_cloud_update_ = false;
+    misc_utils_ns::ProfileZone execute_zone(PROFILE_ZONE_ID("execute"));
 
     misc_utils_ns::Timer update_representation_timer("update representation");
     update_representation_timer.Start();
+    misc_utils_ns::ProfileZone update_representation_zone(PROFILE_ZONE_ID("update representation"));
 
     // step2: Update grid world，更新"pd_.grid_world_"以及"pd_.planning_env_"两个变量
     // 包括更新机器人的当前位置和环境信息(viewpoints、cells(subspace)、以及pointcloud)
@@ -1310,6 +1570,7 @@ void SensorCoveragePlanner3D::execute(const ros::TimerEvent&)
       pd_.viewpoint_manager_->ResetViewPointCoverage();
     }
 
+    update_representation_zone.Stop();
     update_representation_timer.Stop(true);
     update_representation_runtime_ += update_representation_timer.GetDuration("ms");
 
@@ -1349,11 +1610,17 @@ void SensorCoveragePlanner3D::execute(const ros::TimerEvent&)
     PublishGlobalPlanningVisualization(global_path, local_path);
 
     // topic_name: "~/tare_visualizer/exploring_subspaces"
-    pd_.visualizer_->GetGlobalSubspaceMarker(pd_.grid_world_, global_cell_tsp_order);
-    // topic_name: "~/tare_visualizer/local_planning_horizon"
-    Eigen::Vector3d viewpoint_origin = pd_.viewpoint_manager_->GetOrigin();
-    pd_.visualizer_->GetLocalPlanningHorizonMarker(viewpoint_origin.x(), viewpoint_origin.y(), pd_.robot_position_.z);
-    pd_.visualizer_->PublishMarkers();
+    misc_utils_ns::ProfileZone visualizer_zone(PROFILE_ZONE_ID("publish markers"));
+    if (pd_.visualizer_->HasSubscribers())
+    {
+      pd_.visualizer_->GetGlobalSubspaceMarker(pd_.grid_world_, global_cell_tsp_order);
+      // topic_name: "~/tare_visualizer/local_planning_horizon"
+      Eigen::Vector3d viewpoint_origin = pd_.viewpoint_manager_->GetOrigin();
+      pd_.visualizer_->GetLocalPlanningHorizonMarker(viewpoint_origin.x(), viewpoint_origin.y(),
+                                                     pd_.robot_position_.z);
+      pd_.visualizer_->PublishMarkers();
+    }
+    visualizer_zone.Stop();
 
     // PublishLocalPlanningVisualization(local_path);
     // PublishGlobalPlanningVisualization(global_path, local_path);
@@ -1361,6 +1628,9 @@ void SensorCoveragePlanner3D::execute(const ros::TimerEvent&)
     overall_processing_timer.Stop(false);
     overall_runtime_ = overall_processing_timer.GetDuration("ms");
     ROS_WARN("Overall runtime: %d ms", overall_runtime_);
+    execute_zone.Stop();
+    UpdateProfiler();
+    UpdateMemoryReport();
   }
 
   // return true;
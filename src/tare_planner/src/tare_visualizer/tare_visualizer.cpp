@@ -184,6 +184,11 @@ void TAREVisualizer::GetGlobalSubspaceMarker(const std::unique_ptr<grid_world_ns
   }
 }
 
+bool TAREVisualizer::HasSubscribers() const
+{
+  return local_planning_horizon_marker_->HasSubscribers() || global_subspaces_marker_->HasSubscribers();
+}
+
 void TAREVisualizer::PublishMarkers()
 {
   local_planning_horizon_marker_->Publish();
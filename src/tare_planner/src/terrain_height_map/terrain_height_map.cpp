@@ -0,0 +1,108 @@
+/**
+ * @file terrain_height_map.cpp
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Class that implements a rolling 2.5D terrain elevation map aligned with the viewpoint grid
+ * @version 0.1
+ * @date 2021-06-19
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "terrain_height_map/terrain_height_map.h"
+#include <algorithm>
+
+namespace terrain_height_map_ns
+{
+TerrainHeightMap::TerrainHeightMap(const Eigen::Vector3i& size, const Eigen::Vector3d& resolution)
+  : size_(size.x(), size.y(), 1), resolution_(resolution), origin_(Eigen::Vector3d::Zero())
+{
+  grid_ = std::make_unique<rolling_grid_ns::RollingGrid>(size_);
+  cells_.resize(size_.x() * size_.y());
+}
+
+void TerrainHeightMap::SetOrigin(const Eigen::Vector3d& origin)
+{
+  origin_ = origin;
+  Reset();
+}
+
+void TerrainHeightMap::Roll(const Eigen::Vector3i& roll_step)
+{
+  Eigen::Vector3i roll_step_2d(roll_step.x(), roll_step.y(), 0);
+  if (roll_step_2d.x() == 0 && roll_step_2d.y() == 0)
+  {
+    return;
+  }
+  grid_->Roll(roll_step_2d);
+  origin_.x() -= roll_step_2d.x() * resolution_.x();
+  origin_.y() -= roll_step_2d.y() * resolution_.y();
+  grid_->GetUpdatedIndices(updated_indices_);
+  for (const auto& ind : updated_indices_)
+  {
+    cells_[grid_->GetArrayInd(ind)] = TerrainHeightCell();
+  }
+}
+
+void TerrainHeightMap::Reset()
+{
+  std::fill(cells_.begin(), cells_.end(), TerrainHeightCell());
+}
+
+void TerrainHeightMap::UpdateHeight(const pcl::PointCloud<pcl::PointXYZI>::Ptr& cloud, double intensity_threshold)
+{
+  for (const auto& point : cloud->points)
+  {
+    if (point.intensity > intensity_threshold)
+    {
+      continue;
+    }
+    Eigen::Vector3i sub = GetSub(Eigen::Vector3d(point.x, point.y, point.z));
+    if (!InRange(sub))
+    {
+      continue;
+    }
+    TerrainHeightCell& cell = cells_[grid_->GetArrayInd(sub)];
+    cell.min_z = std::min(cell.min_z, point.z);
+    cell.max_z = std::max(cell.max_z, point.z);
+    cell.sum_z += point.z;
+    cell.point_num++;
+  }
+}
+
+Eigen::Vector3i TerrainHeightMap::GetSub(const Eigen::Vector3d& position) const
+{
+  // Same convention as ViewPointManager::GetViewPointSub
+  Eigen::Vector3d diff = position - origin_;
+  Eigen::Vector3i sub = Eigen::Vector3i::Zero();
+  for (int i = 0; i < 2; i++)
+  {
+    sub(i) = diff(i) > 0 ? static_cast<int>(diff(i) / resolution_(i)) : -1;
+  }
+  return sub;
+}
+
+bool TerrainHeightMap::GetSmoothedMinHeight(const Eigen::Vector3i& sub, int radius, double& height) const
+{
+  double height_sum = 0.0;
+  int cell_num = 0;
+  for (int x = sub.x() - radius; x <= sub.x() + radius; x++)
+  {
+    for (int y = sub.y() - radius; y <= sub.y() + radius; y++)
+    {
+      Eigen::Vector3i neighbor_sub(x, y, 0);
+      if (InRange(neighbor_sub) && HasHeight(neighbor_sub))
+      {
+        height_sum += GetMinHeight(neighbor_sub);
+        cell_num++;
+      }
+    }
+  }
+  if (cell_num == 0)
+  {
+    return false;
+  }
+  height = height_sum / cell_num;
+  return true;
+}
+}  // namespace terrain_height_map_ns
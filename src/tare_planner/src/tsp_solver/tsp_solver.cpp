@@ -17,6 +17,7 @@ TSPSolver::TSPSolver(tsp_solver_ns::DataModel data) : data_(std::move(data))
 
 void TSPSolver::Solve()
 {
+  PROFILE_SCOPE("tsp solver");
   const int transit_callback_index =
       routing_->RegisterTransitCallback([this](int64 from_index, int64 to_index) -> int64 {
         // Convert from routing variable Index to distance matrix NodeIndex.
@@ -0,0 +1,193 @@
+/**
+ * @file memory_report.cpp
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Per-module memory accounting with high-water marks
+ * @version 0.1
+ * @date 2021-06-17
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "utils/memory_report.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <ros/ros.h>
+
+namespace misc_utils_ns
+{
+namespace
+{
+double ToMB(uint64_t bytes)
+{
+  return bytes / (1024.0 * 1024.0);
+}
+}  // namespace
+
+MemoryReport::MemoryReport() : total_bytes_(0), peak_total_bytes_(0), sample_count_(0)
+{
+}
+
+void MemoryReport::BeginSample()
+{
+  for (auto& module : modules_)
+  {
+    for (auto& category : module.second)
+    {
+      category.second.bytes = 0;
+    }
+  }
+  total_bytes_ = 0;
+}
+
+void MemoryReport::Add(const std::string& module, const std::string& category, uint64_t bytes)
+{
+  modules_[module][category].bytes += bytes;
+  total_bytes_ += bytes;
+}
+
+void MemoryReport::EndSample()
+{
+  for (auto& module : modules_)
+  {
+    uint64_t module_bytes = 0;
+    for (auto& category : module.second)
+    {
+      category.second.peak_bytes = std::max(category.second.peak_bytes, category.second.bytes);
+      module_bytes += category.second.bytes;
+    }
+    uint64_t& module_peak_bytes = module_peak_bytes_[module.first];
+    module_peak_bytes = std::max(module_peak_bytes, module_bytes);
+  }
+  peak_total_bytes_ = std::max(peak_total_bytes_, total_bytes_);
+  sample_count_++;
+}
+
+uint64_t MemoryReport::GetModuleBytes(const std::string& module) const
+{
+  uint64_t bytes = 0;
+  auto it = modules_.find(module);
+  if (it != modules_.end())
+  {
+    for (const auto& category : it->second)
+    {
+      bytes += category.second.bytes;
+    }
+  }
+  return bytes;
+}
+
+uint64_t MemoryReport::GetModulePeakBytes(const std::string& module) const
+{
+  auto it = module_peak_bytes_.find(module);
+  return it != module_peak_bytes_.end() ? it->second : 0;
+}
+
+void MemoryReport::Print(std::ostream& os) const
+{
+  std::ios::fmtflags flags = os.flags();
+  os << std::fixed << std::setprecision(2);
+  os << "---------------- memory (MB) ----------------" << std::endl;
+  os << std::left << std::setw(44) << "module/category" << std::right << std::setw(10) << "current" << std::setw(10)
+     << "peak" << std::endl;
+  for (const auto& module : modules_)
+  {
+    os << std::left << std::setw(44) << module.first << std::right << std::setw(10)
+       << ToMB(GetModuleBytes(module.first)) << std::setw(10) << ToMB(GetModulePeakBytes(module.first)) << std::endl;
+    for (const auto& category : module.second)
+    {
+      os << std::left << std::setw(44) << ("  " + category.first) << std::right << std::setw(10)
+         << ToMB(category.second.bytes) << std::setw(10) << ToMB(category.second.peak_bytes) << std::endl;
+    }
+  }
+  os << std::left << std::setw(44) << "accounted total" << std::right << std::setw(10) << ToMB(total_bytes_)
+     << std::setw(10) << ToMB(peak_total_bytes_) << std::endl;
+  uint64_t rss_bytes, peak_rss_bytes;
+  if (GetResidentMemory(rss_bytes, peak_rss_bytes))
+  {
+    os << std::left << std::setw(44) << "process resident" << std::right << std::setw(10) << ToMB(rss_bytes)
+       << std::setw(10) << ToMB(peak_rss_bytes) << std::endl;
+  }
+  os.flags(flags);
+}
+
+bool MemoryReport::Export(const std::string& file_path) const
+{
+  std::ofstream file(file_path);
+  if (!file.is_open())
+  {
+    ROS_WARN_STREAM("MemoryReport: cannot open " << file_path);
+    return false;
+  }
+  file << "{\"unit\":\"bytes\",\"samples\":" << sample_count_ << ",\"total\":" << total_bytes_
+       << ",\"peak_total\":" << peak_total_bytes_;
+  uint64_t rss_bytes, peak_rss_bytes;
+  if (GetResidentMemory(rss_bytes, peak_rss_bytes))
+  {
+    file << ",\"rss\":" << rss_bytes << ",\"peak_rss\":" << peak_rss_bytes;
+  }
+  file << ",\"modules\":[";
+  bool first_entry = true;
+  for (const auto& module : modules_)
+  {
+    for (const auto& category : module.second)
+    {
+      if (!first_entry)
+      {
+        file << ",";
+      }
+      first_entry = false;
+      file << "\n{\"module\":\"" << module.first << "\",\"category\":\"" << category.first
+           << "\",\"bytes\":" << category.second.bytes << ",\"peak\":" << category.second.peak_bytes << "}";
+    }
+  }
+  file << "\n],\"module_peaks\":[";
+  first_entry = true;
+  for (const auto& module_peak_bytes : module_peak_bytes_)
+  {
+    if (!first_entry)
+    {
+      file << ",";
+    }
+    first_entry = false;
+    file << "\n{\"module\":\"" << module_peak_bytes.first << "\",\"peak\":" << module_peak_bytes.second << "}";
+  }
+  file << "\n]}" << std::endl;
+  return file.good();
+}
+
+bool MemoryReport::GetResidentMemory(uint64_t& rss_bytes, uint64_t& peak_rss_bytes)
+{
+  std::ifstream file("/proc/self/status");
+  if (!file.is_open())
+  {
+    return false;
+  }
+  bool rss_found = false;
+  bool peak_rss_found = false;
+  std::string line;
+  while (std::getline(file, line))
+  {
+    std::istringstream iss(line);
+    std::string key;
+    uint64_t kb;
+    if (!(iss >> key >> kb))
+    {
+      continue;
+    }
+    if (key == "VmRSS:")
+    {
+      rss_bytes = kb * 1024;
+      rss_found = true;
+    }
+    else if (key == "VmHWM:")
+    {
+      peak_rss_bytes = kb * 1024;
+      peak_rss_found = true;
+    }
+  }
+  return rss_found && peak_rss_found;
+}
+}  // namespace misc_utils_ns
@@ -628,6 +628,25 @@ void SetDifference(std::vector<int>& v1, std::vector<int>& v2, std::vector<int>&
 
 int Marker::id_ = 0;
 
+bool VisualizationGate::headless_ = false;
+double VisualizationGate::default_min_interval_ = 0;
+
+bool VisualizationGate::Open(const ros::Publisher& publisher)
+{
+  if (!HasSubscribers(publisher))
+  {
+    return false;
+  }
+  double min_interval = min_interval_ > 0 ? min_interval_ : default_min_interval_;
+  ros::Time now = ros::Time::now();
+  if (min_interval > 0 && (now - last_open_time_).toSec() < min_interval)
+  {
+    return false;
+  }
+  last_open_time_ = now;
+  return true;
+}
+
 int signum(int x)
 {
   return x == 0 ? 0 : x < 0 ? -1 : 1;
@@ -738,7 +757,8 @@ bool InFOV(const Eigen::Vector3d& point_position, const Eigen::Vector3d& viewpoi
 }
 
 bool InFOVSimple(const Eigen::Vector3d& point_position, const Eigen::Vector3d& viewpoint_position,
-                 double vertical_fov_ratio, double range, double xy_dist_threshold, double z_diff_threshold, bool print)
+                 double upper_fov_ratio, double lower_fov_ratio, double range, double xy_dist_threshold,
+                 double z_diff_threshold, bool print)
 {
   Eigen::Vector3d diff = point_position - viewpoint_position;
   double xy_dist = sqrt(diff.x() * diff.x() + diff.y() * diff.y());
@@ -758,12 +778,21 @@ bool InFOVSimple(const Eigen::Vector3d& point_position, const Eigen::Vector3d& v
     }
     return false;
   }
-  if (std::abs(diff.z()) > vertical_fov_ratio * xy_dist)
+  if (diff.z() > upper_fov_ratio * xy_dist)
+  {
+    if (print)
+    {
+      std::cout << "diff z: " << diff.z() << " > threshold : " << upper_fov_ratio << " * " << xy_dist << " = "
+                << upper_fov_ratio * xy_dist << std::endl;
+    }
+    return false;
+  }
+  if (-diff.z() > lower_fov_ratio * xy_dist)
   {
     if (print)
     {
-      std::cout << "diff z: " << std::abs(diff.z()) << " > threshold : " << vertical_fov_ratio << " * " << xy_dist
-                << " = " << vertical_fov_ratio * xy_dist << std::endl;
+      std::cout << "diff z: " << diff.z() << " < threshold : -" << lower_fov_ratio << " * " << xy_dist << " = "
+                << -lower_fov_ratio * xy_dist << std::endl;
     }
     return false;
   }
@@ -0,0 +1,73 @@
+/**
+ * @file pointcloud2_reader.cpp
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Reads the points of a sensor_msgs::PointCloud2 in place, without converting it to a PCL cloud first
+ * @version 0.1
+ * @date 2021-06-19
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "utils/pointcloud2_reader.h"
+
+namespace pointcloud_utils_ns
+{
+PointCloud2Reader::PointCloud2Reader(const sensor_msgs::PointCloud2& msg)
+  : msg_(msg)
+  , in_place_(false)
+  , x_offset_(-1)
+  , y_offset_(-1)
+  , z_offset_(-1)
+  , intensity_offset_(-1)
+  , intensity_datatype_(0)
+{
+  for (const auto& field : msg_.fields)
+  {
+    int field_size = 0;
+    switch (field.datatype)
+    {
+      case sensor_msgs::PointField::UINT8:
+        field_size = 1;
+        break;
+      case sensor_msgs::PointField::UINT16:
+        field_size = 2;
+        break;
+      case sensor_msgs::PointField::FLOAT32:
+        field_size = 4;
+        break;
+      case sensor_msgs::PointField::FLOAT64:
+        field_size = 8;
+        break;
+      default:
+        break;
+    }
+    if (field_size == 0 || field.offset + field_size > msg_.point_step)
+    {
+      continue;
+    }
+    bool float_field = field.datatype == sensor_msgs::PointField::FLOAT32;
+    if (field.name == "x" && float_field)
+    {
+      x_offset_ = field.offset;
+    }
+    else if (field.name == "y" && float_field)
+    {
+      y_offset_ = field.offset;
+    }
+    else if (field.name == "z" && float_field)
+    {
+      z_offset_ = field.offset;
+    }
+    else if (field.name == "intensity")
+    {
+      intensity_offset_ = field.offset;
+      intensity_datatype_ = field.datatype;
+    }
+  }
+  bool buffer_complete = msg_.height == 0 || msg_.width == 0 ||
+                         (msg_.row_step >= msg_.width * msg_.point_step &&
+                          msg_.data.size() >= static_cast<size_t>(msg_.height) * msg_.row_step);
+  in_place_ = x_offset_ >= 0 && y_offset_ >= 0 && z_offset_ >= 0 && !msg_.is_bigendian && buffer_complete;
+}
+}  // namespace pointcloud_utils_ns
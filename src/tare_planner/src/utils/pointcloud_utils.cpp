@@ -13,4 +13,95 @@ VerticalSurfaceExtractor::VerticalSurfaceExtractor()
   extractor_kdtree_ = pcl::KdTreeFLANN<pcl::PointXYZI>::Ptr(new pcl::KdTreeFLANN<pcl::PointXYZI>());
 }
 
+ColumnVerticalSurfaceExtractor::ColumnVerticalSurfaceExtractor()
+  : kRadiusThreshold(0.3), kZDiffMax(1.0), kZDiffMin(0.3), kNeighborThreshold(1)
+{
+}
+
+void ColumnVerticalSurfaceExtractor::FinishColumns()
+{
+  int column_num = column_keys_.size();
+  column_min_z_.resize(column_num);
+  column_max_z_.resize(column_num);
+  for (int i = 0; i < column_num; i++)
+  {
+    std::sort(column_points_.begin() + column_starts_[i], column_points_.begin() + column_starts_[i + 1],
+              [](const ColumnPoint& point1, const ColumnPoint& point2) { return point1.z < point2.z; });
+    column_min_z_[i] = column_points_[column_starts_[i]].z;
+    column_max_z_[i] = column_points_[column_starts_[i + 1] - 1].z;
+  }
+  stencil_min_z_.resize(column_num);
+  stencil_max_z_.resize(column_num);
+  stencil_column_inds_.resize(column_num * 9);
+  for (int i = 0; i < column_num; i++)
+  {
+    stencil_min_z_[i] = column_min_z_[i];
+    stencil_max_z_[i] = column_max_z_[i];
+    int stencil_ind = i * 9;
+    for (int x = -1; x <= 1; x++)
+    {
+      for (int y = -1; y <= 1; y++)
+      {
+        VoxelKey key{ column_keys_[i].x + x, column_keys_[i].y + y, 0 };
+        auto it = column_indices_.find(key);
+        int neighbor_column_ind = it == column_indices_.end() ? -1 : it->second;
+        stencil_column_inds_[stencil_ind++] = neighbor_column_ind;
+        if (neighbor_column_ind >= 0)
+        {
+          stencil_min_z_[i] = std::min(stencil_min_z_[i], column_min_z_[neighbor_column_ind]);
+          stencil_max_z_[i] = std::max(stencil_max_z_[i], column_max_z_[neighbor_column_ind]);
+        }
+      }
+    }
+  }
+}
+
+bool ColumnVerticalSurfaceExtractor::IsVertical(const ColumnPoint& point, int column_ind) const
+{
+  if (stencil_max_z_[column_ind] - point.z <= kZDiffMin && point.z - stencil_min_z_[column_ind] <= kZDiffMin)
+  {
+    return false;
+  }
+  auto z_less = [](const ColumnPoint& column_point, double z) { return column_point.z < z; };
+  auto z_greater = [](double z, const ColumnPoint& column_point) { return z < column_point.z; };
+  float radius_sq = kRadiusThreshold * kRadiusThreshold;
+  // Widens the z bands searched, so that float rounding in the exact check below does not lose points on the bounds
+  const double kBandMargin = 1e-3;
+  int neighbor_count = 0;
+  for (int i = column_ind * 9; i < column_ind * 9 + 9; i++)
+  {
+    int neighbor_column_ind = stencil_column_inds_[i];
+    if (neighbor_column_ind < 0 || (column_max_z_[neighbor_column_ind] - point.z <= kZDiffMin &&
+                                    point.z - column_min_z_[neighbor_column_ind] <= kZDiffMin))
+    {
+      continue;
+    }
+    auto column_begin = column_points_.begin() + column_starts_[neighbor_column_ind];
+    auto column_end = column_points_.begin() + column_starts_[neighbor_column_ind + 1];
+    // The points below and above the point by kZDiffMin to kZDiffMax
+    auto below_begin = std::lower_bound(column_begin, column_end, point.z - kZDiffMax - kBandMargin, z_less);
+    auto below_end = std::upper_bound(below_begin, column_end, point.z - kZDiffMin + kBandMargin, z_greater);
+    auto above_begin = std::lower_bound(below_end, column_end, point.z + kZDiffMin - kBandMargin, z_less);
+    auto above_end = std::upper_bound(above_begin, column_end, point.z + kZDiffMax + kBandMargin, z_greater);
+    for (const auto& band : { std::make_pair(below_begin, below_end), std::make_pair(above_begin, above_end) })
+    {
+      for (auto it = band.first; it != band.second; ++it)
+      {
+        double z_diff = std::abs(point.z - it->z);
+        float x_diff = point.x - it->x;
+        float y_diff = point.y - it->y;
+        if (z_diff > kZDiffMin && z_diff < kZDiffMax && x_diff * x_diff + y_diff * y_diff < radius_sq)
+        {
+          neighbor_count++;
+          if (neighbor_count >= kNeighborThreshold)
+          {
+            return true;
+          }
+        }
+      }
+    }
+  }
+  return false;
+}
+
 }  // namespace pointcloud_utils_ns
\ No newline at end of file
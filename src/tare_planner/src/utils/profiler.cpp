@@ -0,0 +1,389 @@
+/**
+ * @file profiler.cpp
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Scoped zone profiler with per-thread recording, latency histograms and Chrome trace export
+ * @version 0.1
+ * @date 2021-06-14
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "utils/profiler.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace misc_utils_ns
+{
+LatencyHistogram::LatencyHistogram() : buckets_(kBucketCount, 0), count_(0), max_(0)
+{
+}
+
+int LatencyHistogram::GetBucketInd(uint64_t value)
+{
+  if (value < kSubBucketCount)
+  {
+    return static_cast<int>(value);
+  }
+  int msb = 63 - __builtin_clzll(value);
+  int shift = msb - kSubBucketBits;
+  int sub_bucket = static_cast<int>(value >> shift) - kSubBucketCount;
+  return (shift + 1) * kSubBucketCount + sub_bucket;
+}
+
+uint64_t LatencyHistogram::GetBucketHighestValue(int bucket_ind)
+{
+  if (bucket_ind < kSubBucketCount)
+  {
+    return bucket_ind;
+  }
+  int shift = bucket_ind / kSubBucketCount - 1;
+  uint64_t mantissa = bucket_ind % kSubBucketCount + kSubBucketCount;
+  return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t value)
+{
+  buckets_[GetBucketInd(value)]++;
+  count_++;
+  max_ = std::max(max_, value);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other)
+{
+  for (int i = 0; i < kBucketCount; i++)
+  {
+    buckets_[i] += other.buckets_[i];
+  }
+  count_ += other.count_;
+  max_ = std::max(max_, other.max_);
+}
+
+void LatencyHistogram::Reset()
+{
+  std::fill(buckets_.begin(), buckets_.end(), 0);
+  count_ = 0;
+  max_ = 0;
+}
+
+uint64_t LatencyHistogram::GetPercentile(double p) const
+{
+  if (count_ == 0)
+  {
+    return 0;
+  }
+  uint64_t rank = static_cast<uint64_t>(p / 100.0 * count_ + 0.5);
+  rank = std::min(std::max(rank, static_cast<uint64_t>(1)), count_);
+  uint64_t accumulated = 0;
+  for (int i = 0; i < kBucketCount; i++)
+  {
+    accumulated += buckets_[i];
+    if (accumulated >= rank)
+    {
+      return std::min(GetBucketHighestValue(i), max_);
+    }
+  }
+  return max_;
+}
+
+ProfileThreadBuffer::ProfileThreadBuffer(int thread_id)
+  : thread_id_(thread_id), slots_(new EventSlot[kCapacity]), write_count_(0), read_count_(0), depth_(0)
+{
+  for (int i = 0; i < kCapacity; i++)
+  {
+    slots_[i].sequence.store(0, std::memory_order_relaxed);
+  }
+}
+
+int ProfileThreadBuffer::PushZone(int zone_id)
+{
+  int parent_zone_id = -1;
+  if (depth_ > 0 && depth_ <= kMaxDepth)
+  {
+    parent_zone_id = zone_stack_[depth_ - 1];
+  }
+  if (depth_ < kMaxDepth)
+  {
+    zone_stack_[depth_] = zone_id;
+  }
+  depth_++;
+  return parent_zone_id;
+}
+
+void ProfileThreadBuffer::PopZone()
+{
+  if (depth_ > 0)
+  {
+    depth_--;
+  }
+}
+
+void ProfileThreadBuffer::Record(const ProfileEvent& event)
+{
+  uint64_t write_count = write_count_.load(std::memory_order_relaxed);
+  EventSlot& slot = slots_[write_count & (kCapacity - 1)];
+  slot.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.zone_id.store(event.zone_id, std::memory_order_relaxed);
+  slot.parent_zone_id.store(event.parent_zone_id, std::memory_order_relaxed);
+  slot.start_ns.store(event.start_ns, std::memory_order_relaxed);
+  slot.duration_ns.store(event.duration_ns, std::memory_order_relaxed);
+  slot.sequence.store(write_count + 1, std::memory_order_release);
+  write_count_.store(write_count + 1, std::memory_order_release);
+}
+
+uint64_t ProfileThreadBuffer::Drain(std::vector<ProfileEvent>& events)
+{
+  uint64_t dropped_num = 0;
+  uint64_t write_count = write_count_.load(std::memory_order_acquire);
+  // With a full ring the writer may already be rewriting the oldest slot, skip it as well
+  if (write_count - read_count_ >= kCapacity)
+  {
+    uint64_t first_count = write_count - kCapacity + 1;
+    dropped_num += first_count - read_count_;
+    read_count_ = first_count;
+  }
+  for (uint64_t i = read_count_; i < write_count; i++)
+  {
+    const EventSlot& slot = slots_[i & (kCapacity - 1)];
+    uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+    ProfileEvent event;
+    event.zone_id = slot.zone_id.load(std::memory_order_relaxed);
+    event.parent_zone_id = slot.parent_zone_id.load(std::memory_order_relaxed);
+    event.start_ns = slot.start_ns.load(std::memory_order_relaxed);
+    event.duration_ns = slot.duration_ns.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // The writer lapped the reader and overwrote (or is overwriting) the slot while it was copied
+    if (sequence != i + 1 || slot.sequence.load(std::memory_order_relaxed) != i + 1)
+    {
+      dropped_num++;
+      continue;
+    }
+    events.push_back(event);
+  }
+  read_count_ = write_count;
+  return dropped_num;
+}
+
+Profiler::Profiler()
+  : enabled_(true)
+  , histogram_window_sec_(60.0)
+  , start_time_(std::chrono::steady_clock::now())
+  , window_start_time_(start_time_)
+  , dropped_event_num_(0)
+{
+}
+
+Profiler& Profiler::GetInstance()
+{
+  static Profiler profiler;
+  return profiler;
+}
+
+int Profiler::RegisterZone(const std::string& name)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (int i = 0; i < zone_names_.size(); i++)
+  {
+    if (zone_names_[i] == name)
+    {
+      return i;
+    }
+  }
+  zone_names_.push_back(name);
+  return zone_names_.size() - 1;
+}
+
+ProfileThreadBuffer& Profiler::GetThreadBuffer()
+{
+  thread_local ProfileThreadBuffer* buffer = nullptr;
+  if (buffer == nullptr)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    thread_buffers_.push_back(std::unique_ptr<ProfileThreadBuffer>(new ProfileThreadBuffer(thread_buffers_.size())));
+    buffer = thread_buffers_.back().get();
+  }
+  return *buffer;
+}
+
+int64_t Profiler::Now() const
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time_).count();
+}
+
+void Profiler::RotateHistograms()
+{
+  std::chrono::duration<double> window_duration = std::chrono::steady_clock::now() - window_start_time_;
+  if (window_duration.count() < histogram_window_sec_)
+  {
+    return;
+  }
+  for (auto& zone_stats : zone_stats_)
+  {
+    zone_stats.second.previous = zone_stats.second.current;
+    zone_stats.second.current.Reset();
+  }
+  window_start_time_ = std::chrono::steady_clock::now();
+}
+
+void Profiler::Collect()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  RotateHistograms();
+  for (const auto& thread_buffer : thread_buffers_)
+  {
+    drain_buffer_.clear();
+    dropped_event_num_ += thread_buffer->Drain(drain_buffer_);
+    for (const auto& event : drain_buffer_)
+    {
+      zone_stats_[std::make_pair(event.parent_zone_id, event.zone_id)].current.Record(event.duration_ns);
+      trace_events_.emplace_back(thread_buffer->GetThreadID(), event);
+    }
+  }
+  while (trace_events_.size() > kTraceCapacity)
+  {
+    trace_events_.pop_front();
+  }
+}
+
+void Profiler::GetZoneSummaries(int parent_zone_id, const std::string& parent_path, int depth,
+                                std::vector<bool>& visited, std::vector<ZoneSummary>& summaries)
+{
+  for (auto& zone_stats : zone_stats_)
+  {
+    if (zone_stats.first.first != parent_zone_id)
+    {
+      continue;
+    }
+    int zone_id = zone_stats.first.second;
+    ZoneSummary summary;
+    summary.path = parent_path.empty() ? zone_names_[zone_id] : parent_path + "/" + zone_names_[zone_id];
+    summary.depth = depth;
+    summary.histogram = zone_stats.second.previous;
+    summary.histogram.Merge(zone_stats.second.current);
+    if (summary.histogram.GetCount() == 0)
+    {
+      continue;
+    }
+    summaries.push_back(summary);
+    // Guard against recursive zones
+    if (!visited[zone_id])
+    {
+      visited[zone_id] = true;
+      GetZoneSummaries(zone_id, summary.path, depth + 1, visited, summaries);
+      visited[zone_id] = false;
+    }
+  }
+}
+
+void Profiler::PrintReport(std::ostream& os)
+{
+  Collect();
+  std::lock_guard<std::mutex> lock(mutex_);
+  os << std::left << std::setw(40) << "zone" << std::right << std::setw(8) << "count" << std::setw(12) << "p50(ms)"
+     << std::setw(12) << "p95(ms)" << std::setw(12) << "p99(ms)" << std::setw(12) << "max(ms)" << std::endl;
+  std::vector<bool> visited(zone_names_.size(), false);
+  std::vector<ZoneSummary> summaries;
+  GetZoneSummaries(-1, "", 0, visited, summaries);
+  for (const auto& summary : summaries)
+  {
+    std::string label = std::string(2 * summary.depth, ' ') + summary.path.substr(summary.path.rfind('/') + 1);
+    const LatencyHistogram& histogram = summary.histogram;
+    os << std::left << std::setw(40) << label << std::right << std::setw(8) << histogram.GetCount() << std::fixed
+       << std::setprecision(3) << std::setw(12) << histogram.GetPercentile(50) / 1e6 << std::setw(12)
+       << histogram.GetPercentile(95) / 1e6 << std::setw(12) << histogram.GetPercentile(99) / 1e6 << std::setw(12)
+       << histogram.GetMax() / 1e6 << std::endl;
+  }
+  if (dropped_event_num_ > 0)
+  {
+    os << "dropped events: " << dropped_event_num_ << std::endl;
+  }
+}
+
+bool Profiler::ExportChromeTrace(const std::string& file_path)
+{
+  Collect();
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::ofstream file(file_path);
+  if (!file.is_open())
+  {
+    std::cout << "Profiler: cannot open " << file_path << std::endl;
+    return false;
+  }
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  file << std::fixed << std::setprecision(3);
+  for (int i = 0; i < trace_events_.size(); i++)
+  {
+    const ProfileEvent& event = trace_events_[i].second;
+    if (i > 0)
+    {
+      file << ",";
+    }
+    // Zone names are string literals from the source, no escaping needed
+    file << "\n{\"name\":\"" << zone_names_[event.zone_id] << "\",\"cat\":\"tare_planner\",\"ph\":\"X\",\"pid\":0"
+         << ",\"tid\":" << trace_events_[i].first << ",\"ts\":" << event.start_ns / 1e3
+         << ",\"dur\":" << event.duration_ns / 1e3 << "}";
+  }
+  file << "\n]}" << std::endl;
+  return file.good();
+}
+
+bool Profiler::ExportSummary(const std::string& file_path)
+{
+  Collect();
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::ofstream file(file_path);
+  if (!file.is_open())
+  {
+    std::cout << "Profiler: cannot open " << file_path << std::endl;
+    return false;
+  }
+  std::vector<bool> visited(zone_names_.size(), false);
+  std::vector<ZoneSummary> summaries;
+  GetZoneSummaries(-1, "", 0, visited, summaries);
+  file << "{\"unit\":\"ms\",\"dropped_events\":" << dropped_event_num_ << ",\"zones\":[";
+  file << std::fixed << std::setprecision(6);
+  for (int i = 0; i < summaries.size(); i++)
+  {
+    const LatencyHistogram& histogram = summaries[i].histogram;
+    if (i > 0)
+    {
+      file << ",";
+    }
+    file << "\n{\"path\":\"" << summaries[i].path << "\",\"count\":" << histogram.GetCount()
+         << ",\"p50\":" << histogram.GetPercentile(50) / 1e6 << ",\"p95\":" << histogram.GetPercentile(95) / 1e6
+         << ",\"p99\":" << histogram.GetPercentile(99) / 1e6 << ",\"max\":" << histogram.GetMax() / 1e6 << "}";
+  }
+  file << "\n]}" << std::endl;
+  return file.good();
+}
+
+ProfileZone::ProfileZone(int zone_id) : buffer_(nullptr), zone_id_(zone_id), parent_zone_id_(-1), start_ns_(0)
+{
+  Profiler& profiler = Profiler::GetInstance();
+  if (!profiler.IsEnabled())
+  {
+    return;
+  }
+  buffer_ = &profiler.GetThreadBuffer();
+  parent_zone_id_ = buffer_->PushZone(zone_id_);
+  start_ns_ = profiler.Now();
+}
+
+void ProfileZone::Stop()
+{
+  if (buffer_ == nullptr)
+  {
+    return;
+  }
+  ProfileEvent event;
+  event.zone_id = zone_id_;
+  event.parent_zone_id = parent_zone_id_;
+  event.start_ns = start_ns_;
+  event.duration_ns = Profiler::GetInstance().Now() - start_ns_;
+  buffer_->Record(event);
+  buffer_->PopZone();
+  buffer_ = nullptr;
+}
+}  // namespace misc_utils_ns
@@ -0,0 +1,193 @@
+/**
+ * @file table_cache.cpp
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief On-disk cache of precomputed index tables, addressed by a hash of the parameters they depend on
+ * @version 0.1
+ * @date 2021-06-19
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "utils/table_cache.h"
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace misc_utils_ns
+{
+namespace
+{
+const uint64_t kTableCacheMagic = 0x4843414345524154ULL;  // "TARECACH" on little-endian machines
+const uint32_t kTableCacheFormatVersion = 1;
+const size_t kTableAlignment = 8;
+
+struct TableCacheHeader
+{
+  uint64_t magic;
+  uint32_t format_version;
+  uint32_t reserved;
+  uint64_t key;
+  uint64_t payload_size;
+  uint64_t checksum;
+};
+
+size_t GetPaddedSize(size_t size)
+{
+  return (size + kTableAlignment - 1) / kTableAlignment * kTableAlignment;
+}
+}  // namespace
+
+HashBuilder& HashBuilder::AddBytes(const void* data, size_t size)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < size; i++)
+  {
+    hash_ ^= bytes[i];
+    hash_ *= kPrime;
+  }
+  return *this;
+}
+
+void TableCacheWriter::AddBytes(const void* data, uint64_t element_num, size_t element_size)
+{
+  size_t data_size = element_num * element_size;
+  size_t offset = payload_.size();
+  payload_.resize(offset + sizeof(element_num) + GetPaddedSize(data_size), 0);
+  std::memcpy(payload_.data() + offset, &element_num, sizeof(element_num));
+  if (data_size > 0)
+  {
+    std::memcpy(payload_.data() + offset + sizeof(element_num), data, data_size);
+  }
+}
+
+bool TableCacheWriter::Write(const std::string& file_path) const
+{
+  TableCacheHeader header;
+  header.magic = kTableCacheMagic;
+  header.format_version = kTableCacheFormatVersion;
+  header.reserved = 0;
+  header.key = key_;
+  header.payload_size = payload_.size();
+  header.checksum = HashBuilder().AddBytes(payload_.data(), payload_.size()).Get();
+
+  std::string tmp_file_path = file_path + ".tmp" + std::to_string(getpid());
+  FILE* file = std::fopen(tmp_file_path.c_str(), "wb");
+  if (file == nullptr)
+  {
+    return false;
+  }
+  bool success = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 (payload_.empty() || std::fwrite(payload_.data(), payload_.size(), 1, file) == 1);
+  success = (std::fclose(file) == 0) && success;
+  if (!success || std::rename(tmp_file_path.c_str(), file_path.c_str()) != 0)
+  {
+    std::remove(tmp_file_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool TableCacheReader::Open(const std::string& file_path, uint64_t key)
+{
+  Close();
+  int fd = ::open(file_path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return false;
+  }
+  struct stat file_stat;
+  if (::fstat(fd, &file_stat) != 0 || file_stat.st_size < static_cast<off_t>(sizeof(TableCacheHeader)))
+  {
+    ::close(fd);
+    return false;
+  }
+  void* mapped = ::mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED)
+  {
+    return false;
+  }
+  data_ = static_cast<const char*>(mapped);
+  size_ = file_stat.st_size;
+
+  TableCacheHeader header;
+  std::memcpy(&header, data_, sizeof(header));
+  const char* payload = data_ + sizeof(header);
+  if (header.magic != kTableCacheMagic || header.format_version != kTableCacheFormatVersion || header.key != key ||
+      header.payload_size != size_ - sizeof(header) ||
+      header.checksum != HashBuilder().AddBytes(payload, header.payload_size).Get())
+  {
+    Close();
+    return false;
+  }
+  read_offset_ = sizeof(header);
+  return true;
+}
+
+void TableCacheReader::Close()
+{
+  if (data_ != nullptr)
+  {
+    ::munmap(const_cast<char*>(data_), size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  read_offset_ = 0;
+}
+
+const char* TableCacheReader::ReadBytes(size_t element_size, uint64_t& element_num)
+{
+  if (data_ == nullptr || size_ - read_offset_ < sizeof(element_num))
+  {
+    return nullptr;
+  }
+  std::memcpy(&element_num, data_ + read_offset_, sizeof(element_num));
+  size_t remaining_size = size_ - read_offset_ - sizeof(element_num);
+  if (element_num > remaining_size / element_size)
+  {
+    return nullptr;
+  }
+  size_t padded_size = GetPaddedSize(element_num * element_size);
+  if (padded_size > remaining_size)
+  {
+    return nullptr;
+  }
+  const char* elements = data_ + read_offset_ + sizeof(element_num);
+  read_offset_ += sizeof(element_num) + padded_size;
+  return elements;
+}
+
+std::string GetTableCachePath(const std::string& directory, const std::string& name, uint64_t key)
+{
+  char key_str[17];
+  std::snprintf(key_str, sizeof(key_str), "%016llx", static_cast<unsigned long long>(key));
+  std::string path = directory;
+  if (!path.empty() && path.back() != '/')
+  {
+    path += '/';
+  }
+  return path + name + "_" + key_str + ".bin";
+}
+
+bool CreateDirectories(const std::string& directory)
+{
+  if (directory.empty())
+  {
+    return false;
+  }
+  for (size_t pos = directory.find('/', 1); pos != std::string::npos; pos = directory.find('/', pos + 1))
+  {
+    ::mkdir(directory.substr(0, pos).c_str(), 0755);
+  }
+  if (::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST)
+  {
+    return false;
+  }
+  struct stat dir_stat;
+  return ::stat(directory.c_str(), &dir_stat) == 0 && S_ISDIR(dir_stat.st_mode);
+}
+}  // namespace misc_utils_ns
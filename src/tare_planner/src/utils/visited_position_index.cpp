@@ -0,0 +1,226 @@
+/**
+ * @file visited_position_index.cpp
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Spatial hash of the positions visited by the robot, with far away positions rolled out to an archive
+ * @version 0.1
+ * @date 2021-06-18
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "utils/visited_position_index.h"
+#include "utils/memory_report.h"
+#include <algorithm>
+#include <cmath>
+
+namespace misc_utils_ns
+{
+VisitedPositionIndex::VisitedPositionIndex(double visited_radius, int archive_block_size)
+  : visited_radius_(visited_radius)
+  , archive_block_size_(std::max(archive_block_size, 1))
+  , active_block_min_(0, 0)
+  , active_block_max_(0, 0)
+  , active_range_set_(false)
+  , active_position_num_(0)
+  , archived_position_num_(0)
+{
+}
+
+Eigen::Vector3i VisitedPositionIndex::GetVoxelSub(const Eigen::Vector3d& position) const
+{
+  return Eigen::Vector3i(static_cast<int>(std::floor(position.x() / visited_radius_)),
+                         static_cast<int>(std::floor(position.y() / visited_radius_)),
+                         static_cast<int>(std::floor(position.z() / visited_radius_)));
+}
+
+int64_t VisitedPositionIndex::GetVoxelKey(const Eigen::Vector3i& voxel_sub)
+{
+  const int64_t kOffset = 1 << 20;
+  return ((voxel_sub.x() + kOffset) << 42) | ((voxel_sub.y() + kOffset) << 21) | (voxel_sub.z() + kOffset);
+}
+
+int64_t VisitedPositionIndex::GetBlockKey(int block_x, int block_y)
+{
+  const int64_t kOffset = 1 << 30;
+  return ((block_x + kOffset) << 32) | (block_y + kOffset);
+}
+
+int VisitedPositionIndex::GetBlockIndex(int voxel_index) const
+{
+  // Floor division, voxel indices can be negative
+  return voxel_index >= 0 ? voxel_index / archive_block_size_
+                          : -((-voxel_index + archive_block_size_ - 1) / archive_block_size_);
+}
+
+bool VisitedPositionIndex::BlockActive(int block_x, int block_y) const
+{
+  if (!active_range_set_)
+  {
+    return true;
+  }
+  return block_x >= active_block_min_.x() && block_x <= active_block_max_.x() && block_y >= active_block_min_.y() &&
+         block_y <= active_block_max_.y();
+}
+
+bool VisitedPositionIndex::VoxelActive(const Eigen::Vector3i& voxel_sub) const
+{
+  return BlockActive(GetBlockIndex(voxel_sub.x()), GetBlockIndex(voxel_sub.y()));
+}
+
+bool VisitedPositionIndex::InRadius(const PositionList& positions, const Eigen::Vector3f& position, float radius)
+{
+  float radius_sq = radius * radius;
+  for (const auto& stored_position : positions)
+  {
+    if ((stored_position - position).squaredNorm() < radius_sq)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool VisitedPositionIndex::Insert(const Eigen::Vector3d& position)
+{
+  if (IsVisited(position, visited_radius_))
+  {
+    return false;
+  }
+  Eigen::Vector3i voxel_sub = GetVoxelSub(position);
+  if (VoxelActive(voxel_sub))
+  {
+    active_voxels_[GetVoxelKey(voxel_sub)].push_back(position.cast<float>());
+    active_position_num_++;
+  }
+  else
+  {
+    archived_blocks_[GetBlockKey(GetBlockIndex(voxel_sub.x()), GetBlockIndex(voxel_sub.y()))].push_back(
+        position.cast<float>());
+    archived_position_num_++;
+  }
+  return true;
+}
+
+bool VisitedPositionIndex::IsVisited(const Eigen::Vector3d& position, double radius) const
+{
+  Eigen::Vector3f query_position = position.cast<float>();
+  Eigen::Vector3i center_sub = GetVoxelSub(position);
+  int search_range = static_cast<int>(std::ceil(radius / visited_radius_));
+  std::vector<int64_t> archived_block_keys;
+  for (int x = center_sub.x() - search_range; x <= center_sub.x() + search_range; x++)
+  {
+    for (int y = center_sub.y() - search_range; y <= center_sub.y() + search_range; y++)
+    {
+      int block_x = GetBlockIndex(x);
+      int block_y = GetBlockIndex(y);
+      if (!BlockActive(block_x, block_y))
+      {
+        int64_t block_key = GetBlockKey(block_x, block_y);
+        if (std::find(archived_block_keys.begin(), archived_block_keys.end(), block_key) == archived_block_keys.end())
+        {
+          archived_block_keys.push_back(block_key);
+        }
+        continue;
+      }
+      for (int z = center_sub.z() - search_range; z <= center_sub.z() + search_range; z++)
+      {
+        auto it = active_voxels_.find(GetVoxelKey(Eigen::Vector3i(x, y, z)));
+        if (it != active_voxels_.end() && InRadius(it->second, query_position, radius))
+        {
+          return true;
+        }
+      }
+    }
+  }
+  for (const auto& block_key : archived_block_keys)
+  {
+    auto it = archived_blocks_.find(block_key);
+    if (it != archived_blocks_.end() && InRadius(it->second, query_position, radius))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void VisitedPositionIndex::UpdateActiveRange(const Eigen::Vector3d& center, const Eigen::Vector3d& range)
+{
+  Eigen::Vector3i min_sub = GetVoxelSub(center - range);
+  Eigen::Vector3i max_sub = GetVoxelSub(center + range);
+  Eigen::Vector2i block_min(GetBlockIndex(min_sub.x()), GetBlockIndex(min_sub.y()));
+  Eigen::Vector2i block_max(GetBlockIndex(max_sub.x()), GetBlockIndex(max_sub.y()));
+  if (active_range_set_ && block_min == active_block_min_ && block_max == active_block_max_)
+  {
+    return;
+  }
+  active_block_min_ = block_min;
+  active_block_max_ = block_max;
+  active_range_set_ = true;
+
+  // Roll out
+  for (auto it = active_voxels_.begin(); it != active_voxels_.end();)
+  {
+    Eigen::Vector3i voxel_sub = GetVoxelSub(it->second.front().cast<double>());
+    int block_x = GetBlockIndex(voxel_sub.x());
+    int block_y = GetBlockIndex(voxel_sub.y());
+    if (BlockActive(block_x, block_y))
+    {
+      ++it;
+      continue;
+    }
+    PositionList& block = archived_blocks_[GetBlockKey(block_x, block_y)];
+    block.insert(block.end(), it->second.begin(), it->second.end());
+    active_position_num_ -= it->second.size();
+    archived_position_num_ += it->second.size();
+    it = active_voxels_.erase(it);
+  }
+
+  // Roll in
+  for (int block_x = block_min.x(); block_x <= block_max.x(); block_x++)
+  {
+    for (int block_y = block_min.y(); block_y <= block_max.y(); block_y++)
+    {
+      auto it = archived_blocks_.find(GetBlockKey(block_x, block_y));
+      if (it == archived_blocks_.end())
+      {
+        continue;
+      }
+      for (const auto& archived_position : it->second)
+      {
+        active_voxels_[GetVoxelKey(GetVoxelSub(archived_position.cast<double>()))].push_back(archived_position);
+      }
+      active_position_num_ += it->second.size();
+      archived_position_num_ -= it->second.size();
+      archived_blocks_.erase(it);
+    }
+  }
+}
+
+void VisitedPositionIndex::GetActivePositions(std::vector<Eigen::Vector3d>& positions) const
+{
+  positions.clear();
+  positions.reserve(active_position_num_);
+  for (const auto& voxel : active_voxels_)
+  {
+    for (const auto& position : voxel.second)
+    {
+      positions.push_back(position.cast<double>());
+    }
+  }
+}
+
+uint64_t VisitedPositionIndex::GetMemoryBytes() const
+{
+  uint64_t bytes = GetHashTableBytes(active_voxels_) + GetHashTableBytes(archived_blocks_);
+  for (const auto& voxel : active_voxels_)
+  {
+    bytes += GetVectorBytes(voxel.second);
+  }
+  for (const auto& block : archived_blocks_)
+  {
+    bytes += GetVectorBytes(block.second);
+  }
+  return bytes;
+}
+}  // namespace misc_utils_ns
@@ -0,0 +1,107 @@
+/**
+ * @file visualization_worker.cpp
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Thread that serializes and publishes visualization messages off the planning thread
+ * @version 0.1
+ * @date 2021-06-19
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "utils/visualization_worker.h"
+
+namespace misc_utils_ns
+{
+VisualizationWorker& VisualizationWorker::GetInstance()
+{
+  static VisualizationWorker worker;
+  return worker;
+}
+
+VisualizationWorker::VisualizationWorker() : running_(false), dropped_task_count_(0)
+{
+}
+
+VisualizationWorker::~VisualizationWorker()
+{
+  SetEnabled(false);
+}
+
+void VisualizationWorker::SetEnabled(bool enabled)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_ == enabled)
+    {
+      return;
+    }
+    running_ = enabled;
+  }
+  if (enabled)
+  {
+    thread_ = std::thread(&VisualizationWorker::Run, this);
+  }
+  else
+  {
+    condition_.notify_all();
+    thread_.join();
+    // Snapshots still waiting are stale by the time anyone would publish them synchronously
+    std::lock_guard<std::mutex> lock(mutex_);
+    mailbox_.clear();
+  }
+}
+
+bool VisualizationWorker::Enabled() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return running_;
+}
+
+void VisualizationWorker::Post(const void* key, PublishTask task)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_)
+    {
+      PublishTask& slot = mailbox_[key];
+      if (slot)
+      {
+        dropped_task_count_++;
+      }
+      slot = std::move(task);
+      condition_.notify_one();
+      return;
+    }
+  }
+  task();
+}
+
+int VisualizationWorker::GetDroppedTaskCount() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return dropped_task_count_;
+}
+
+void VisualizationWorker::Run()
+{
+  std::unordered_map<const void*, PublishTask> tasks;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this]() { return !running_ || !mailbox_.empty(); });
+      if (!running_)
+      {
+        return;
+      }
+      tasks.swap(mailbox_);
+    }
+    for (auto& task : tasks)
+    {
+      task.second();
+    }
+    tasks.clear();
+  }
+}
+}  // namespace misc_utils_ns
@@ -0,0 +1,96 @@
+/**
+ * @file voxel_bucket_hash.cpp
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Points bucketed into a voxel hash for fixed radius neighbor tests
+ * @version 0.1
+ * @date 2021-06-19
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "utils/voxel_bucket_hash.h"
+#include "utils/memory_report.h"
+#include <cmath>
+
+namespace misc_utils_ns
+{
+VoxelBucketHash::VoxelBucketHash(double radius)
+{
+  Reset(radius);
+}
+
+void VoxelBucketHash::Reset(double radius)
+{
+  radius_ = static_cast<float>(radius);
+  radius_sq_ = radius_ * radius_;
+  bucket_heads_.clear();
+  positions_.clear();
+  next_indices_.clear();
+}
+
+Eigen::Vector3i VoxelBucketHash::GetVoxelSub(const Eigen::Vector3f& position) const
+{
+  return Eigen::Vector3i(static_cast<int>(std::floor(position.x() / radius_)),
+                         static_cast<int>(std::floor(position.y() / radius_)),
+                         static_cast<int>(std::floor(position.z() / radius_)));
+}
+
+int64_t VoxelBucketHash::GetVoxelKey(const Eigen::Vector3i& voxel_sub)
+{
+  const int64_t kOffset = 1 << 20;
+  return ((voxel_sub.x() + kOffset) << 42) | ((voxel_sub.y() + kOffset) << 21) | (voxel_sub.z() + kOffset);
+}
+
+void VoxelBucketHash::Insert(const Eigen::Vector3f& position)
+{
+  int point_ind = static_cast<int>(positions_.size());
+  positions_.push_back(position);
+  auto result = bucket_heads_.emplace(GetVoxelKey(GetVoxelSub(position)), point_ind);
+  if (result.second)
+  {
+    next_indices_.push_back(-1);
+  }
+  else
+  {
+    next_indices_.push_back(result.first->second);
+    result.first->second = point_ind;
+  }
+}
+
+bool VoxelBucketHash::HasPointInRadius(const Eigen::Vector3f& position) const
+{
+  if (positions_.empty())
+  {
+    return false;
+  }
+  Eigen::Vector3i center_sub = GetVoxelSub(position);
+  for (int x = center_sub.x() - 1; x <= center_sub.x() + 1; x++)
+  {
+    for (int y = center_sub.y() - 1; y <= center_sub.y() + 1; y++)
+    {
+      for (int z = center_sub.z() - 1; z <= center_sub.z() + 1; z++)
+      {
+        auto it = bucket_heads_.find(GetVoxelKey(Eigen::Vector3i(x, y, z)));
+        if (it == bucket_heads_.end())
+        {
+          continue;
+        }
+        for (int ind = it->second; ind >= 0; ind = next_indices_[ind])
+        {
+          if ((positions_[ind] - position).squaredNorm() <= radius_sq_)
+          {
+            return true;
+          }
+        }
+      }
+    }
+  }
+  return false;
+}
+
+uint64_t VoxelBucketHash::GetMemoryBytes() const
+{
+  return GetHashTableBytes(bucket_heads_) + GetVectorBytes(positions_) + GetVectorBytes(next_indices_);
+}
+}  // namespace misc_utils_ns
@@ -13,50 +13,11 @@
 
 namespace viewpoint_ns
 {
-ViewPoint::ViewPoint(double x, double y, double z)
-  : lidar_model_(x, y, z)
-  , in_collision_(false)
-  , in_line_of_sight_(false)
-  , connected_(false)
-  , visited_(false)
-  , selected_(false)
-  , is_candidate_(false)
-  , has_terrain_height_(false)
-  , has_terrain_neighbor_(false)
-  , in_exploring_cell_(false)
-  , cell_ind_(-1)
-  , collision_frame_count_(0)
-  , terrain_height_(0.0)
-{
-}
-
-ViewPoint::ViewPoint(const geometry_msgs::Point& position) : ViewPoint(position.x, position.y, position.z)
-{
-}
-
-void ViewPoint::Reset()
-{
-  in_collision_ = false;
-  in_line_of_sight_ = false;
-  connected_ = false;
-  visited_ = false;
-  selected_ = false;
-  is_candidate_ = false;
-  has_terrain_height_ = false;
-  has_terrain_neighbor_ = false;
-  in_exploring_cell_ = false;
-  cell_ind_ = -1;
-  lidar_model_.ResetCoverage();
-  covered_point_list_.clear();
-  covered_frontier_point_list_.clear();
-  collision_frame_count_ = 0;
-  terrain_height_ = 0.0;
-}
-
 void ViewPoint::ResetCoverage()
 {
-  lidar_model_.ResetCoverage();
   covered_point_list_.clear();
   covered_frontier_point_list_.clear();
+  covered_point_set_.Clear();
+  covered_frontier_point_set_.Clear();
 }
 }  // namespace viewpoint_ns
\ No newline at end of file
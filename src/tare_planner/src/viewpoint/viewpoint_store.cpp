@@ -0,0 +1,83 @@
+/**
+ * @file viewpoint_store.cpp
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Structure-of-arrays storage of the viewpoints in the local planning horizon
+ * @version 0.1
+ * @date 2021-06-19
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "viewpoint/viewpoint_store.h"
+
+namespace viewpoint_ns
+{
+ViewPointStore::ViewPointStore(int viewpoint_num, lidar_model_ns::LiDARModelType lidar_model_type)
+  : viewpoint_num_(0)
+{
+  Resize(viewpoint_num, lidar_model_type);
+}
+
+void ViewPointStore::Resize(int viewpoint_num, lidar_model_ns::LiDARModelType lidar_model_type)
+{
+  viewpoint_num_ = viewpoint_num;
+  states_.resize(kStateNum);
+  for (auto& state : states_)
+  {
+    state.Reset(viewpoint_num_);
+  }
+  positions_.assign(viewpoint_num_, geometry_msgs::Point());
+  cell_indices_.assign(viewpoint_num_, -1);
+  collision_frame_counts_.assign(viewpoint_num_, 0);
+  covered_points_.assign(viewpoint_num_, ViewPoint());
+  lidar_models_.Resize(lidar_model_type, viewpoint_num_);
+}
+
+void ViewPointStore::Reset(int array_ind)
+{
+  for (int i = 0; i < kStateNum; i++)
+  {
+    if (i != static_cast<int>(ViewPointState::IN_CURRENT_FRAME_LINE_OF_SIGHT))
+    {
+      states_[i].Unset(array_ind);
+    }
+  }
+  cell_indices_[array_ind] = -1;
+  collision_frame_counts_[array_ind] = 0;
+  covered_points_[array_ind].ResetCoverage();
+  lidar_models_.ResetCoverage(array_ind);
+}
+
+void ViewPointStore::ResetCoverage()
+{
+  for (auto& covered_points : covered_points_)
+  {
+    covered_points.ResetCoverage();
+  }
+  lidar_models_.ResetCoverage();
+}
+
+uint64_t ViewPointStore::GetMemoryBytes() const
+{
+  uint64_t bytes = misc_utils_ns::GetVectorBytes(states_) + misc_utils_ns::GetVectorBytes(positions_) +
+                   misc_utils_ns::GetVectorBytes(cell_indices_) +
+                   misc_utils_ns::GetVectorBytes(collision_frame_counts_) +
+                   misc_utils_ns::GetVectorBytes(covered_points_) + lidar_models_.GetMemoryBytes();
+  for (const auto& state : states_)
+  {
+    bytes += state.GetMemoryBytes();
+  }
+  return bytes;
+}
+
+uint64_t ViewPointStore::GetCoveredPointMemoryBytes() const
+{
+  uint64_t bytes = 0;
+  for (const auto& covered_points : covered_points_)
+  {
+    bytes += covered_points.GetCoveredPointMemoryBytes();
+  }
+  return bytes;
+}
+}  // namespace viewpoint_ns
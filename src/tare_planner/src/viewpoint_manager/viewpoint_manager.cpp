@@ -9,6 +9,7 @@
  *
  */
 #include "viewpoint_manager/viewpoint_manager.h"
+#include <cstdlib>
 
 namespace viewpoint_manager_ns
 {
@@ -41,6 +42,7 @@ bool ViewPointManagerParameter::ReadParameters(ros::NodeHandle& nh)
   kViewPointHeightFromTerrain = misc_utils_ns::getParam<double>(nh, "kViewPointHeightFromTerrain", 0.75);
   kViewPointHeightFromTerrainChangeThreshold =
       misc_utils_ns::getParam<double>(nh, "kViewPointHeightFromTerrainChangeThreshold", 0.6);
+  kViewPointHeightSmoothingRadius = misc_utils_ns::getParam<int>(nh, "kViewPointHeightSmoothingRadius", 0);
 
   kCollisionPointThr = misc_utils_ns::getParam<int>(nh, "kCollisionPointThr", 3);
 
@@ -60,42 +62,46 @@ bool ViewPointManagerParameter::ReadParameters(ros::NodeHandle& nh)
   kCoverageDilationRadius = misc_utils_ns::getParam<double>(nh, "kCoverageDilationRadius", 1.0);
   kCoveragePointCloudResolution = misc_utils_ns::getParam<double>(nh, "kPlannerCloudDwzLeafSize", 1.0);
   kSensorRange = misc_utils_ns::getParam<double>(nh, "kSensorRange", 10.0);
+  std::string lidar_model_name = misc_utils_ns::getParam<std::string>(nh, "kLiDARModel", "vlp16");
+  if (!lidar_model_ns::GetLiDARModelType(lidar_model_name, kLiDARModelType))
+  {
+    ROS_WARN_STREAM("ViewPointManager: unknown kLiDARModel " << lidar_model_name << ", using vlp16");
+    kLiDARModelType = lidar_model_ns::LiDARModelType::VLP16;
+  }
   kNeighborRange = misc_utils_ns::getParam<double>(nh, "kNeighborRange", 3.0);
 
-  kVerticalFOVRatio = tan(M_PI / 15);
-  kDiffZMax = kSensorRange * kVerticalFOVRatio;
-  kInFovXYDistThreshold = 3 * (kCoveragePointCloudResolution / 2) / tan(M_PI / 15);
+  lidar_model_ns::LiDARScanPattern scan_pattern = lidar_model_ns::GetScanPattern(kLiDARModelType);
+  kUpperFOVRatio = tan(scan_pattern.GetUpperVerticalAngle() * M_PI / 180);
+  kLowerFOVRatio = tan(-scan_pattern.GetLowerVerticalAngle() * M_PI / 180);
+  kUpperDiffZMax = kSensorRange * kUpperFOVRatio;
+  kLowerDiffZMax = kSensorRange * kLowerFOVRatio;
+  // Within this horizontal distance the narrower half of the fov is thinner than the coverage resolution
+  double min_fov_ratio = std::min(kUpperFOVRatio, kLowerFOVRatio);
+  kInFovXYDistThreshold = min_fov_ratio > 0 ? 3 * (kCoveragePointCloudResolution / 2) / min_fov_ratio : 0;
   kInFovZDiffThreshold = 3 * kCoveragePointCloudResolution;
 
+  kUseStartupCache = misc_utils_ns::getParam<bool>(nh, "kUseStartupCache", true);
+  const char* home = std::getenv("HOME");
+  std::string default_cache_directory = home != nullptr ? std::string(home) + "/.ros/tare_planner" : "";
+  kStartupCacheDirectory = misc_utils_ns::getParam<std::string>(nh, "kStartupCacheDirectory", default_cache_directory);
+
   return true;
 }
 
-ViewPointManager::ViewPointManager(ros::NodeHandle& nh) : initialized_(false)
+ViewPointManager::ViewPointManager(ros::NodeHandle& nh)
+  : initialized_(false), connectivity_initialized_(false), candidate_graph_version_(0)
 {
   vp_.ReadParameters(nh);
 
-  kdtree_viewpoint_candidate_ = pcl::KdTreeFLANN<pcl::PointXYZI>::Ptr(new pcl::KdTreeFLANN<pcl::PointXYZI>());
   kdtree_viewpoint_in_collision_ = pcl::KdTreeFLANN<pcl::PointXYZI>::Ptr(new pcl::KdTreeFLANN<pcl::PointXYZI>());
-  viewpoint_candidate_cloud_ = pcl::PointCloud<pcl::PointXYZI>::Ptr(new pcl::PointCloud<pcl::PointXYZI>);
   viewpoint_in_collision_cloud_ = pcl::PointCloud<pcl::PointXYZI>::Ptr(new pcl::PointCloud<pcl::PointXYZI>);
 
   grid_ = std::make_unique<rolling_grid_ns::RollingGrid>(vp_.kNumber);
+  terrain_height_map_ = std::make_unique<terrain_height_map_ns::TerrainHeightMap>(vp_.kNumber, vp_.kResolution);
   origin_ = Eigen::Vector3d::Zero();
 
   // kViewPointNumber = kNumber.x() * kNumber.y() * kNumber.z();
-  viewpoints_.resize(vp_.kViewPointNumber);
-  for (int x = 0; x < vp_.kNumber.x(); x++)
-  {
-    for (int y = 0; y < vp_.kNumber.y(); y++)
-    {
-      for (int z = 0; z < vp_.kNumber.z(); z++)
-      {
-        Eigen::Vector3i sub(x, y, z);
-        int ind = grid_->Sub2Ind(sub);
-        viewpoints_[ind] = viewpoint_ns::ViewPoint();
-      }
-    }
-  }
+  viewpoints_.Resize(vp_.kViewPointNumber, vp_.kLiDARModelType);
 
   graph_index_map_.resize(vp_.kViewPointNumber);
   for (auto& ind : graph_index_map_)
@@ -103,9 +109,31 @@ ViewPointManager::ViewPointManager(ros::NodeHandle& nh) : initialized_(false)
     ind = -1;
   }
 
-  ComputeConnectedNeighborIndices();
-  ComputeInRangeNeighborIndices();
-  GetCollisionCorrespondence();
+  InitializeCollisionGrid();
+  bool use_startup_cache = vp_.kUseStartupCache && !vp_.kStartupCacheDirectory.empty();
+  std::string startup_cache_path;
+  bool startup_tables_loaded = false;
+  if (use_startup_cache)
+  {
+    startup_cache_path =
+        misc_utils_ns::GetTableCachePath(vp_.kStartupCacheDirectory, "viewpoint_manager", GetStartupCacheKey());
+    startup_tables_loaded = LoadStartupTables(startup_cache_path);
+  }
+  if (!startup_tables_loaded)
+  {
+    ComputeConnectedNeighborIndices();
+    ComputeInRangeNeighborIndices();
+    GetCollisionCorrespondence();
+  }
+  // Cheap once the ray templates are loaded, every ray is a cache hit
+  ComputeBoundaryViewPointSubs();
+  if (use_startup_cache && !startup_tables_loaded)
+  {
+    if (!misc_utils_ns::CreateDirectories(vp_.kStartupCacheDirectory) || !SaveStartupTables(startup_cache_path))
+    {
+      ROS_WARN_STREAM("ViewPointManager: cannot write startup cache " << startup_cache_path);
+    }
+  }
 
   local_planning_horizon_size_ = Eigen::Vector3d::Zero();
   for (int i = 0; i < vp_.dimension_; i++)
@@ -188,20 +216,25 @@ void ViewPointManager::ComputeInRangeNeighborIndices()
   }
 }
 
-void ViewPointManager::GetCollisionCorrespondence()
+void ViewPointManager::InitializeCollisionGrid()
 {
-  misc_utils_ns::Timer timer("get collision grid correspondence");
-  timer.Start();
-
   collision_grid_origin_ = Eigen::Vector3d::Zero();
   for (int i = 0; i < vp_.dimension_; i++)
   {
     collision_grid_origin_(i) -= vp_.kViewPointCollisionMargin;
   }
-  std::vector<int> viewpoint_index_correspondence;
-  collision_grid_ = std::make_unique<grid_ns::Grid<std::vector<int>>>(
-      vp_.kCollisionGridSize, viewpoint_index_correspondence, collision_grid_origin_, vp_.kCollisionGridResolution, 2);
+  collision_grid_ = std::make_unique<grid_ns::Grid<int>>(vp_.kCollisionGridSize, 0, collision_grid_origin_,
+                                                         vp_.kCollisionGridResolution, 2);
   collision_point_count_.resize(collision_grid_->GetCellNumber(), 0);
+}
+
+void ViewPointManager::GetCollisionCorrespondence()
+{
+  misc_utils_ns::Timer timer("get collision grid correspondence");
+  timer.Start();
+
+  collision_cell_offsets_.assign(collision_grid_->GetCellNumber() + 1, 0);
+  collision_viewpoint_indices_.clear();
 
   pcl::PointCloud<pcl::PointXYZI>::Ptr viewpoint_cloud(new pcl::PointCloud<pcl::PointXYZI>());
   pcl::KdTreeFLANN<pcl::PointXYZI>::Ptr kdtree(new pcl::KdTreeFLANN<pcl::PointXYZI>());
@@ -229,7 +262,7 @@ void ViewPointManager::GetCollisionCorrespondence()
   kdtree->setInputCloud(viewpoint_cloud);
   std::vector<int> nearby_viewpoint_indices;
   std::vector<float> nearby_viewpoint_sqdist;
-  int count = 0;
+  std::vector<std::vector<int>> cell_viewpoint_indices(collision_grid_->GetCellNumber());
   for (int x = 0; x < vp_.kCollisionGridSize.x(); x++)
   {
     for (int y = 0; y < vp_.kCollisionGridSize.y(); y++)
@@ -245,20 +278,126 @@ void ViewPointManager::GetCollisionCorrespondence()
         kdtree->radiusSearch(query_point, vp_.kViewPointCollisionMargin, nearby_viewpoint_indices,
                              nearby_viewpoint_sqdist);
         int grid_ind = collision_grid_->Sub2Ind(x, y, z);
+        collision_grid_->SetCellValue(grid_ind, nearby_viewpoint_indices.size());
+        cell_viewpoint_indices[grid_ind].reserve(nearby_viewpoint_indices.size());
         for (int i = 0; i < nearby_viewpoint_indices.size(); i++)
         {
           int ind = nearby_viewpoint_indices[i];
           int viewpoint_ind = (int)(viewpoint_cloud->points[ind].intensity);
           MY_ASSERT(viewpoint_ind >= 0 && viewpoint_ind < vp_.kViewPointNumber);
-          collision_grid_->GetCell(grid_ind).push_back(viewpoint_ind);
+          cell_viewpoint_indices[grid_ind].push_back(viewpoint_ind);
         }
       }
     }
   }
 
+  // Flatten into CSR form, the viewpoint indices are logical indices so the table stays valid after rolling
+  for (int i = 0; i < cell_viewpoint_indices.size(); i++)
+  {
+    collision_cell_offsets_[i + 1] = collision_cell_offsets_[i] + cell_viewpoint_indices[i].size();
+  }
+  collision_viewpoint_indices_.reserve(collision_cell_offsets_.back());
+  for (const auto& viewpoint_indices : cell_viewpoint_indices)
+  {
+    collision_viewpoint_indices_.insert(collision_viewpoint_indices_.end(), viewpoint_indices.begin(),
+                                        viewpoint_indices.end());
+  }
+
   timer.Stop(false);
 }
 
+uint64_t ViewPointManager::GetStartupCacheKey() const
+{
+  // Bump the version when the layout or the computation of the tables changes
+  const int kStartupCacheVersion = 1;
+  misc_utils_ns::HashBuilder hash;
+  hash.Add(kStartupCacheVersion);
+  for (int i = 0; i < 3; i++)
+  {
+    hash.Add(vp_.kNumber(i)).Add(vp_.kResolution(i));
+    hash.Add(vp_.kCollisionGridSize(i)).Add(vp_.kCollisionGridResolution(i));
+  }
+  hash.Add(vp_.kViewPointCollisionMargin).Add(vp_.kCollisionGridZScale).Add(vp_.kNeighborRange);
+  return hash.Get();
+}
+
+bool ViewPointManager::LoadStartupTables(const std::string& file_path)
+{
+  misc_utils_ns::TableCacheReader reader;
+  if (!reader.Open(file_path, GetStartupCacheKey()))
+  {
+    return false;
+  }
+  std::vector<std::vector<int>> connected_neighbor_indices;
+  std::vector<std::vector<double>> connected_neighbor_dist;
+  std::vector<std::vector<int>> in_range_neighbor_indices;
+  std::vector<int> collision_cell_offsets;
+  std::vector<int> collision_viewpoint_indices;
+  std::vector<int> ray_template_keys;
+  std::vector<std::vector<int>> ray_templates;
+  if (!reader.ReadNestedTable(connected_neighbor_indices) || !reader.ReadNestedTable(connected_neighbor_dist) ||
+      !reader.ReadNestedTable(in_range_neighbor_indices) || !reader.ReadTable(collision_cell_offsets) ||
+      !reader.ReadTable(collision_viewpoint_indices) || !reader.ReadTable(ray_template_keys) ||
+      !reader.ReadNestedTable(ray_templates) || !reader.AtEnd())
+  {
+    return false;
+  }
+  int cell_num = collision_grid_->GetCellNumber();
+  if (connected_neighbor_indices.size() != vp_.kViewPointNumber ||
+      connected_neighbor_dist.size() != vp_.kViewPointNumber ||
+      in_range_neighbor_indices.size() != vp_.kViewPointNumber || collision_cell_offsets.size() != cell_num + 1 ||
+      collision_cell_offsets.front() != 0 || collision_cell_offsets.back() != collision_viewpoint_indices.size() ||
+      ray_template_keys.size() != ray_templates.size())
+  {
+    return false;
+  }
+  for (const auto& viewpoint_ind : collision_viewpoint_indices)
+  {
+    if (viewpoint_ind < 0 || viewpoint_ind >= vp_.kViewPointNumber)
+    {
+      return false;
+    }
+  }
+
+  connected_neighbor_indices_.swap(connected_neighbor_indices);
+  connected_neighbor_dist_.swap(connected_neighbor_dist);
+  in_range_neighbor_indices_.swap(in_range_neighbor_indices);
+  collision_cell_offsets_.swap(collision_cell_offsets);
+  collision_viewpoint_indices_.swap(collision_viewpoint_indices);
+  for (int i = 0; i < cell_num; i++)
+  {
+    collision_grid_->SetCellValue(i, collision_cell_offsets_[i + 1] - collision_cell_offsets_[i]);
+  }
+  line_of_sight_ray_templates_.clear();
+  for (int i = 0; i < ray_template_keys.size(); i++)
+  {
+    line_of_sight_ray_templates_[ray_template_keys[i]].swap(ray_templates[i]);
+  }
+  return true;
+}
+
+bool ViewPointManager::SaveStartupTables(const std::string& file_path) const
+{
+  std::vector<int> ray_template_keys;
+  std::vector<std::vector<int>> ray_templates;
+  ray_template_keys.reserve(line_of_sight_ray_templates_.size());
+  ray_templates.reserve(line_of_sight_ray_templates_.size());
+  for (const auto& ray_template : line_of_sight_ray_templates_)
+  {
+    ray_template_keys.push_back(ray_template.first);
+    ray_templates.push_back(ray_template.second);
+  }
+  misc_utils_ns::TableCacheWriter writer(GetStartupCacheKey());
+  writer.AddNestedTable(connected_neighbor_indices_);
+  writer.AddNestedTable(connected_neighbor_dist_);
+  writer.AddNestedTable(in_range_neighbor_indices_);
+  writer.AddTable(collision_cell_offsets_);
+  writer.AddTable(collision_viewpoint_indices_);
+  writer.AddTable(ray_template_keys);
+  writer.AddNestedTable(ray_templates);
+  return writer.Write(file_path);
+}
+
 bool ViewPointManager::UpdateRobotPosition(const Eigen::Vector3d& robot_position)
 {
   robot_position_ = robot_position;
@@ -327,6 +466,7 @@ bool ViewPointManager::UpdateRobotPosition(const Eigen::Vector3d& robot_position
   // std::cout << "rolling x: " << rollover_step.x() << " y: " << rollover_step.y() << " z: " << rollover_step.z()
   //           << std::endl;
   grid_->Roll(rollover_step);
+  terrain_height_map_->Roll(rollover_step);
 
   misc_utils_ns::Timer reset_timer("reset viewpoint");
   reset_timer.Start();
@@ -347,6 +487,7 @@ bool ViewPointManager::UpdateRobotPosition(const Eigen::Vector3d& robot_position
     new_position.z = robot_position_.z();
     SetViewPointPosition(ind, new_position);
     ResetViewPoint(ind);
+    connectivity_dirty_array_indices_.push_back(grid_->GetArrayInd(ind));
   }
   reset_timer.Stop(false);
   return true;
@@ -358,6 +499,7 @@ void ViewPointManager::UpdateOrigin()
   {
     origin_(i) = robot_position_(i) - (vp_.kResolution(i) * vp_.kNumber(i)) / 2.0;
   }
+  terrain_height_map_->SetOrigin(origin_);
 }
 
 int ViewPointManager::GetViewPointArrayInd(int viewpoint_ind, bool use_array_ind) const
@@ -398,48 +540,45 @@ int ViewPointManager::GetViewPointInd(Eigen::Vector3d position)
 void ViewPointManager::GetVisualizationCloud(pcl::PointCloud<pcl::PointXYZI>::Ptr& vis_cloud)
 {
   vis_cloud->clear();
-  for (int i = 0; i < vp_.kViewPointNumber; i++)
-  {
-    if (IsViewPointCandidate(i, true))
+  const misc_utils_ns::DynamicBitset& candidate_set = viewpoints_.GetStateSet(viewpoint_ns::ViewPointState::CANDIDATE);
+  for (int i = candidate_set.FindNext(0); i >= 0; i = candidate_set.FindNext(i + 1))
+  {
+    geometry_msgs::Point position = GetViewPointPosition(i, true);
+    pcl::PointXYZI vis_point;
+    vis_point.x = position.x;
+    vis_point.y = position.y;
+    vis_point.z = position.z;
+    // vis_point.intensity = graph_index_map_[i];
+    // if (viewpoints_[i].Visited())
+    if (ViewPointVisited(i, true))
     {
-      geometry_msgs::Point position = GetViewPointPosition(i, true);
-      pcl::PointXYZI vis_point;
-      vis_point.x = position.x;
-      vis_point.y = position.y;
-      vis_point.z = position.z;
-      // vis_point.intensity = graph_index_map_[i];
-      // if (viewpoints_[i].Visited())
-      if (ViewPointVisited(i, true))
-      {
-        vis_point.intensity = -1.0;
-      }
-      else
-      {
-        vis_point.intensity = GetViewPointCoveredPointNum(i, true);
-        vis_point.intensity += i * 1.0 / 10000.0;
-      }
-      // if (viewpoints_[i].InCurrentFrameLineOfSight())
-      // {
-      //   vis_point.intensity = 100;
-      // }
-      // else
-      // {
-      //   vis_point.intensity = -1;
-      // }
-      vis_cloud->points.push_back(vis_point);
+      vis_point.intensity = -1.0;
+    }
+    else
+    {
+      vis_point.intensity = GetViewPointCoveredPointNum(i, true);
+      vis_point.intensity += i * 1.0 / 10000.0;
     }
+    // if (viewpoints_[i].InCurrentFrameLineOfSight())
+    // {
+    //   vis_point.intensity = 100;
+    // }
+    // else
+    // {
+    //   vis_point.intensity = -1;
+    // }
+    vis_cloud->points.push_back(vis_point);
   }
 }
 
 void ViewPointManager::CheckViewPointCollisionWithCollisionGrid(
     const pcl::PointCloud<pcl::PointXYZI>::Ptr& collision_cloud)
 {
-  for (int i = 0; i < viewpoints_.size(); i++)
+  const misc_utils_ns::DynamicBitset& collision_set =
+      viewpoints_.GetStateSet(viewpoint_ns::ViewPointState::IN_COLLISION);
+  for (int i = collision_set.FindNext(0); i >= 0; i = collision_set.FindNext(i + 1))
   {
-    if (ViewPointInCollision(i, true))
-    {
-      AddViewPointCollisionFrameCount(i, true);
-    }
+    AddViewPointCollisionFrameCount(i, true);
   }
   std::fill(collision_point_count_.begin(), collision_point_count_.end(), 0);
   collision_grid_origin_ = origin_ - Eigen::Vector3d::Ones() * vp_.kViewPointCollisionMargin;
@@ -453,10 +592,8 @@ void ViewPointManager::CheckViewPointCollisionWithCollisionGrid(
       collision_point_count_[collision_grid_ind]++;
       if (collision_point_count_[collision_grid_ind] >= vp_.kCollisionPointThr)
       {
-        std::vector<int> collision_viewpoint_indices = collision_grid_->GetCellValue(collision_grid_ind);
-        for (int i = 0; i < collision_viewpoint_indices.size(); i++)
+        for (const auto& viewpoint_ind : GetCollisionViewPointIndices(collision_grid_ind))
         {
-          int viewpoint_ind = collision_viewpoint_indices[i];
           MY_ASSERT(viewpoint_ind >= 0 && viewpoint_ind < vp_.kViewPointNumber);
           double z_diff = point.z - GetViewPointHeight(viewpoint_ind);
           if ((z_diff >= 0 && z_diff <= vp_.kViewPointCollisionMarginZPlus) ||
@@ -544,23 +681,101 @@ void ViewPointManager::CheckViewPointCollisionWithTerrain(const pcl::PointCloud<
   CheckViewPointCollisionWithCollisionGrid(collision_cloud);
 }
 
-void ViewPointManager::CheckViewPointLineOfSightHelper(const Eigen::Vector3i& start_sub, const Eigen::Vector3i& end_sub,
-                                                       const Eigen::Vector3i& max_sub, const Eigen::Vector3i& min_sub)
+void ViewPointManager::ComputeBoundaryViewPointSubs()
 {
-  if (end_sub == start_sub)
-    return;
-  int viewpoint_ind = grid_->Sub2Ind(end_sub);
-  geometry_msgs::Point viewpoint_position = GetViewPointPosition(viewpoint_ind);
+  boundary_viewpoint_subs_.clear();
+  std::vector<bool> added(vp_.kViewPointNumber, false);
+  auto add_boundary_sub = [&](int x, int y, int z) {
+    Eigen::Vector3i sub(x, y, z);
+    int ind = grid_->Sub2Ind(sub);
+    if (!added[ind])
+    {
+      boundary_viewpoint_subs_.push_back(sub);
+      added[ind] = true;
+    }
+  };
+  // Same order as the faces were swept before: x faces, y faces, then z faces
+  int x_indices[2] = { 0, vp_.kNumber.x() - 1 };
+  int y_indices[2] = { 0, vp_.kNumber.y() - 1 };
+  int z_indices[2] = { 0, vp_.kNumber.z() - 1 };
+  for (int xi = 0; xi < 2; xi++)
+  {
+    for (int y = 0; y < vp_.kNumber.y(); y++)
+    {
+      for (int z = 0; z < vp_.kNumber.z(); z++)
+      {
+        add_boundary_sub(x_indices[xi], y, z);
+      }
+    }
+  }
+  for (int x = 0; x < vp_.kNumber.x(); x++)
+  {
+    for (int yi = 0; yi < 2; yi++)
+    {
+      for (int z = 0; z < vp_.kNumber.z(); z++)
+      {
+        add_boundary_sub(x, y_indices[yi], z);
+      }
+    }
+  }
+  for (int x = 0; x < vp_.kNumber.x(); x++)
+  {
+    for (int y = 0; y < vp_.kNumber.y(); y++)
+    {
+      for (int zi = 0; zi < 2; zi++)
+      {
+        add_boundary_sub(x, y, z_indices[zi]);
+      }
+    }
+  }
+
+  // Warm up the ray templates for the robot at the center of the grid
+  Eigen::Vector3i center_sub = vp_.kNumber / 2;
+  for (const auto& end_sub : boundary_viewpoint_subs_)
+  {
+    GetLineOfSightRayTemplate(center_sub, end_sub);
+  }
+}
+
+const std::vector<int>& ViewPointManager::GetLineOfSightRayTemplate(const Eigen::Vector3i& start_sub,
+                                                                    const Eigen::Vector3i& end_sub)
+{
+  Eigen::Vector3i diff_sub = end_sub - start_sub;
+  int size_x = 2 * vp_.kNumber.x() - 1;
+  int size_y = 2 * vp_.kNumber.y() - 1;
+  int key = (diff_sub.x() + vp_.kNumber.x() - 1) + (diff_sub.y() + vp_.kNumber.y() - 1) * size_x +
+            (diff_sub.z() + vp_.kNumber.z() - 1) * size_x * size_y;
+  auto it = line_of_sight_ray_templates_.find(key);
+  if (it != line_of_sight_ray_templates_.end())
+  {
+    return it->second;
+  }
+
+  // RayCast from an integer start cell is translation invariant, so the ray is stored as index offsets
   std::vector<Eigen::Vector3i> ray_cast_cells;
+  Eigen::Vector3i max_sub(vp_.kNumber.x() - 1, vp_.kNumber.y() - 1, vp_.kNumber.z() - 1);
+  Eigen::Vector3i min_sub(0, 0, 0);
   misc_utils_ns::RayCast(start_sub, end_sub, max_sub, min_sub, ray_cast_cells);
-  if (ray_cast_cells.size() > 1)
+  std::vector<int>& ray_template = line_of_sight_ray_templates_[key];
+  int start_ind = grid_->Sub2Ind(start_sub);
+  ray_template.reserve(ray_cast_cells.size());
+  for (const auto& cell_sub : ray_cast_cells)
+  {
+    ray_template.push_back(grid_->Sub2Ind(cell_sub) - start_ind);
+  }
+  return ray_template;
+}
+
+void ViewPointManager::CheckViewPointLineOfSightHelper(int start_ind, const std::vector<int>& ray_template)
+{
+  if (ray_template.size() > 1)
   {
     if (vp_.kLineOfSightStopAtNearestObstacle)
     {
       bool occlude = false;
-      for (int i = 1; i < ray_cast_cells.size(); i++)
+      for (int i = 1; i < ray_template.size(); i++)
       {
-        int viewpoint_ind = grid_->Sub2Ind(ray_cast_cells[i]);
+        int viewpoint_ind = start_ind + ray_template[i];
         if (ViewPointInCollision(viewpoint_ind) && GetViewPointCollisionFrameCount(viewpoint_ind) == 0)
         {
           occlude = true;
@@ -582,9 +797,9 @@ void ViewPointManager::CheckViewPointLineOfSightHelper(const Eigen::Vector3i& st
     {
       bool hit_obstacle = false;
       bool in_line_of_sight = false;
-      for (int i = ray_cast_cells.size() - 1; i >= 0; i--)
+      for (int i = ray_template.size() - 1; i >= 0; i--)
       {
-        int viewpoint_ind = grid_->Sub2Ind(ray_cast_cells[i]);
+        int viewpoint_ind = start_ind + ray_template[i];
         if (ViewPointInCollision(viewpoint_ind) && GetViewPointCollisionFrameCount(viewpoint_ind) == 0)
         {
           hit_obstacle = true;
@@ -610,9 +825,9 @@ void ViewPointManager::CheckViewPointLineOfSightHelper(const Eigen::Vector3i& st
       }
       if (!hit_obstacle)
       {
-        for (int i = ray_cast_cells.size() - 1; i >= 0; i--)
+        for (int i = ray_template.size() - 1; i >= 0; i--)
         {
-          int viewpoint_ind = grid_->Sub2Ind(ray_cast_cells[i]);
+          int viewpoint_ind = start_ind + ray_template[i];
           SetViewPointInLineOfSight(viewpoint_ind, true);
         }
       }
@@ -620,9 +835,9 @@ void ViewPointManager::CheckViewPointLineOfSightHelper(const Eigen::Vector3i& st
 
     // Set in current frame line of sight
     bool occlude = false;
-    for (int i = 1; i < ray_cast_cells.size(); i++)
+    for (int i = 1; i < ray_template.size(); i++)
     {
-      int viewpoint_ind = grid_->Sub2Ind(ray_cast_cells[i]);
+      int viewpoint_ind = start_ind + ray_template[i];
       if (ViewPointInCollision(viewpoint_ind) && GetViewPointCollisionFrameCount(viewpoint_ind) == 0)
       {
         occlude = true;
@@ -641,10 +856,7 @@ void ViewPointManager::CheckViewPointLineOfSight()
   if (!initialized_)
     return;
 
-  for (int i = 0; i < viewpoints_.size(); i++)
-  {
-    SetViewPointInCurrentFrameLineOfSight(i, false, true);
-  }
+  viewpoints_.ClearState(viewpoint_ns::ViewPointState::IN_CURRENT_FRAME_LINE_OF_SIGHT);
 
   Eigen::Vector3i robot_sub = GetViewPointSub(robot_position_);
   MY_ASSERT(grid_->InRange(robot_sub));
@@ -652,67 +864,11 @@ void ViewPointManager::CheckViewPointLineOfSight()
   SetViewPointInLineOfSight(robot_viewpoint_ind, true);
   SetViewPointInCurrentFrameLineOfSight(robot_viewpoint_ind, true);
 
-  std::vector<bool> checked(vp_.kViewPointNumber, false);
-  std::vector<Eigen::Vector3i> ray_cast_cells;
-  Eigen::Vector3i max_sub(vp_.kNumber.x() - 1, vp_.kNumber.y() - 1, vp_.kNumber.z() - 1);
-  Eigen::Vector3i min_sub(0, 0, 0);
-
-  int x_indices[2] = { 0, vp_.kNumber.x() - 1 };
-  int y_indices[2] = { 0, vp_.kNumber.y() - 1 };
-  int z_indices[2] = { 0, vp_.kNumber.z() - 1 };
-
-  for (int xi = 0; xi < 2; xi++)
-  {
-    for (int y = 0; y < vp_.kNumber.y(); y++)
-    {
-      for (int z = 0; z < vp_.kNumber.z(); z++)
-      {
-        int x = x_indices[xi];
-        Eigen::Vector3i end_sub(x, y, z);
-        int array_ind = grid_->GetArrayInd(end_sub);
-        if (!checked[array_ind])
-        {
-          CheckViewPointLineOfSightHelper(robot_sub, end_sub, max_sub, min_sub);
-          checked[array_ind] = true;
-        }
-      }
-    }
-  }
-
-  for (int x = 0; x < vp_.kNumber.x(); x++)
+  for (const auto& end_sub : boundary_viewpoint_subs_)
   {
-    for (int yi = 0; yi < 2; yi++)
-    {
-      for (int z = 0; z < vp_.kNumber.z(); z++)
-      {
-        int y = y_indices[yi];
-        Eigen::Vector3i end_sub(x, y, z);
-        int array_ind = grid_->GetArrayInd(end_sub);
-        if (!checked[array_ind])
-        {
-          CheckViewPointLineOfSightHelper(robot_sub, end_sub, max_sub, min_sub);
-          checked[array_ind] = true;
-        }
-      }
-    }
-  }
-
-  for (int x = 0; x < vp_.kNumber.x(); x++)
-  {
-    for (int y = 0; y < vp_.kNumber.y(); y++)
-    {
-      for (int zi = 0; zi < 2; zi++)
-      {
-        int z = z_indices[zi];
-        Eigen::Vector3i end_sub(x, y, z);
-        int array_ind = grid_->GetArrayInd(end_sub);
-        if (!checked[array_ind])
-        {
-          CheckViewPointLineOfSightHelper(robot_sub, end_sub, max_sub, min_sub);
-          checked[array_ind] = true;
-        }
-      }
-    }
+    if (end_sub == robot_sub)
+      continue;
+    CheckViewPointLineOfSightHelper(robot_viewpoint_ind, GetLineOfSightRayTemplate(robot_sub, end_sub));
   }
 }
 
@@ -738,8 +894,8 @@ bool ViewPointManager::InFOV(const Eigen::Vector3d& point_position, const Eigen:
 {
   Eigen::Vector3d diff = point_position - viewpoint_position;
   double xy_diff = sqrt(diff.x() * diff.x() + diff.y() * diff.y());
-  double z_diff = std::abs(diff.z());
-  if (z_diff < vp_.kVerticalFOVRatio * xy_diff)
+  double z_diff = diff.z();
+  if (z_diff < vp_.kUpperFOVRatio * xy_diff && -z_diff < vp_.kLowerFOVRatio * xy_diff)
   {
     return true;
   }
@@ -752,8 +908,8 @@ bool ViewPointManager::InFOV(const Eigen::Vector3d& point_position, const Eigen:
 bool ViewPointManager::InFOVAndRange(const Eigen::Vector3d& point_position, const Eigen::Vector3d& viewpoint_position)
 {
   Eigen::Vector3d diff = point_position - viewpoint_position;
-  double z_diff = std::abs(diff.z());
-  if (z_diff > vp_.kDiffZMax)
+  double z_diff = diff.z();
+  if (z_diff > vp_.kUpperDiffZMax || -z_diff > vp_.kLowerDiffZMax)
   {
     return false;
   }
@@ -762,7 +918,7 @@ bool ViewPointManager::InFOVAndRange(const Eigen::Vector3d& point_position, cons
   {
     return false;
   }
-  if (z_diff < vp_.kVerticalFOVRatio * xy_diff)
+  if (z_diff < vp_.kUpperFOVRatio * xy_diff && -z_diff < vp_.kLowerFOVRatio * xy_diff)
   {
     return true;
   }
@@ -815,42 +971,182 @@ void ViewPointManager::CheckViewPointConnectivity()
       return;
     }
   }
-  for (auto& viewpoint : viewpoints_)
+
+  UpdateConnectivityLabels();
+  if (!connectivity_traversable_[robot_array_ind])
+  {
+    // The start viewpoint may be out of line of sight, search from it directly
+    CheckViewPointConnectivityFrom(robot_ind);
+    return;
+  }
+  int robot_label = FindConnectivityLabel(connectivity_label_[robot_array_ind]);
+  for (int i = 0; i < vp_.kViewPointNumber; i++)
   {
-    viewpoint.SetConnected(false);
+    int label = connectivity_label_[i];
+    viewpoints_.SetState(viewpoint_ns::ViewPointState::CONNECTED, i,
+                         label >= 0 && FindConnectivityLabel(label) == robot_label);
   }
+}
+
+void ViewPointManager::CheckViewPointConnectivityFrom(int start_ind)
+{
+  viewpoints_.ClearState(viewpoint_ns::ViewPointState::CONNECTED);
   std::vector<bool> checked(vp_.kViewPointNumber, false);
-  checked[robot_ind] = true;
-  SetViewPointConnected(robot_ind, true);
-  std::list<int> queue;
-  queue.push_back(robot_ind);
-  int connected_viewpoint_count = 1;
-  while (!queue.empty())
-  {
-    int cur_ind = queue.front();
-    queue.pop_front();
-    for (int i = 0; i < connected_neighbor_indices_[cur_ind].size(); i++)
+  checked[start_ind] = true;
+  SetViewPointConnected(start_ind, true);
+  std::vector<int> queue;
+  queue.push_back(start_ind);
+  for (int queue_head = 0; queue_head < queue.size(); queue_head++)
+  {
+    int cur_ind = queue[queue_head];
+    for (const auto& neighbor_ind : connected_neighbor_indices_[cur_ind])
     {
-      int neighbor_ind = connected_neighbor_indices_[cur_ind][i];
-      if (!grid_->InRange(neighbor_ind))
+      if (!checked[neighbor_ind] && ViewPointTraversable(neighbor_ind) &&
+          std::abs(GetViewPointHeight(cur_ind) - GetViewPointHeight(neighbor_ind)) < vp_.kCollisionCheckTerrainThr)
       {
-        std::cout << "ViewPointManager::CheckViewPointConnectivity: neighbor ind out of bound" << std::endl;
-        continue;
+        SetViewPointConnected(neighbor_ind, true);
+        checked[neighbor_ind] = true;
+        queue.push_back(neighbor_ind);
       }
-      if (!checked[neighbor_ind] && !ViewPointInCollision(neighbor_ind) && ViewPointInLineOfSight(neighbor_ind))
+    }
+  }
+}
+
+bool ViewPointManager::ViewPointTraversable(int viewpoint_ind, bool use_array_ind)
+{
+  return !ViewPointInCollision(viewpoint_ind, use_array_ind) && ViewPointInLineOfSight(viewpoint_ind, use_array_ind);
+}
+
+int ViewPointManager::FindConnectivityLabel(int label)
+{
+  while (connectivity_label_parent_[label] != label)
+  {
+    connectivity_label_parent_[label] = connectivity_label_parent_[connectivity_label_parent_[label]];
+    label = connectivity_label_parent_[label];
+  }
+  return label;
+}
+
+void ViewPointManager::LabelConnectedComponents(const std::vector<int>& seed_array_indices)
+{
+  std::vector<int> queue;
+  for (const auto& seed_array_ind : seed_array_indices)
+  {
+    if (connectivity_label_[seed_array_ind] >= 0 || !connectivity_traversable_[seed_array_ind])
+    {
+      continue;
+    }
+    int label = connectivity_label_parent_.size();
+    connectivity_label_parent_.push_back(label);
+    connectivity_label_[seed_array_ind] = label;
+    queue.clear();
+    queue.push_back(seed_array_ind);
+    for (int queue_head = 0; queue_head < queue.size(); queue_head++)
+    {
+      int cur_array_ind = queue[queue_head];
+      int cur_ind = grid_->GetInd(cur_array_ind);
+      for (const auto& neighbor_ind : connected_neighbor_indices_[cur_ind])
       {
-        if (std::abs(GetViewPointHeight(cur_ind) - GetViewPointHeight(neighbor_ind)) < vp_.kCollisionCheckTerrainThr)
+        int neighbor_array_ind = grid_->GetArrayInd(neighbor_ind);
+        if (!connectivity_traversable_[neighbor_array_ind] ||
+            std::abs(connectivity_height_[cur_array_ind] - connectivity_height_[neighbor_array_ind]) >=
+                vp_.kCollisionCheckTerrainThr)
+        {
+          continue;
+        }
+        int neighbor_label = connectivity_label_[neighbor_array_ind];
+        if (neighbor_label < 0)
+        {
+          connectivity_label_[neighbor_array_ind] = label;
+          queue.push_back(neighbor_array_ind);
+        }
+        else
         {
-          SetViewPointConnected(neighbor_ind, true);
-          connected_viewpoint_count++;
-          queue.push_back(neighbor_ind);
+          // Reached a component that is still valid, merge it
+          int neighbor_root = FindConnectivityLabel(neighbor_label);
+          int root = FindConnectivityLabel(label);
+          if (neighbor_root != root)
+          {
+            connectivity_label_parent_[root] = neighbor_root;
+          }
         }
       }
-      checked[neighbor_ind] = true;
     }
   }
 }
 
+void ViewPointManager::UpdateConnectivityLabels()
+{
+  std::vector<int> changed_array_indices;
+  // Rebuild from scratch at the start and when the union-find has grown too large
+  if (!connectivity_initialized_ || connectivity_label_parent_.size() > 4 * vp_.kViewPointNumber)
+  {
+    connectivity_label_.assign(vp_.kViewPointNumber, -1);
+    connectivity_label_parent_.clear();
+    connectivity_traversable_.assign(vp_.kViewPointNumber, false);
+    connectivity_height_.assign(vp_.kViewPointNumber, 0.0);
+    for (int i = 0; i < vp_.kViewPointNumber; i++)
+    {
+      connectivity_traversable_[i] = ViewPointTraversable(i, true);
+      connectivity_height_[i] = GetViewPointHeight(i, true);
+      changed_array_indices.push_back(i);
+    }
+    connectivity_dirty_array_indices_.clear();
+    connectivity_initialized_ = true;
+    LabelConnectedComponents(changed_array_indices);
+    return;
+  }
+
+  // Viewpoints that were rolled in, or whose traversability or height changed since the last update
+  std::vector<bool> changed(vp_.kViewPointNumber, false);
+  for (const auto& array_ind : connectivity_dirty_array_indices_)
+  {
+    changed[array_ind] = true;
+  }
+  connectivity_dirty_array_indices_.clear();
+  for (int i = 0; i < vp_.kViewPointNumber; i++)
+  {
+    bool traversable = ViewPointTraversable(i, true);
+    double height = GetViewPointHeight(i, true);
+    if (traversable != connectivity_traversable_[i] || (traversable && height != connectivity_height_[i]))
+    {
+      changed[i] = true;
+    }
+    connectivity_traversable_[i] = traversable;
+    connectivity_height_[i] = height;
+    if (changed[i])
+    {
+      changed_array_indices.push_back(i);
+    }
+  }
+  if (changed_array_indices.empty())
+  {
+    return;
+  }
+
+  // A changed viewpoint may split the component it belonged to, so these components are relabelled. Components
+  // that a changed viewpoint now connects to are merged during labelling.
+  std::vector<bool> invalid_label(connectivity_label_parent_.size(), false);
+  for (const auto& array_ind : changed_array_indices)
+  {
+    if (connectivity_label_[array_ind] >= 0)
+    {
+      invalid_label[FindConnectivityLabel(connectivity_label_[array_ind])] = true;
+    }
+  }
+  std::vector<int> relabel_array_indices;
+  for (int i = 0; i < vp_.kViewPointNumber; i++)
+  {
+    int label = connectivity_label_[i];
+    if (changed[i] || (label >= 0 && invalid_label[FindConnectivityLabel(label)]))
+    {
+      connectivity_label_[i] = -1;
+      relabel_array_indices.push_back(i);
+    }
+  }
+  LabelConnectedComponents(relabel_array_indices);
+}
+
 void ViewPointManager::UpdateViewPointVisited(const std::vector<Eigen::Vector3d>& positions)
 {
   if (!initialized_)
@@ -882,7 +1178,7 @@ void ViewPointManager::UpdateViewPointVisited(const std::vector<Eigen::Vector3d>
 
 void ViewPointManager::UpdateViewPointVisited(std::unique_ptr<grid_world_ns::GridWorld> const& grid_world)
 {
-  for (int i = 0; i < viewpoints_.size(); i++)
+  for (int i = 0; i < viewpoints_.Size(); i++)
   {
     // 一整个cell内的viewpoint都设置为visited
     geometry_msgs::Point viewpoint_position = GetViewPointPosition(i, true);
@@ -898,8 +1194,15 @@ void ViewPointManager::UpdateViewPointVisited(std::unique_ptr<grid_world_ns::Gri
   }
 }
 
-void ViewPointManager:: SetViewPointHeightWithTerrain(const pcl::PointCloud<pcl::PointXYZI>::Ptr& terrain_cloud,
-                                                     double terrain_height_threshold)
+void ViewPointManager::UpdateTerrainHeightMap(const pcl::PointCloud<pcl::PointXYZI>::Ptr& terrain_cloud,
+                                              double terrain_height_threshold)
+{
+  if (!initialized_)
+    return;
+  terrain_height_map_->UpdateHeight(terrain_cloud, terrain_height_threshold);
+}
+
+void ViewPointManager::SetViewPointHeightWithTerrain()
 {
   // Set the height of the viewpoint nearby the robot to be the height of the robot, in case there is no terrain cloud
   // within the blind spot.
@@ -927,18 +1230,23 @@ void ViewPointManager:: SetViewPointHeightWithTerrain(const pcl::PointCloud<pcl:
     }
   }
 
-  // Set the height of other viewpoints
-  for (const auto& terrain_point : terrain_cloud->points)
+  // Set the height of other viewpoints from the lowest terrain observed in their cells
+  for (int x = 0; x < vp_.kNumber.x(); x++)
   {
-    if (terrain_point.intensity > terrain_height_threshold)
-    {
-      continue;
-    }
-    Eigen::Vector3i viewpoint_sub = GetViewPointSub(Eigen::Vector3d(terrain_point.x, terrain_point.y, terrain_point.z));
-    if (grid_->InRange(viewpoint_sub))
+    for (int y = 0; y < vp_.kNumber.y(); y++)
     {
+      Eigen::Vector3i viewpoint_sub(x, y, 0);
+      if (!terrain_height_map_->HasHeight(viewpoint_sub))
+      {
+        continue;
+      }
+      double terrain_height = terrain_height_map_->GetMinHeight(viewpoint_sub);
+      if (vp_.kViewPointHeightSmoothingRadius > 0)
+      {
+        terrain_height_map_->GetSmoothedMinHeight(viewpoint_sub, vp_.kViewPointHeightSmoothingRadius, terrain_height);
+      }
       int viewpoint_ind = grid_->Sub2Ind(viewpoint_sub);
-      double target_height = terrain_point.z + vp_.kViewPointHeightFromTerrain;
+      double target_height = terrain_height + vp_.kViewPointHeightFromTerrain;
       // If the viewpoint has not been set height with terrain points, or if there is a terrain point with a lower
       // height
       if (!ViewPointHasTerrainHeight(viewpoint_ind) || target_height < GetViewPointHeight(viewpoint_ind))
@@ -986,205 +1294,203 @@ void ViewPointManager:: SetViewPointHeightWithTerrain(const pcl::PointCloud<pcl:
 void ViewPointManager::ResetViewPoint(int viewpoint_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  viewpoints_[array_ind].Reset();
+  viewpoints_.Reset(array_ind);
 }
 
 void ViewPointManager::ResetViewPointCoverage()
 {
-  for (auto& viewpoint : viewpoints_)
-  {
-    viewpoint.ResetCoverage();
-  }
+  viewpoints_.ResetCoverage();
 }
 
 // Collision
 bool ViewPointManager::ViewPointInCollision(int viewpoint_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  return viewpoints_[array_ind].InCollision();
+  return viewpoints_.GetState(viewpoint_ns::ViewPointState::IN_COLLISION, array_ind);
 }
 void ViewPointManager::SetViewPointCollision(int viewpoint_ind, bool in_collision, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  viewpoints_[array_ind].SetInCollision(in_collision);
+  viewpoints_.SetState(viewpoint_ns::ViewPointState::IN_COLLISION, array_ind, in_collision);
 }
 // Line of Sight
 bool ViewPointManager::ViewPointInLineOfSight(int viewpoint_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  return viewpoints_[array_ind].InLineOfSight();
+  return viewpoints_.GetState(viewpoint_ns::ViewPointState::IN_LINE_OF_SIGHT, array_ind);
 }
 void ViewPointManager::SetViewPointInLineOfSight(int viewpoint_ind, bool in_line_of_sight, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  viewpoints_[array_ind].SetInLineOfSight(in_line_of_sight);
+  viewpoints_.SetState(viewpoint_ns::ViewPointState::IN_LINE_OF_SIGHT, array_ind, in_line_of_sight);
 }
 // Connectivity
 bool ViewPointManager::ViewPointConnected(int viewpoint_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  return viewpoints_[array_ind].Connected();
+  return viewpoints_.GetState(viewpoint_ns::ViewPointState::CONNECTED, array_ind);
 }
 void ViewPointManager::SetViewPointConnected(int viewpoint_ind, bool connected, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  viewpoints_[array_ind].SetConnected(connected);
+  viewpoints_.SetState(viewpoint_ns::ViewPointState::CONNECTED, array_ind, connected);
 }
 // Visited
 bool ViewPointManager::ViewPointVisited(int viewpoint_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  return viewpoints_[array_ind].Visited();
+  return viewpoints_.GetState(viewpoint_ns::ViewPointState::VISITED, array_ind);
 }
 void ViewPointManager::SetViewPointVisited(int viewpoint_ind, bool visited, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  viewpoints_[array_ind].SetVisited(visited);
+  viewpoints_.SetState(viewpoint_ns::ViewPointState::VISITED, array_ind, visited);
 }
 // Selected
 bool ViewPointManager::ViewPointSelected(int viewpoint_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  return viewpoints_[array_ind].Selected();
+  return viewpoints_.GetState(viewpoint_ns::ViewPointState::SELECTED, array_ind);
 }
 void ViewPointManager::SetViewPointSelected(int viewpoint_ind, bool selected, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  viewpoints_[array_ind].SetSelected(selected);
+  viewpoints_.SetState(viewpoint_ns::ViewPointState::SELECTED, array_ind, selected);
 }
 // Candidacy
 bool ViewPointManager::IsViewPointCandidate(int viewpoint_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  return viewpoints_[array_ind].IsCandidate();
+  return viewpoints_.GetState(viewpoint_ns::ViewPointState::CANDIDATE, array_ind);
 }
 void ViewPointManager::SetViewPointCandidate(int viewpoint_ind, bool candidate, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  viewpoints_[array_ind].SetCandidate(candidate);
+  viewpoints_.SetState(viewpoint_ns::ViewPointState::CANDIDATE, array_ind, candidate);
 }
 // Terrain Height
 bool ViewPointManager::ViewPointHasTerrainHeight(int viewpoint_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  return viewpoints_[array_ind].HasTerrainHeight();
+  return viewpoints_.GetState(viewpoint_ns::ViewPointState::HAS_TERRAIN_HEIGHT, array_ind);
 }
 void ViewPointManager::SetViewPointHasTerrainHeight(int viewpoint_ind, bool has_terrain_height, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  viewpoints_[array_ind].SetHasTerrainHeight(has_terrain_height);
+  viewpoints_.SetState(viewpoint_ns::ViewPointState::HAS_TERRAIN_HEIGHT, array_ind, has_terrain_height);
 }
 // In exploring cell
 bool ViewPointManager::ViewPointInExploringCell(int viewpoint_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  return viewpoints_[array_ind].InExploringCell();
+  return viewpoints_.GetState(viewpoint_ns::ViewPointState::IN_EXPLORING_CELL, array_ind);
 }
 void ViewPointManager::SetViewPointInExploringCell(int viewpoint_ind, bool in_exploring_cell, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  viewpoints_[array_ind].SetInExploringCell(in_exploring_cell);
+  viewpoints_.SetState(viewpoint_ns::ViewPointState::IN_EXPLORING_CELL, array_ind, in_exploring_cell);
 }
 // Height
 double ViewPointManager::GetViewPointHeight(int viewpoint_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  return viewpoints_[array_ind].GetHeight();
+  return viewpoints_.GetHeight(array_ind);
 }
 void ViewPointManager::SetViewPointHeight(int viewpoint_ind, double height, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  viewpoints_[array_ind].SetHeight(height);
+  viewpoints_.SetHeight(array_ind, height);
 }
 // In current frame line of sight
 bool ViewPointManager::ViewPointInCurrentFrameLineOfSight(int viewpoint_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  return viewpoints_[array_ind].InCurrentFrameLineOfSight();
+  return viewpoints_.GetState(viewpoint_ns::ViewPointState::IN_CURRENT_FRAME_LINE_OF_SIGHT, array_ind);
 }
 void ViewPointManager::SetViewPointInCurrentFrameLineOfSight(int viewpoint_ind, bool in_current_frame_line_of_sight,
                                                              bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  viewpoints_[array_ind].SetInCurrentFrameLineOfSight(in_current_frame_line_of_sight);
+  viewpoints_.SetState(viewpoint_ns::ViewPointState::IN_CURRENT_FRAME_LINE_OF_SIGHT, array_ind,
+                       in_current_frame_line_of_sight);
 }
 // Position
 geometry_msgs::Point ViewPointManager::GetViewPointPosition(int viewpoint_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  return viewpoints_[array_ind].GetPosition();
+  return viewpoints_.GetPosition(array_ind);
 }
 void ViewPointManager::SetViewPointPosition(int viewpoint_ind, geometry_msgs::Point position, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  viewpoints_[array_ind].SetPosition(position);
+  viewpoints_.SetPosition(array_ind, position);
 }
 // Cell Ind
 int ViewPointManager::GetViewPointCellInd(int viewpoint_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  return viewpoints_[array_ind].GetCellInd();
+  return viewpoints_.GetCellInd(array_ind);
 }
 void ViewPointManager::SetViewPointCellInd(int viewpoint_ind, int cell_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  viewpoints_[array_ind].SetCellInd(cell_ind);
+  viewpoints_.SetCellInd(array_ind, cell_ind);
 }
 // Collision frame count
 int ViewPointManager::GetViewPointCollisionFrameCount(int viewpoint_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  return viewpoints_[array_ind].GetCollisionFrameCount();
+  return viewpoints_.GetCollisionFrameCount(array_ind);
 }
 void ViewPointManager::AddViewPointCollisionFrameCount(int viewpoint_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  viewpoints_[array_ind].AddCollisionFrame();
+  viewpoints_.AddCollisionFrame(array_ind);
 }
 void ViewPointManager::ResetViewPointCollisionFrameCount(int viewpoint_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  viewpoints_[array_ind].ResetCollisionFrameCount();
+  viewpoints_.ResetCollisionFrameCount(array_ind);
 }
 // Covered point list
 void ViewPointManager::ResetViewPointCoveredPointList(int viewpoint_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  viewpoints_[array_ind].ResetCoveredPointList();
-  viewpoints_[array_ind].ResetCoveredFrontierPointList();
+  viewpoints_.GetCoveredPoints(array_ind).ResetCoveredPointList();
+  viewpoints_.GetCoveredPoints(array_ind).ResetCoveredFrontierPointList();
 }
 void ViewPointManager::AddUncoveredPoint(int viewpoint_ind, int point_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  viewpoints_[array_ind].AddCoveredPoint(point_ind);
+  viewpoints_.GetCoveredPoints(array_ind).AddCoveredPoint(point_ind);
 }
 void ViewPointManager::AddUncoveredFrontierPoint(int viewpoint_ind, int point_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  viewpoints_[array_ind].AddCoveredFrontierPoint(point_ind);
+  viewpoints_.GetCoveredPoints(array_ind).AddCoveredFrontierPoint(point_ind);
 }
 const std::vector<int>& ViewPointManager::GetViewPointCoveredPointList(int viewpoint_ind, bool use_array_ind) const
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  return viewpoints_[array_ind].GetCoveredPointList();
+  return viewpoints_.GetCoveredPoints(array_ind).GetCoveredPointList();
 }
 const std::vector<int>& ViewPointManager::GetViewPointCoveredFrontierPointList(int viewpoint_ind,
                                                                                bool use_array_ind) const
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  return viewpoints_[array_ind].GetCoveredFrontierPointList();
+  return viewpoints_.GetCoveredPoints(array_ind).GetCoveredFrontierPointList();
 }
 
 int ViewPointManager::GetViewPointCoveredPointNum(int viewpoint_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  return viewpoints_[array_ind].GetCoveredPointNum();
+  return viewpoints_.GetCoveredPoints(array_ind).GetCoveredPointNum();
 }
 
 int ViewPointManager::GetViewPointCoveredFrontierPointNum(int viewpoint_ind, bool use_array_ind)
 {
   int array_ind = GetViewPointArrayInd(viewpoint_ind, use_array_ind);
-  return viewpoints_[array_ind].GetCoveredFrontierPointNum();
+  return viewpoints_.GetCoveredPoints(array_ind).GetCoveredFrontierPointNum();
 }
 
 int ViewPointManager::GetViewPointCoveredPointNum(const std::vector<bool>& point_list, int viewpoint_index,
@@ -1235,24 +1541,45 @@ void ViewPointManager::UpdateViewPointCoveredFrontierPoint(std::vector<bool>& fr
   }
 }
 
+int ViewPointManager::GetViewPointCoveredPointNum(const misc_utils_ns::DynamicBitset& covered_point_set,
+                                                  int viewpoint_index, bool use_array_ind)
+{
+  int array_ind = GetViewPointArrayInd(viewpoint_index, use_array_ind);
+  return viewpoints_.GetCoveredPoints(array_ind).GetCoveredPointSet().CountAndNot(covered_point_set);
+}
+int ViewPointManager::GetViewPointCoveredFrontierPointNum(
+    const misc_utils_ns::DynamicBitset& covered_frontier_point_set, int viewpoint_index, bool use_array_ind)
+{
+  int array_ind = GetViewPointArrayInd(viewpoint_index, use_array_ind);
+  return viewpoints_.GetCoveredPoints(array_ind).GetCoveredFrontierPointSet().CountAndNot(covered_frontier_point_set);
+}
+void ViewPointManager::UpdateViewPointCoveredPoint(misc_utils_ns::DynamicBitset& covered_point_set, int viewpoint_index,
+                                                   bool use_array_ind)
+{
+  int array_ind = GetViewPointArrayInd(viewpoint_index, use_array_ind);
+  covered_point_set.Or(viewpoints_.GetCoveredPoints(array_ind).GetCoveredPointSet());
+}
+void ViewPointManager::UpdateViewPointCoveredFrontierPoint(misc_utils_ns::DynamicBitset& covered_frontier_point_set,
+                                                           int viewpoint_index, bool use_array_ind)
+{
+  int array_ind = GetViewPointArrayInd(viewpoint_index, use_array_ind);
+  covered_frontier_point_set.Or(viewpoints_.GetCoveredPoints(array_ind).GetCoveredFrontierPointSet());
+}
+
 int ViewPointManager::GetViewPointCandidate()
 {
-  viewpoint_candidate_cloud_->clear();
   viewpoint_in_collision_cloud_->clear();
   candidate_indices_.clear();
+  // candidate = in line of sight & connected & !in collision, computed a word at a time
+  misc_utils_ns::DynamicBitset& candidate_set = viewpoints_.GetStateSet(viewpoint_ns::ViewPointState::CANDIDATE);
+  candidate_set = viewpoints_.GetStateSet(viewpoint_ns::ViewPointState::IN_LINE_OF_SIGHT);
+  candidate_set.And(viewpoints_.GetStateSet(viewpoint_ns::ViewPointState::CONNECTED));
+  candidate_set.AndNot(viewpoints_.GetStateSet(viewpoint_ns::ViewPointState::IN_COLLISION));
   for (int i = 0; i < vp_.kViewPointNumber; i++)
   {
-    SetViewPointCandidate(i, false);
-    if (!ViewPointInCollision(i) && ViewPointInLineOfSight(i) && ViewPointConnected(i))
+    if (IsViewPointCandidate(i))
     {
-      SetViewPointCandidate(i, true);
       candidate_indices_.push_back(i);
-      geometry_msgs::Point viewpoint_position = GetViewPointPosition(i);
-      pcl::PointXYZI point;
-      point.x = viewpoint_position.x;
-      point.y = viewpoint_position.y;
-      point.z = viewpoint_position.z;
-      viewpoint_candidate_cloud_->points.push_back(point);
     }
     if (ViewPointInCollision(i))
     {
@@ -1266,19 +1593,15 @@ int ViewPointManager::GetViewPointCandidate()
     }
   }
   // std::cout << "candidate viewpoint num: " << candidate_indices_.size() << std::endl;
-  if (!candidate_indices_.empty())
-  {
-    kdtree_viewpoint_candidate_->setInputCloud(viewpoint_candidate_cloud_);
-  }
+
+  // Update the graph of all the candidate viewpoints with the ones whose candidate status changed
+  UpdateCandidateViewPointGraph();
 
   if (!viewpoint_in_collision_cloud_->points.empty())
   {
     kdtree_viewpoint_in_collision_->setInputCloud(viewpoint_in_collision_cloud_);
   }
 
-  // Construct a graph of all the viewpoints
-  GetCandidateViewPointGraph(candidate_viewpoint_graph_, candidate_viewpoint_dist_, candidate_viewpoint_position_);
-
   return candidate_indices_.size();
 }
 
@@ -1300,6 +1623,13 @@ nav_msgs::Path ViewPointManager::GetViewPointShortestPath(int start_viewpoint_in
 
   int start_graph_ind = graph_index_map_[start_viewpoint_ind];
   int target_graph_ind = graph_index_map_[target_viewpoint_ind];
+  if (start_graph_ind < 0 || target_graph_ind < 0)
+  {
+    ROS_WARN_STREAM("ViewPointManager::GetViewPointShortestPath start viewpoint ind: "
+                    << start_viewpoint_ind << " or target viewpoint ind: " << target_viewpoint_ind
+                    << " not a candidate");
+    return path;
+  }
 
   std::vector<int> path_graph_indices;
   double path_length =
@@ -1310,7 +1640,7 @@ nav_msgs::Path ViewPointManager::GetViewPointShortestPath(int start_viewpoint_in
     for (int i = 0; i < path_graph_indices.size(); i++)
     {
       int graph_idx = path_graph_indices[i];
-      int ind = candidate_indices_[graph_idx];
+      int ind = candidate_graph_viewpoint_indices_[graph_idx];
       geometry_msgs::PoseStamped pose;
       pose.pose.position = GetViewPointPosition(ind);
       path.poses.push_back(pose);
@@ -1359,8 +1689,16 @@ bool ViewPointManager::GetViewPointShortestPathWithMaxLength(const Eigen::Vector
   }
   int start_viewpoint_ind = GetNearestCandidateViewPointInd(start_position);
   int target_viewpoint_ind = GetNearestCandidateViewPointInd(target_position);
+  if (!InRange(start_viewpoint_ind) || !InRange(target_viewpoint_ind))
+  {
+    return false;
+  }
   int start_graph_ind = graph_index_map_[start_viewpoint_ind];
   int target_graph_ind = graph_index_map_[target_viewpoint_ind];
+  if (start_graph_ind < 0 || target_graph_ind < 0)
+  {
+    return false;
+  }
 
   std::vector<int> path_graph_indices;
   double shortest_path_dist = 0;
@@ -1373,7 +1711,7 @@ bool ViewPointManager::GetViewPointShortestPathWithMaxLength(const Eigen::Vector
     for (int i = 0; i < path_graph_indices.size(); i++)
     {
       int graph_idx = path_graph_indices[i];
-      int ind = candidate_indices_[graph_idx];
+      int ind = candidate_graph_viewpoint_indices_[graph_idx];
       geometry_msgs::PoseStamped pose;
       pose.pose.position = GetViewPointPosition(ind);
       path.poses.push_back(pose);
@@ -1413,6 +1751,9 @@ void ViewPointManager::GetCandidateViewPointGraph(std::vector<std::vector<int>>&
   graph.clear();
   dist.clear();
   positions.clear();
+  candidate_graph_viewpoint_indices_.clear();
+  candidate_graph_free_nodes_.clear();
+  std::fill(graph_index_map_.begin(), graph_index_map_.end(), -1);
   if (candidate_indices_.empty())
   {
     return;
@@ -1424,6 +1765,7 @@ void ViewPointManager::GetCandidateViewPointGraph(std::vector<std::vector<int>>&
   {
     int ind = candidate_indices_[i];
     graph_index_map_[ind] = i;
+    candidate_graph_viewpoint_indices_.push_back(ind);
   }
 
   // Build the graph
@@ -1444,6 +1786,116 @@ void ViewPointManager::GetCandidateViewPointGraph(std::vector<std::vector<int>>&
   }
 }
 
+bool ViewPointManager::UpdateCandidateViewPointGraph()
+{
+  // Rebuild when more than half of the graph nodes are free slots, otherwise apply the changes only
+  int graph_node_num = candidate_graph_viewpoint_indices_.size();
+  if (candidate_graph_free_nodes_.size() * 2 > graph_node_num || graph_node_num == 0)
+  {
+    GetCandidateViewPointGraph(candidate_viewpoint_graph_, candidate_viewpoint_dist_, candidate_viewpoint_position_);
+    candidate_graph_version_++;
+    return true;
+  }
+
+  std::vector<int> added_viewpoint_indices;
+  bool changed = false;
+  for (int i = 0; i < vp_.kViewPointNumber; i++)
+  {
+    bool in_graph = graph_index_map_[i] >= 0;
+    bool is_candidate = IsViewPointCandidate(i);
+    if (in_graph && !is_candidate)
+    {
+      RemoveCandidateViewPointGraphNode(i);
+      changed = true;
+    }
+    else if (!in_graph && is_candidate)
+    {
+      added_viewpoint_indices.push_back(i);
+    }
+  }
+  for (const auto& ind : added_viewpoint_indices)
+  {
+    AddCandidateViewPointGraphNode(ind);
+    changed = true;
+  }
+
+  // Viewpoint heights follow the terrain, refresh the node positions
+  for (int i = 0; i < candidate_graph_viewpoint_indices_.size(); i++)
+  {
+    int ind = candidate_graph_viewpoint_indices_[i];
+    if (ind >= 0)
+    {
+      candidate_viewpoint_position_[i] = GetViewPointPosition(ind);
+    }
+  }
+
+  if (changed)
+  {
+    candidate_graph_version_++;
+  }
+  return changed;
+}
+
+void ViewPointManager::AddCandidateViewPointGraphNode(int viewpoint_ind)
+{
+  int graph_ind;
+  if (!candidate_graph_free_nodes_.empty())
+  {
+    graph_ind = candidate_graph_free_nodes_.back();
+    candidate_graph_free_nodes_.pop_back();
+  }
+  else
+  {
+    graph_ind = candidate_graph_viewpoint_indices_.size();
+    candidate_graph_viewpoint_indices_.push_back(-1);
+    candidate_viewpoint_graph_.emplace_back();
+    candidate_viewpoint_dist_.emplace_back();
+    candidate_viewpoint_position_.emplace_back();
+  }
+  graph_index_map_[viewpoint_ind] = graph_ind;
+  candidate_graph_viewpoint_indices_[graph_ind] = viewpoint_ind;
+  candidate_viewpoint_position_[graph_ind] = GetViewPointPosition(viewpoint_ind);
+
+  for (int j = 0; j < connected_neighbor_indices_[viewpoint_ind].size(); j++)
+  {
+    int neighbor_graph_ind = graph_index_map_[connected_neighbor_indices_[viewpoint_ind][j]];
+    if (neighbor_graph_ind >= 0)
+    {
+      double neighbor_dist = connected_neighbor_dist_[viewpoint_ind][j];
+      candidate_viewpoint_graph_[graph_ind].push_back(neighbor_graph_ind);
+      candidate_viewpoint_dist_[graph_ind].push_back(neighbor_dist);
+      candidate_viewpoint_graph_[neighbor_graph_ind].push_back(graph_ind);
+      candidate_viewpoint_dist_[neighbor_graph_ind].push_back(neighbor_dist);
+    }
+  }
+}
+
+void ViewPointManager::RemoveCandidateViewPointGraphNode(int viewpoint_ind)
+{
+  int graph_ind = graph_index_map_[viewpoint_ind];
+  for (const auto& neighbor_graph_ind : candidate_viewpoint_graph_[graph_ind])
+  {
+    std::vector<int>& neighbor_edges = candidate_viewpoint_graph_[neighbor_graph_ind];
+    std::vector<double>& neighbor_dist = candidate_viewpoint_dist_[neighbor_graph_ind];
+    for (int j = 0; j < neighbor_edges.size(); j++)
+    {
+      if (neighbor_edges[j] == graph_ind)
+      {
+        neighbor_edges[j] = neighbor_edges.back();
+        neighbor_edges.pop_back();
+        neighbor_dist[j] = neighbor_dist.back();
+        neighbor_dist.pop_back();
+        break;
+      }
+    }
+  }
+  candidate_viewpoint_graph_[graph_ind].clear();
+  candidate_viewpoint_dist_[graph_ind].clear();
+  candidate_graph_viewpoint_indices_[graph_ind] = -1;
+  candidate_graph_free_nodes_.push_back(graph_ind);
+  graph_index_map_[viewpoint_ind] = -1;
+}
+
 int ViewPointManager::GetNearestCandidateViewPointInd(const Eigen::Vector3d& position)
 {
   int viewpoint_ind = GetViewPointInd(position);
@@ -1508,4 +1960,42 @@ bool ViewPointManager::InLocalPlanningHorizon(const Eigen::Vector3d& position)
   return false;
 }
 
+void ViewPointManager::GetMemoryUsage(misc_utils_ns::MemoryReport& report) const
+{
+  const std::string kModule = "viewpoint_manager";
+  report.Add(kModule, "viewpoints", viewpoints_.GetMemoryBytes() + grid_->GetMemoryBytes());
+  report.Add(kModule, "terrain height map", terrain_height_map_->GetMemoryBytes());
+  report.Add(kModule, "covered point lists", viewpoints_.GetCoveredPointMemoryBytes());
+  report.Add(kModule, "neighbor indices",
+             misc_utils_ns::GetNestedVectorBytes(connected_neighbor_indices_) +
+                 misc_utils_ns::GetNestedVectorBytes(connected_neighbor_dist_) +
+                 misc_utils_ns::GetNestedVectorBytes(in_range_neighbor_indices_));
+  report.Add(kModule, "collision lookup",
+             collision_grid_->GetMemoryBytes() + misc_utils_ns::GetVectorBytes(collision_point_count_) +
+                 misc_utils_ns::GetVectorBytes(collision_cell_offsets_) +
+                 misc_utils_ns::GetVectorBytes(collision_viewpoint_indices_));
+  report.Add(kModule, "connectivity",
+             misc_utils_ns::GetVectorBytes(connectivity_label_) +
+                 misc_utils_ns::GetVectorBytes(connectivity_label_parent_) + connectivity_traversable_.capacity() / 8 +
+                 misc_utils_ns::GetVectorBytes(connectivity_height_) +
+                 misc_utils_ns::GetVectorBytes(connectivity_dirty_array_indices_));
+  uint64_t ray_template_bytes = misc_utils_ns::GetHashTableBytes(line_of_sight_ray_templates_);
+  for (const auto& ray_template : line_of_sight_ray_templates_)
+  {
+    ray_template_bytes += misc_utils_ns::GetVectorBytes(ray_template.second);
+  }
+  report.Add(kModule, "line of sight ray templates", ray_template_bytes);
+  report.Add(kModule, "candidate graph",
+             misc_utils_ns::GetNestedVectorBytes(candidate_viewpoint_graph_) +
+                 misc_utils_ns::GetNestedVectorBytes(candidate_viewpoint_dist_) +
+                 misc_utils_ns::GetVectorBytes(candidate_viewpoint_position_) +
+                 misc_utils_ns::GetVectorBytes(graph_index_map_) +
+                 misc_utils_ns::GetVectorBytes(candidate_graph_viewpoint_indices_) +
+                 misc_utils_ns::GetVectorBytes(candidate_graph_free_nodes_) +
+                 misc_utils_ns::GetVectorBytes(candidate_indices_));
+  report.Add(kModule, "kdtrees and clouds",
+             misc_utils_ns::GetKdTreeBytes(kdtree_viewpoint_in_collision_) +
+                 misc_utils_ns::GetCloudPtrBytes(viewpoint_in_collision_cloud_));
+}
+
 }  // namespace viewpoint_manager_ns
\ No newline at end of file
@@ -0,0 +1,1287 @@
+/**
+ * @file world_generator.cpp
+ * @author Chao Cao (ccao1@andrew.cmu.edu)
+ * @brief Procedural synthetic worlds and a simulated robot that feeds the planner with scans, terrain maps and
+ * odometry
+ * @version 0.1
+ * @date 2021-06-16
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "world_generator/world_generator.h"
+#include <pcl/io/pcd_io.h>
+#include <ros/callback_queue.h>
+
+namespace world_generator_ns
+{
+bool WorldGeneratorParameters::ReadParameters(ros::NodeHandle& nh)
+{
+  kWorldType = misc_utils_ns::getParam<std::string>(nh, "kWorldType", "rooms");
+  kWorldSize = misc_utils_ns::getParam<double>(nh, "kWorldSize", 60.0);
+  kClutterDensity = misc_utils_ns::getParam<double>(nh, "kClutterDensity", 0.5);
+  kSeed = misc_utils_ns::getParam<int>(nh, "kSeed", 0);
+  kCellSize = misc_utils_ns::getParam<double>(nh, "kCellSize", 6.0);
+  kWallHeight = misc_utils_ns::getParam<double>(nh, "kWallHeight", 3.0);
+  kWallThickness = misc_utils_ns::getParam<double>(nh, "kWallThickness", 0.2);
+  kLoopRatio = misc_utils_ns::getParam<double>(nh, "kLoopRatio", 0.1);
+  kTunnelFillRatio = misc_utils_ns::getParam<double>(nh, "kTunnelFillRatio", 0.5);
+  kLevelNum = misc_utils_ns::getParam<int>(nh, "kLevelNum", 2);
+  kLevelHeight = misc_utils_ns::getParam<double>(nh, "kLevelHeight", 3.0);
+  kClutterDensity = std::min(std::max(kClutterDensity, 0.0), 1.0);
+  kLevelNum = std::max(kLevelNum, 1);
+  return true;
+}
+
+SyntheticWorld::SyntheticWorld(double index_cell_size)
+  : index_cell_size_(index_cell_size), index_origin_(0.0, 0.0), index_size_(0, 0)
+{
+}
+
+void SyntheticWorld::Clear()
+{
+  boxes_.clear();
+  cylinders_.clear();
+  index_cells_.clear();
+  index_size_ = Eigen::Vector2i(0, 0);
+}
+
+void SyntheticWorld::AddBox(const Eigen::Vector3d& min, const Eigen::Vector3d& max)
+{
+  Box box;
+  box.min = min.cwiseMin(max);
+  box.max = min.cwiseMax(max);
+  boxes_.push_back(box);
+}
+
+void SyntheticWorld::AddCylinder(const Eigen::Vector2d& center, double radius, double z_min, double z_max)
+{
+  Cylinder cylinder;
+  cylinder.center = center;
+  cylinder.radius = radius;
+  cylinder.z_min = std::min(z_min, z_max);
+  cylinder.z_max = std::max(z_min, z_max);
+  cylinders_.push_back(cylinder);
+}
+
+void SyntheticWorld::BuildIndex()
+{
+  index_cells_.clear();
+  if (boxes_.empty() && cylinders_.empty())
+  {
+    index_size_ = Eigen::Vector2i(0, 0);
+    return;
+  }
+  std::vector<Eigen::Vector2d> primitive_min;
+  std::vector<Eigen::Vector2d> primitive_max;
+  for (const auto& box : boxes_)
+  {
+    primitive_min.push_back(box.min.head<2>());
+    primitive_max.push_back(box.max.head<2>());
+  }
+  for (const auto& cylinder : cylinders_)
+  {
+    primitive_min.push_back(cylinder.center.array() - cylinder.radius);
+    primitive_max.push_back(cylinder.center.array() + cylinder.radius);
+  }
+  Eigen::Vector2d world_min = primitive_min[0];
+  Eigen::Vector2d world_max = primitive_max[0];
+  for (int i = 0; i < primitive_min.size(); i++)
+  {
+    world_min = world_min.cwiseMin(primitive_min[i]);
+    world_max = world_max.cwiseMax(primitive_max[i]);
+  }
+  index_origin_ = world_min.array() - index_cell_size_;
+  index_size_.x() = static_cast<int>(std::ceil((world_max.x() - index_origin_.x()) / index_cell_size_)) + 1;
+  index_size_.y() = static_cast<int>(std::ceil((world_max.y() - index_origin_.y()) / index_cell_size_)) + 1;
+  index_cells_.resize(index_size_.x() * index_size_.y());
+  for (int i = 0; i < primitive_min.size(); i++)
+  {
+    int min_x_sub = static_cast<int>(std::floor((primitive_min[i].x() - index_origin_.x()) / index_cell_size_));
+    int min_y_sub = static_cast<int>(std::floor((primitive_min[i].y() - index_origin_.y()) / index_cell_size_));
+    int max_x_sub = static_cast<int>(std::floor((primitive_max[i].x() - index_origin_.x()) / index_cell_size_));
+    int max_y_sub = static_cast<int>(std::floor((primitive_max[i].y() - index_origin_.y()) / index_cell_size_));
+    for (int x = min_x_sub; x <= max_x_sub; x++)
+    {
+      for (int y = min_y_sub; y <= max_y_sub; y++)
+      {
+        index_cells_[x + y * index_size_.x()].push_back(i);
+      }
+    }
+  }
+}
+
+bool SyntheticWorld::GetIndexCellSub(double x, double y, int& x_sub, int& y_sub) const
+{
+  x_sub = static_cast<int>(std::floor((x - index_origin_.x()) / index_cell_size_));
+  y_sub = static_cast<int>(std::floor((y - index_origin_.y()) / index_cell_size_));
+  return x_sub >= 0 && x_sub < index_size_.x() && y_sub >= 0 && y_sub < index_size_.y();
+}
+
+bool SyntheticWorld::IntersectPrimitive(int primitive_ind, const Eigen::Vector3d& origin,
+                                        const Eigen::Vector3d& direction, double& hit_dist) const
+{
+  const double kEpsilon = 1e-12;
+  double t_min = -DBL_MAX;
+  double t_max = DBL_MAX;
+  // Slabs along the axes, z only for cylinders
+  Eigen::Vector3d slab_min;
+  Eigen::Vector3d slab_max;
+  int slab_begin = 0;
+  if (primitive_ind < boxes_.size())
+  {
+    slab_min = boxes_[primitive_ind].min;
+    slab_max = boxes_[primitive_ind].max;
+  }
+  else
+  {
+    const Cylinder& cylinder = cylinders_[primitive_ind - boxes_.size()];
+    slab_min.z() = cylinder.z_min;
+    slab_max.z() = cylinder.z_max;
+    slab_begin = 2;
+    double dx = origin.x() - cylinder.center.x();
+    double dy = origin.y() - cylinder.center.y();
+    double a = direction.x() * direction.x() + direction.y() * direction.y();
+    double c = dx * dx + dy * dy - cylinder.radius * cylinder.radius;
+    if (a < kEpsilon)
+    {
+      if (c > 0)
+      {
+        return false;
+      }
+    }
+    else
+    {
+      double b = dx * direction.x() + dy * direction.y();
+      double discriminant = b * b - a * c;
+      if (discriminant < 0)
+      {
+        return false;
+      }
+      double sqrt_discriminant = std::sqrt(discriminant);
+      t_min = (-b - sqrt_discriminant) / a;
+      t_max = (-b + sqrt_discriminant) / a;
+    }
+  }
+  for (int k = slab_begin; k < 3; k++)
+  {
+    if (std::abs(direction(k)) < kEpsilon)
+    {
+      if (origin(k) < slab_min(k) || origin(k) > slab_max(k))
+      {
+        return false;
+      }
+      continue;
+    }
+    double t1 = (slab_min(k) - origin(k)) / direction(k);
+    double t2 = (slab_max(k) - origin(k)) / direction(k);
+    if (t1 > t2)
+    {
+      std::swap(t1, t2);
+    }
+    t_min = std::max(t_min, t1);
+    t_max = std::min(t_max, t2);
+    if (t_min > t_max)
+    {
+      return false;
+    }
+  }
+  if (t_max < 0)
+  {
+    return false;
+  }
+  hit_dist = std::max(t_min, 0.0);
+  return true;
+}
+
+bool SyntheticWorld::RayCastBruteForce(const Eigen::Vector3d& origin, const Eigen::Vector3d& direction,
+                                       double max_range, double& hit_dist) const
+{
+  bool hit = false;
+  hit_dist = max_range;
+  int primitive_num = boxes_.size() + cylinders_.size();
+  for (int i = 0; i < primitive_num; i++)
+  {
+    double dist;
+    if (IntersectPrimitive(i, origin, direction, dist) && dist < hit_dist)
+    {
+      hit_dist = dist;
+      hit = true;
+    }
+  }
+  return hit;
+}
+
+bool SyntheticWorld::RayCast(const Eigen::Vector3d& origin, const Eigen::Vector3d& direction, double max_range,
+                             double& hit_dist) const
+{
+  int x_sub, y_sub;
+  if (!GetIndexCellSub(origin.x(), origin.y(), x_sub, y_sub))
+  {
+    return RayCastBruteForce(origin, direction, max_range, hit_dist);
+  }
+  // 2D DDA through the index cells, the ray parameter is the 3D distance
+  int step_x = direction.x() > 0 ? 1 : -1;
+  int step_y = direction.y() > 0 ? 1 : -1;
+  double t_max_x = DBL_MAX;
+  double t_max_y = DBL_MAX;
+  double t_delta_x = DBL_MAX;
+  double t_delta_y = DBL_MAX;
+  if (direction.x() != 0)
+  {
+    double boundary_x = index_origin_.x() + (x_sub + (step_x > 0 ? 1 : 0)) * index_cell_size_;
+    t_max_x = (boundary_x - origin.x()) / direction.x();
+    t_delta_x = index_cell_size_ / std::abs(direction.x());
+  }
+  if (direction.y() != 0)
+  {
+    double boundary_y = index_origin_.y() + (y_sub + (step_y > 0 ? 1 : 0)) * index_cell_size_;
+    t_max_y = (boundary_y - origin.y()) / direction.y();
+    t_delta_y = index_cell_size_ / std::abs(direction.y());
+  }
+
+  bool hit = false;
+  hit_dist = max_range;
+  while (true)
+  {
+    for (const auto& primitive_ind : index_cells_[x_sub + y_sub * index_size_.x()])
+    {
+      double dist;
+      if (IntersectPrimitive(primitive_ind, origin, direction, dist) && dist < hit_dist)
+      {
+        hit_dist = dist;
+        hit = true;
+      }
+    }
+    double t_exit = std::min(t_max_x, t_max_y);
+    if (hit_dist <= t_exit || t_exit > max_range)
+    {
+      break;
+    }
+    if (t_max_x < t_max_y)
+    {
+      x_sub += step_x;
+      t_max_x += t_delta_x;
+    }
+    else
+    {
+      y_sub += step_y;
+      t_max_y += t_delta_y;
+    }
+    if (x_sub < 0 || x_sub >= index_size_.x() || y_sub < 0 || y_sub >= index_size_.y())
+    {
+      break;
+    }
+  }
+  return hit;
+}
+
+bool SyntheticWorld::InCollision(const Eigen::Vector3d& position, double radius) const
+{
+  int min_x_sub, min_y_sub, max_x_sub, max_y_sub;
+  GetIndexCellSub(position.x() - radius, position.y() - radius, min_x_sub, min_y_sub);
+  GetIndexCellSub(position.x() + radius, position.y() + radius, max_x_sub, max_y_sub);
+  min_x_sub = std::max(min_x_sub, 0);
+  min_y_sub = std::max(min_y_sub, 0);
+  max_x_sub = std::min(max_x_sub, index_size_.x() - 1);
+  max_y_sub = std::min(max_y_sub, index_size_.y() - 1);
+  double radius_sq = radius * radius;
+  for (int x = min_x_sub; x <= max_x_sub; x++)
+  {
+    for (int y = min_y_sub; y <= max_y_sub; y++)
+    {
+      for (const auto& primitive_ind : index_cells_[x + y * index_size_.x()])
+      {
+        double dist_sq = 0;
+        if (primitive_ind < boxes_.size())
+        {
+          const Box& box = boxes_[primitive_ind];
+          Eigen::Vector3d closest_point = position.cwiseMax(box.min).cwiseMin(box.max);
+          dist_sq = (closest_point - position).squaredNorm();
+        }
+        else
+        {
+          const Cylinder& cylinder = cylinders_[primitive_ind - boxes_.size()];
+          double horizontal_dist =
+              std::max((position.head<2>() - cylinder.center).norm() - cylinder.radius, 0.0);
+          double vertical_dist = std::max(std::max(cylinder.z_min - position.z(), position.z() - cylinder.z_max), 0.0);
+          dist_sq = horizontal_dist * horizontal_dist + vertical_dist * vertical_dist;
+        }
+        if (dist_sq < radius_sq)
+        {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+bool SyntheticWorld::GetGroundHeight(const Eigen::Vector3d& position, double& ground_height) const
+{
+  double hit_dist;
+  if (!RayCast(position, Eigen::Vector3d(0, 0, -1), 100.0, hit_dist))
+  {
+    return false;
+  }
+  ground_height = position.z() - hit_dist;
+  return true;
+}
+
+void SyntheticWorld::GetPointCloud(pcl::PointCloud<pcl::PointXYZI>::Ptr& cloud, double resolution) const
+{
+  cloud->clear();
+  pcl::PointXYZI point;
+  for (const auto& box : boxes_)
+  {
+    Eigen::Vector3d size = box.max - box.min;
+    for (int k = 0; k < 3; k++)
+    {
+      int u = (k + 1) % 3;
+      int v = (k + 2) % 3;
+      int u_num = std::max(static_cast<int>(std::ceil(size(u) / resolution)), 1);
+      int v_num = std::max(static_cast<int>(std::ceil(size(v) / resolution)), 1);
+      for (int side = 0; side < 2; side++)
+      {
+        Eigen::Vector3d p;
+        p(k) = side == 0 ? box.min(k) : box.max(k);
+        for (int i = 0; i <= u_num; i++)
+        {
+          p(u) = box.min(u) + size(u) * i / u_num;
+          for (int j = 0; j <= v_num; j++)
+          {
+            p(v) = box.min(v) + size(v) * j / v_num;
+            point.x = p.x();
+            point.y = p.y();
+            point.z = p.z();
+            point.intensity = p.z();
+            cloud->points.push_back(point);
+          }
+        }
+      }
+    }
+  }
+  for (const auto& cylinder : cylinders_)
+  {
+    int angle_num = std::max(static_cast<int>(std::ceil(2 * M_PI * cylinder.radius / resolution)), 6);
+    int z_num = std::max(static_cast<int>(std::ceil((cylinder.z_max - cylinder.z_min) / resolution)), 1);
+    for (int i = 0; i < angle_num; i++)
+    {
+      double angle = 2 * M_PI * i / angle_num;
+      for (int j = 0; j <= z_num; j++)
+      {
+        point.x = cylinder.center.x() + cylinder.radius * cos(angle);
+        point.y = cylinder.center.y() + cylinder.radius * sin(angle);
+        point.z = cylinder.z_min + (cylinder.z_max - cylinder.z_min) * j / z_num;
+        point.intensity = point.z;
+        cloud->points.push_back(point);
+      }
+    }
+  }
+  cloud->width = cloud->points.size();
+  cloud->height = 1;
+}
+
+WorldGenerator::WorldGenerator(const WorldGeneratorParameters& wp) : wp_(wp), rng_(wp.kSeed)
+{
+}
+
+bool WorldGenerator::GetWorldType(const std::string& world_type_str, WorldType& world_type)
+{
+  if (world_type_str == "corridor")
+  {
+    world_type = WorldType::CORRIDOR;
+  }
+  else if (world_type_str == "rooms")
+  {
+    world_type = WorldType::ROOMS;
+  }
+  else if (world_type_str == "forest")
+  {
+    world_type = WorldType::FOREST;
+  }
+  else if (world_type_str == "garage")
+  {
+    world_type = WorldType::GARAGE;
+  }
+  else if (world_type_str == "tunnel")
+  {
+    world_type = WorldType::TUNNEL;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+bool WorldGenerator::Generate(SyntheticWorld& world, Eigen::Vector3d& start_position)
+{
+  WorldType world_type;
+  if (!GetWorldType(wp_.kWorldType, world_type))
+  {
+    ROS_ERROR_STREAM("WorldGenerator: unknown world type " << wp_.kWorldType
+                                                           << ", use corridor, rooms, forest, garage or tunnel");
+    return false;
+  }
+  rng_.seed(wp_.kSeed);
+  world.Clear();
+  // All the worlds are laid out so that the robot starts at the origin
+  start_position = Eigen::Vector3d(0, 0, 0);
+  switch (world_type)
+  {
+    case WorldType::CORRIDOR:
+      GenerateCorridor(world);
+      break;
+    case WorldType::ROOMS:
+      GenerateRooms(world);
+      break;
+    case WorldType::FOREST:
+      GenerateForest(world);
+      break;
+    case WorldType::GARAGE:
+      GenerateGarage(world);
+      break;
+    case WorldType::TUNNEL:
+      GenerateTunnel(world);
+      break;
+  }
+  world.BuildIndex();
+  return true;
+}
+
+void WorldGenerator::GenerateMaze(int cell_num, double fill_ratio, double loop_ratio, std::vector<MazeCell>& maze)
+{
+  maze.assign(cell_num * cell_num, MazeCell());
+  int target_open_num = std::max(static_cast<int>(fill_ratio * cell_num * cell_num), 1);
+  // Randomized Prim, grown from the center cell where the robot starts
+  std::vector<std::pair<int, int>> edges;
+  auto open_cell = [&](int ind) {
+    maze[ind].open = true;
+    int x = ind % cell_num;
+    int y = ind / cell_num;
+    if (x > 0)
+      edges.emplace_back(ind, ind - 1);
+    if (x < cell_num - 1)
+      edges.emplace_back(ind, ind + 1);
+    if (y > 0)
+      edges.emplace_back(ind, ind - cell_num);
+    if (y < cell_num - 1)
+      edges.emplace_back(ind, ind + cell_num);
+  };
+  auto set_passage = [&](int ind1, int ind2) {
+    int from_ind = std::min(ind1, ind2);
+    int to_ind = std::max(ind1, ind2);
+    if (to_ind - from_ind == 1)
+    {
+      maze[from_ind].passage_x = true;
+    }
+    else
+    {
+      maze[from_ind].passage_y = true;
+    }
+  };
+  int center = cell_num / 2;
+  open_cell(center + center * cell_num);
+  int open_num = 1;
+  while (!edges.empty() && open_num < target_open_num)
+  {
+    int edge_ind = std::uniform_int_distribution<int>(0, edges.size() - 1)(rng_);
+    std::pair<int, int> edge = edges[edge_ind];
+    edges[edge_ind] = edges.back();
+    edges.pop_back();
+    if (maze[edge.second].open)
+    {
+      continue;
+    }
+    set_passage(edge.first, edge.second);
+    open_cell(edge.second);
+    open_num++;
+  }
+  // Extra openings between open cells
+  for (int ind = 0; ind < maze.size(); ind++)
+  {
+    if (!maze[ind].open)
+    {
+      continue;
+    }
+    int x = ind % cell_num;
+    int y = ind / cell_num;
+    if (x < cell_num - 1 && maze[ind + 1].open && !maze[ind].passage_x && Uniform(0, 1) < loop_ratio)
+    {
+      maze[ind].passage_x = true;
+    }
+    if (y < cell_num - 1 && maze[ind + cell_num].open && !maze[ind].passage_y && Uniform(0, 1) < loop_ratio)
+    {
+      maze[ind].passage_y = true;
+    }
+  }
+}
+
+void WorldGenerator::AddMazeWalls(SyntheticWorld& world, int cell_num, const std::vector<MazeCell>& maze,
+                                  double door_width)
+{
+  double origin = -cell_num * wp_.kCellSize / 2;
+  double half_thickness = wp_.kWallThickness / 2;
+  // Wall along axis (1 - normal_axis) at the boundary position, split by a door if the cells are connected
+  auto add_wall = [&](int normal_axis, double boundary, double begin, double end, bool passage) {
+    std::vector<std::pair<double, double>> segments;
+    if (!passage)
+    {
+      segments.emplace_back(begin, end);
+    }
+    else if (door_width > 0 && door_width < end - begin)
+    {
+      double mid = (begin + end) / 2;
+      segments.emplace_back(begin, mid - door_width / 2);
+      segments.emplace_back(mid + door_width / 2, end);
+    }
+    for (const auto& segment : segments)
+    {
+      Eigen::Vector3d min(0, 0, 0);
+      Eigen::Vector3d max(0, 0, wp_.kWallHeight);
+      min(normal_axis) = boundary - half_thickness;
+      max(normal_axis) = boundary + half_thickness;
+      min(1 - normal_axis) = segment.first - half_thickness;
+      max(1 - normal_axis) = segment.second + half_thickness;
+      world.AddBox(min, max);
+    }
+  };
+  for (int i = 0; i <= cell_num; i++)
+  {
+    double boundary = origin + i * wp_.kCellSize;
+    for (int j = 0; j < cell_num; j++)
+    {
+      double begin = origin + j * wp_.kCellSize;
+      double end = begin + wp_.kCellSize;
+      // Boundary between cells (i - 1, j) and (i, j)
+      bool open_before = i > 0 && maze[(i - 1) + j * cell_num].open;
+      bool open_after = i < cell_num && maze[i + j * cell_num].open;
+      if (open_before || open_after)
+      {
+        bool passage = open_before && open_after && maze[(i - 1) + j * cell_num].passage_x;
+        add_wall(0, boundary, begin, end, passage);
+      }
+      // Boundary between cells (j, i - 1) and (j, i)
+      open_before = i > 0 && maze[j + (i - 1) * cell_num].open;
+      open_after = i < cell_num && maze[j + i * cell_num].open;
+      if (open_before || open_after)
+      {
+        bool passage = open_before && open_after && maze[j + (i - 1) * cell_num].passage_y;
+        add_wall(1, boundary, begin, end, passage);
+      }
+    }
+  }
+}
+
+void WorldGenerator::AddGround(SyntheticWorld& world, double z)
+{
+  double half_size = wp_.kWorldSize / 2 + wp_.kCellSize;
+  world.AddBox(Eigen::Vector3d(-half_size, -half_size, z - 0.2), Eigen::Vector3d(half_size, half_size, z));
+}
+
+void WorldGenerator::AddBoundaryWalls(SyntheticWorld& world, double z_min, double z_max)
+{
+  double half_size = wp_.kWorldSize / 2;
+  double t = wp_.kWallThickness;
+  world.AddBox(Eigen::Vector3d(-half_size - t, -half_size - t, z_min),
+               Eigen::Vector3d(-half_size, half_size + t, z_max));
+  world.AddBox(Eigen::Vector3d(half_size, -half_size - t, z_min), Eigen::Vector3d(half_size + t, half_size + t, z_max));
+  world.AddBox(Eigen::Vector3d(-half_size, -half_size - t, z_min), Eigen::Vector3d(half_size, -half_size, z_max));
+  world.AddBox(Eigen::Vector3d(-half_size, half_size, z_min), Eigen::Vector3d(half_size, half_size + t, z_max));
+}
+
+void WorldGenerator::GenerateCorridor(SyntheticWorld& world)
+{
+  int cell_num = std::max(static_cast<int>(wp_.kWorldSize / wp_.kCellSize), 1);
+  // Odd number of cells so that the robot starts at the center of a cell
+  if (cell_num % 2 == 0)
+  {
+    cell_num++;
+  }
+  std::vector<MazeCell> maze;
+  GenerateMaze(cell_num, 1.0, wp_.kLoopRatio, maze);
+  AddGround(world, 0.0);
+  AddMazeWalls(world, cell_num, maze, 0.0);
+
+  // Boxes along the walls
+  double origin = -cell_num * wp_.kCellSize / 2;
+  int center_ind = cell_num / 2 + cell_num / 2 * cell_num;
+  for (int ind = 0; ind < maze.size(); ind++)
+  {
+    if (ind == center_ind || Uniform(0, 1) > wp_.kClutterDensity)
+    {
+      continue;
+    }
+    Eigen::Vector2d cell_center(origin + (ind % cell_num + 0.5) * wp_.kCellSize,
+                                origin + (ind / cell_num + 0.5) * wp_.kCellSize);
+    double size = Uniform(0.3, 0.8);
+    double height = Uniform(0.4, 1.2);
+    int axis = Uniform(0, 1) < 0.5 ? 0 : 1;
+    double side = Uniform(0, 1) < 0.5 ? -1 : 1;
+    Eigen::Vector2d center = cell_center;
+    center(axis) += side * (wp_.kCellSize / 2 - wp_.kWallThickness - size / 2);
+    center(1 - axis) += Uniform(-1, 1) * (wp_.kCellSize / 2 - size);
+    world.AddBox(Eigen::Vector3d(center.x() - size / 2, center.y() - size / 2, 0),
+                 Eigen::Vector3d(center.x() + size / 2, center.y() + size / 2, height));
+  }
+}
+
+void WorldGenerator::GenerateRooms(SyntheticWorld& world)
+{
+  int cell_num = std::max(static_cast<int>(wp_.kWorldSize / wp_.kCellSize), 1);
+  if (cell_num % 2 == 0)
+  {
+    cell_num++;
+  }
+  std::vector<MazeCell> maze;
+  GenerateMaze(cell_num, 1.0, std::max(wp_.kLoopRatio, 0.3), maze);
+  AddGround(world, 0.0);
+  AddMazeWalls(world, cell_num, maze, 1.2);
+
+  // Furniture in the quadrants of each room, leaving the cross between the doors free
+  double origin = -cell_num * wp_.kCellSize / 2;
+  double free_half_width = 1.0;
+  int furniture_num = static_cast<int>(std::round(wp_.kClutterDensity * 4));
+  for (int ind = 0; ind < maze.size(); ind++)
+  {
+    Eigen::Vector2d room_center(origin + (ind % cell_num + 0.5) * wp_.kCellSize,
+                                origin + (ind / cell_num + 0.5) * wp_.kCellSize);
+    for (int i = 0; i < furniture_num; i++)
+    {
+      Eigen::Vector2d size(Uniform(0.5, 1.5), Uniform(0.5, 1.5));
+      double height = Uniform(0.4, 1.2);
+      Eigen::Vector2d center;
+      bool valid = true;
+      for (int k = 0; k < 2; k++)
+      {
+        double offset_min = free_half_width + size(k) / 2;
+        double offset_max = wp_.kCellSize / 2 - wp_.kWallThickness - size(k) / 2;
+        if (offset_min >= offset_max)
+        {
+          valid = false;
+          break;
+        }
+        double side = Uniform(0, 1) < 0.5 ? -1 : 1;
+        center(k) = room_center(k) + side * Uniform(offset_min, offset_max);
+      }
+      if (!valid)
+      {
+        continue;
+      }
+      world.AddBox(Eigen::Vector3d(center.x() - size.x() / 2, center.y() - size.y() / 2, 0),
+                   Eigen::Vector3d(center.x() + size.x() / 2, center.y() + size.y() / 2, height));
+    }
+  }
+}
+
+void WorldGenerator::GenerateForest(SyntheticWorld& world)
+{
+  double half_size = wp_.kWorldSize / 2;
+  AddGround(world, 0.0);
+  AddBoundaryWalls(world, 0.0, wp_.kWallHeight);
+  double area = wp_.kWorldSize * wp_.kWorldSize;
+  int tree_num = static_cast<int>(wp_.kClutterDensity * area / 10);
+  for (int i = 0; i < tree_num; i++)
+  {
+    Eigen::Vector2d center(Uniform(-half_size + 1, half_size - 1), Uniform(-half_size + 1, half_size - 1));
+    if (center.norm() < 3.0)
+    {
+      continue;
+    }
+    world.AddCylinder(center, Uniform(0.15, 0.45), 0.0, Uniform(4.0, 12.0));
+  }
+  int rock_num = static_cast<int>(wp_.kClutterDensity * area / 100);
+  for (int i = 0; i < rock_num; i++)
+  {
+    Eigen::Vector2d center(Uniform(-half_size + 1, half_size - 1), Uniform(-half_size + 1, half_size - 1));
+    if (center.norm() < 3.0)
+    {
+      continue;
+    }
+    double size = Uniform(0.3, 1.0);
+    world.AddBox(Eigen::Vector3d(center.x() - size / 2, center.y() - size / 2, 0),
+                 Eigen::Vector3d(center.x() + size / 2, center.y() + size / 2, Uniform(0.2, 0.6)));
+  }
+}
+
+void WorldGenerator::GenerateGarage(SyntheticWorld& world)
+{
+  double half_size = wp_.kWorldSize / 2;
+  double level_height = wp_.kLevelHeight;
+  double ramp_width = 4.0;
+  double ramp_length = std::min(wp_.kWorldSize - 8.0, 20.0);
+  double step_rise = 0.1;
+  int step_num = static_cast<int>(std::ceil(level_height / step_rise));
+
+  // Footprint of the ramp from level k to level k + 1, alternating between the two sides of the garage
+  auto get_ramp_footprint = [&](int level, Eigen::Vector2d& min, Eigen::Vector2d& max) {
+    if (level % 2 == 0)
+    {
+      min = Eigen::Vector2d(-half_size + 2, half_size - 2 - ramp_width);
+      max = Eigen::Vector2d(-half_size + 2 + ramp_length, half_size - 2);
+    }
+    else
+    {
+      min = Eigen::Vector2d(half_size - 2 - ramp_length, -half_size + 2);
+      max = Eigen::Vector2d(half_size - 2, -half_size + 2 + ramp_width);
+    }
+  };
+  auto overlap = [](const Eigen::Vector2d& min1, const Eigen::Vector2d& max1, const Eigen::Vector2d& min2,
+                    const Eigen::Vector2d& max2) {
+    return min1.x() < max2.x() && max1.x() > min2.x() && min1.y() < max2.y() && max1.y() > min2.y();
+  };
+
+  AddBoundaryWalls(world, -0.2, wp_.kLevelNum * level_height);
+  for (int level = 0; level < wp_.kLevelNum; level++)
+  {
+    double floor_z = level * level_height;
+    // Floor, with a hole above the ramp from the level below
+    if (level == 0)
+    {
+      AddGround(world, 0.0);
+    }
+    else
+    {
+      Eigen::Vector2d hole_min, hole_max;
+      get_ramp_footprint(level - 1, hole_min, hole_max);
+      double z_min = floor_z - 0.2;
+      world.AddBox(Eigen::Vector3d(-half_size, -half_size, z_min), Eigen::Vector3d(hole_min.x(), half_size, floor_z));
+      world.AddBox(Eigen::Vector3d(hole_max.x(), -half_size, z_min), Eigen::Vector3d(half_size, half_size, floor_z));
+      world.AddBox(Eigen::Vector3d(hole_min.x(), -half_size, z_min),
+                   Eigen::Vector3d(hole_max.x(), hole_min.y(), floor_z));
+      world.AddBox(Eigen::Vector3d(hole_min.x(), hole_max.y(), z_min),
+                   Eigen::Vector3d(hole_max.x(), half_size, floor_z));
+    }
+
+    std::vector<std::pair<Eigen::Vector2d, Eigen::Vector2d>> occupied;
+    Eigen::Vector2d ramp_min, ramp_max;
+    bool has_ramp = level < wp_.kLevelNum - 1;
+    if (has_ramp)
+    {
+      get_ramp_footprint(level, ramp_min, ramp_max);
+      for (int i = 0; i < step_num; i++)
+      {
+        double step_length = ramp_length / step_num;
+        double step_top = floor_z + std::min((i + 1) * step_rise, level_height);
+        // Even levels go up along +x, odd levels along -x
+        double x_begin = level % 2 == 0 ? ramp_min.x() + i * step_length : ramp_max.x() - (i + 1) * step_length;
+        world.AddBox(Eigen::Vector3d(x_begin, ramp_min.y(), floor_z),
+                     Eigen::Vector3d(x_begin + step_length, ramp_max.y(), step_top));
+      }
+      occupied.emplace_back(ramp_min.array() - 1.0, ramp_max.array() + 1.0);
+    }
+    if (level > 0)
+    {
+      Eigen::Vector2d hole_min, hole_max;
+      get_ramp_footprint(level - 1, hole_min, hole_max);
+      occupied.emplace_back(hole_min.array() - 1.0, hole_max.array() + 1.0);
+    }
+    if (level == 0)
+    {
+      occupied.emplace_back(Eigen::Vector2d(-3, -3), Eigen::Vector2d(3, 3));
+    }
+
+    // Pillars on a regular grid
+    double pillar_spacing = 8.0;
+    double pillar_half_size = 0.3;
+    for (double x = -half_size + pillar_spacing; x < half_size - 1; x += pillar_spacing)
+    {
+      for (double y = -half_size + pillar_spacing; y < half_size - 1; y += pillar_spacing)
+      {
+        Eigen::Vector2d pillar_min(x - pillar_half_size, y - pillar_half_size);
+        Eigen::Vector2d pillar_max(x + pillar_half_size, y + pillar_half_size);
+        bool free = true;
+        for (const auto& rect : occupied)
+        {
+          if (overlap(pillar_min, pillar_max, rect.first, rect.second))
+          {
+            free = false;
+            break;
+          }
+        }
+        if (!free)
+        {
+          continue;
+        }
+        world.AddBox(Eigen::Vector3d(pillar_min.x(), pillar_min.y(), floor_z),
+                     Eigen::Vector3d(pillar_max.x(), pillar_max.y(), floor_z + level_height - 0.2));
+        occupied.emplace_back(pillar_min, pillar_max);
+      }
+    }
+
+    // Parked cars, rejected when they would block the lanes
+    int car_num = static_cast<int>(wp_.kClutterDensity * wp_.kWorldSize * wp_.kWorldSize / 40);
+    for (int i = 0; i < car_num; i++)
+    {
+      Eigen::Vector2d car_size = Uniform(0, 1) < 0.5 ? Eigen::Vector2d(4.5, 1.8) : Eigen::Vector2d(1.8, 4.5);
+      Eigen::Vector2d center(Uniform(-half_size + 3, half_size - 3), Uniform(-half_size + 3, half_size - 3));
+      Eigen::Vector2d car_min = center - car_size / 2;
+      Eigen::Vector2d car_max = center + car_size / 2;
+      bool free = true;
+      for (const auto& rect : occupied)
+      {
+        if (overlap(car_min.array() - 1.0, car_max.array() + 1.0, rect.first, rect.second))
+        {
+          free = false;
+          break;
+        }
+      }
+      if (!free)
+      {
+        continue;
+      }
+      world.AddBox(Eigen::Vector3d(car_min.x(), car_min.y(), floor_z),
+                   Eigen::Vector3d(car_max.x(), car_max.y(), floor_z + 1.5));
+      occupied.emplace_back(car_min, car_max);
+    }
+  }
+}
+
+void WorldGenerator::GenerateTunnel(SyntheticWorld& world)
+{
+  int cell_num = std::max(static_cast<int>(wp_.kWorldSize / wp_.kCellSize), 1);
+  if (cell_num % 2 == 0)
+  {
+    cell_num++;
+  }
+  std::vector<MazeCell> maze;
+  GenerateMaze(cell_num, wp_.kTunnelFillRatio, wp_.kLoopRatio / 2, maze);
+  AddGround(world, 0.0);
+  AddMazeWalls(world, cell_num, maze, 0.0);
+  double half_size = cell_num * wp_.kCellSize / 2;
+  world.AddBox(Eigen::Vector3d(-half_size, -half_size, wp_.kWallHeight),
+               Eigen::Vector3d(half_size, half_size, wp_.kWallHeight + 0.2));
+
+  // Rubble on the tunnel floor
+  double origin = -half_size;
+  int center_ind = cell_num / 2 + cell_num / 2 * cell_num;
+  int rubble_num = static_cast<int>(std::round(wp_.kClutterDensity * 3));
+  for (int ind = 0; ind < maze.size(); ind++)
+  {
+    if (!maze[ind].open || ind == center_ind)
+    {
+      continue;
+    }
+    Eigen::Vector2d cell_center(origin + (ind % cell_num + 0.5) * wp_.kCellSize,
+                                origin + (ind / cell_num + 0.5) * wp_.kCellSize);
+    for (int i = 0; i < rubble_num; i++)
+    {
+      double size = Uniform(0.3, 0.8);
+      Eigen::Vector2d center = cell_center + Eigen::Vector2d(Uniform(-1, 1), Uniform(-1, 1)) *
+                                                 (wp_.kCellSize / 2 - wp_.kWallThickness - size / 2);
+      world.AddBox(Eigen::Vector3d(center.x() - size / 2, center.y() - size / 2, 0),
+                   Eigen::Vector3d(center.x() + size / 2, center.y() + size / 2, Uniform(0.1, 0.4)));
+    }
+  }
+}
+
+ScanSimulator::ScanSimulator(lidar_model_ns::LiDARModelType lidar_model_type, int horizontal_subdivision,
+                             int vertical_subdivision, double max_range)
+  : max_range_(max_range)
+{
+  lidar_model_ns::LiDARScanPattern scan_pattern = lidar_model_ns::GetScanPattern(lidar_model_type);
+  horizontal_subdivision = std::max(horizontal_subdivision, 1);
+  vertical_subdivision = std::max(vertical_subdivision, 1);
+  double horizontal_step = static_cast<double>(scan_pattern.horizontal_resolution) / horizontal_subdivision;
+  double vertical_step = static_cast<double>(scan_pattern.vertical_resolution) / vertical_subdivision;
+  int horizontal_num = static_cast<int>(std::round(scan_pattern.horizontal_fov / horizontal_step));
+  int vertical_num = static_cast<int>(std::round(scan_pattern.vertical_fov / vertical_step)) + 1;
+  double to_radian = M_PI / 180.0;
+  for (int v = 0; v < vertical_num; v++)
+  {
+    double elevation = (scan_pattern.GetLowerVerticalAngle() + v * vertical_step) * to_radian;
+    for (int h = 0; h < horizontal_num; h++)
+    {
+      double azimuth = (-180.0 + h * horizontal_step) * to_radian;
+      ray_directions_.emplace_back(cos(elevation) * cos(azimuth), cos(elevation) * sin(azimuth), sin(elevation));
+    }
+  }
+}
+
+void ScanSimulator::Scan(const SyntheticWorld& world, const Eigen::Vector3d& sensor_position, double yaw,
+                         pcl::PointCloud<pcl::PointXYZ>::Ptr& scan) const
+{
+  scan->clear();
+  double cos_yaw = cos(yaw);
+  double sin_yaw = sin(yaw);
+  for (const auto& ray_direction : ray_directions_)
+  {
+    Eigen::Vector3d direction(cos_yaw * ray_direction.x() - sin_yaw * ray_direction.y(),
+                              sin_yaw * ray_direction.x() + cos_yaw * ray_direction.y(), ray_direction.z());
+    double hit_dist;
+    if (world.RayCast(sensor_position, direction, max_range_, hit_dist))
+    {
+      Eigen::Vector3d hit_point = sensor_position + direction * hit_dist;
+      scan->points.emplace_back(hit_point.x(), hit_point.y(), hit_point.z());
+    }
+  }
+  scan->width = scan->points.size();
+  scan->height = 1;
+}
+
+bool SimulatorParameters::ReadParameters(ros::NodeHandle& nh)
+{
+  pub_registered_scan_topic_ =
+      misc_utils_ns::getParam<std::string>(nh, "pub_registered_scan_topic_", "/registered_scan");
+  pub_terrain_map_topic_ = misc_utils_ns::getParam<std::string>(nh, "pub_terrain_map_topic_", "/terrain_map");
+  pub_terrain_map_ext_topic_ =
+      misc_utils_ns::getParam<std::string>(nh, "pub_terrain_map_ext_topic_", "/terrain_map_ext");
+  pub_state_estimation_topic_ =
+      misc_utils_ns::getParam<std::string>(nh, "pub_state_estimation_topic_", "/state_estimation_at_scan");
+  sub_waypoint_topic_ = misc_utils_ns::getParam<std::string>(nh, "sub_waypoint_topic_", "/way_point");
+  sub_planning_cycle_topic_ =
+      misc_utils_ns::getParam<std::string>(nh, "sub_planning_cycle_topic_", "/planning_cycle");
+  kWorldCloudFile = misc_utils_ns::getParam<std::string>(nh, "kWorldCloudFile", "");
+
+  std::string lidar_model_name = misc_utils_ns::getParam<std::string>(nh, "kLiDARModel", "vlp16");
+  if (!lidar_model_ns::GetLiDARModelType(lidar_model_name, kLiDARModelType))
+  {
+    ROS_WARN_STREAM("SyntheticWorldSimulator: unknown kLiDARModel " << lidar_model_name << ", using vlp16");
+    kLiDARModelType = lidar_model_ns::LiDARModelType::VLP16;
+  }
+  kPublishClock = misc_utils_ns::getParam<bool>(nh, "kPublishClock", true);
+  kLockstep = misc_utils_ns::getParam<bool>(nh, "kLockstep", true);
+
+  kScanHorizontalSubdivision = misc_utils_ns::getParam<int>(nh, "kScanHorizontalSubdivision", 4);
+  kScanVerticalSubdivision = misc_utils_ns::getParam<int>(nh, "kScanVerticalSubdivision", 1);
+  kTerrainMapExtInterval = misc_utils_ns::getParam<int>(nh, "kTerrainMapExtInterval", 10);
+  kStatsInterval = misc_utils_ns::getParam<int>(nh, "kStatsInterval", 50);
+
+  kSimStep = misc_utils_ns::getParam<double>(nh, "kSimStep", 0.1);
+  kRealTimeFactor = misc_utils_ns::getParam<double>(nh, "kRealTimeFactor", 1.0);
+  kPlanningPeriod = misc_utils_ns::getParam<double>(nh, "kPlanningPeriod", 0.5);
+  kLockstepTimeout = misc_utils_ns::getParam<double>(nh, "kLockstepTimeout", 5.0);
+  kSensorRange = misc_utils_ns::getParam<double>(nh, "kSensorRange", 25.0);
+  kSensorHeight = misc_utils_ns::getParam<double>(nh, "kSensorHeight", 0.75);
+  kRobotSpeed = misc_utils_ns::getParam<double>(nh, "kRobotSpeed", 2.0);
+  kRobotRadius = misc_utils_ns::getParam<double>(nh, "kRobotRadius", 0.25);
+  kMaxStepHeight = misc_utils_ns::getParam<double>(nh, "kMaxStepHeight", 0.25);
+  kTerrainMapRadius = misc_utils_ns::getParam<double>(nh, "kTerrainMapRadius", 10.0);
+  kTerrainMapExtRadius = misc_utils_ns::getParam<double>(nh, "kTerrainMapExtRadius", 40.0);
+  kTerrainMapResolution = misc_utils_ns::getParam<double>(nh, "kTerrainMapResolution", 0.2);
+  kTerrainMapExtResolution = misc_utils_ns::getParam<double>(nh, "kTerrainMapExtResolution", 0.4);
+  kExploredVoxelSize = misc_utils_ns::getParam<double>(nh, "kExploredVoxelSize", 1.0);
+
+  kSimStep = std::max(kSimStep, 1e-3);
+  kRealTimeFactor = std::max(kRealTimeFactor, 1e-3);
+  kPlanningPeriod = std::max(kPlanningPeriod, kSimStep);
+  kTerrainMapExtInterval = std::max(kTerrainMapExtInterval, 1);
+  kStatsInterval = std::max(kStatsInterval, 1);
+  return true;
+}
+
+SyntheticWorldSimulator::SyntheticWorldSimulator(ros::NodeHandle& nh, ros::NodeHandle& nh_p)
+  : initialized_(false)
+  , sim_time_(1.0)
+  , step_count_(0)
+  , robot_position_(0, 0, 0)
+  , robot_yaw_(0.0)
+  , robot_speed_(0.0)
+  , traveled_distance_(0.0)
+  , waypoint_(0, 0, 0)
+  , waypoint_received_(false)
+  , planning_cycle_count_(0)
+  , lockstep_active_(false)
+  , scan_(new pcl::PointCloud<pcl::PointXYZ>())
+{
+  initialized_ = initialize(nh, nh_p);
+}
+
+bool SyntheticWorldSimulator::initialize(ros::NodeHandle& nh, ros::NodeHandle& nh_p)
+{
+  if (!wp_.ReadParameters(nh_p) || !sp_.ReadParameters(nh_p))
+  {
+    ROS_ERROR("Read parameters failed");
+    return false;
+  }
+
+  WorldGenerator world_generator(wp_);
+  Eigen::Vector3d start_position;
+  if (!world_generator.Generate(world_, start_position))
+  {
+    return false;
+  }
+  robot_position_ = start_position + Eigen::Vector3d(0, 0, sp_.kSensorHeight);
+  scan_simulator_ = std::make_unique<ScanSimulator>(sp_.kLiDARModelType, sp_.kScanHorizontalSubdivision,
+                                                    sp_.kScanVerticalSubdivision, sp_.kSensorRange);
+  ROS_INFO_STREAM("Generated " << wp_.kWorldType << " world of size " << wp_.kWorldSize << " with "
+                               << world_.GetBoxNum() << " boxes and " << world_.GetCylinderNum() << " cylinders, "
+                               << scan_simulator_->GetRayDirections().size() << " beams per scan");
+
+  waypoint_sub_ = nh.subscribe(sp_.sub_waypoint_topic_, 1, &SyntheticWorldSimulator::WaypointCallback, this);
+  if (sp_.kLockstep)
+  {
+    planning_cycle_sub_ =
+        nh.subscribe(sp_.sub_planning_cycle_topic_, 5, &SyntheticWorldSimulator::PlanningCycleCallback, this);
+  }
+  registered_scan_pub_ = nh.advertise<sensor_msgs::PointCloud2>(sp_.pub_registered_scan_topic_, 2);
+  terrain_map_pub_ = nh.advertise<sensor_msgs::PointCloud2>(sp_.pub_terrain_map_topic_, 2);
+  terrain_map_ext_pub_ = nh.advertise<sensor_msgs::PointCloud2>(sp_.pub_terrain_map_ext_topic_, 2);
+  state_estimation_pub_ = nh.advertise<nav_msgs::Odometry>(sp_.pub_state_estimation_topic_, 5);
+  stats_pub_ = nh.advertise<std_msgs::Float32MultiArray>("synthetic_world_stats", 2);
+  world_cloud_pub_ = nh.advertise<sensor_msgs::PointCloud2>("synthetic_world_cloud", 1, true);
+  if (sp_.kPublishClock)
+  {
+    clock_pub_ = nh.advertise<rosgraph_msgs::Clock>("/clock", 10);
+  }
+
+  pcl::PointCloud<pcl::PointXYZI>::Ptr world_cloud(new pcl::PointCloud<pcl::PointXYZI>());
+  world_.GetPointCloud(world_cloud, 0.2);
+  sensor_msgs::PointCloud2 world_cloud_msg;
+  pcl::toROSMsg(*world_cloud, world_cloud_msg);
+  world_cloud_msg.header.frame_id = "map";
+  world_cloud_msg.header.stamp = sim_time_;
+  world_cloud_pub_.publish(world_cloud_msg);
+  if (!sp_.kWorldCloudFile.empty() && !world_cloud->points.empty())
+  {
+    pcl::io::savePCDFileBinary(sp_.kWorldCloudFile, *world_cloud);
+    ROS_INFO_STREAM("World cloud saved to " << sp_.kWorldCloudFile);
+  }
+  return true;
+}
+
+int64_t SyntheticWorldSimulator::VoxelKey(const Eigen::Vector3d& point, double voxel_size)
+{
+  const int64_t kOffset = 1 << 20;
+  int64_t x = static_cast<int64_t>(std::floor(point.x() / voxel_size)) + kOffset;
+  int64_t y = static_cast<int64_t>(std::floor(point.y() / voxel_size)) + kOffset;
+  int64_t z = static_cast<int64_t>(std::floor(point.z() / voxel_size)) + kOffset;
+  return (x << 42) | (y << 21) | z;
+}
+
+void SyntheticWorldSimulator::WaypointCallback(const geometry_msgs::PointStamped::ConstPtr& waypoint_msg)
+{
+  waypoint_ = Eigen::Vector3d(waypoint_msg->point.x, waypoint_msg->point.y, waypoint_msg->point.z);
+  waypoint_received_ = true;
+}
+
+void SyntheticWorldSimulator::PlanningCycleCallback(const std_msgs::Header::ConstPtr& planning_cycle_msg)
+{
+  planning_cycle_count_++;
+  planning_cycle_stamp_ = planning_cycle_msg->stamp;
+  lockstep_active_ = true;
+}
+
+bool SyntheticWorldSimulator::WaitForPlanningCycle()
+{
+  // Free run until the planner reports its first cycle
+  if (!initialized_ || !sp_.kLockstep || !lockstep_active_)
+  {
+    return false;
+  }
+  // The planner's timer fires once the published clock reaches the next period
+  if (sim_time_ < planning_cycle_stamp_ + ros::Duration(sp_.kPlanningPeriod))
+  {
+    return true;
+  }
+  int planning_cycle_count = planning_cycle_count_;
+  ros::WallTime wait_start_time = ros::WallTime::now();
+  while (ros::ok() && planning_cycle_count_ == planning_cycle_count)
+  {
+    if ((ros::WallTime::now() - wait_start_time).toSec() > sp_.kLockstepTimeout)
+    {
+      ROS_WARN("Synthetic world: no planning cycle in %.1f s, free running until the next one", sp_.kLockstepTimeout);
+      lockstep_active_ = false;
+      return false;
+    }
+    ros::getGlobalCallbackQueue()->callAvailable(ros::WallDuration(0.01));
+  }
+  return true;
+}
+
+void SyntheticWorldSimulator::MoveRobot()
+{
+  robot_speed_ = 0.0;
+  if (!waypoint_received_)
+  {
+    return;
+  }
+  Eigen::Vector2d diff = waypoint_.head<2>() - robot_position_.head<2>();
+  double dist = diff.norm();
+  if (dist < 0.1)
+  {
+    return;
+  }
+  Eigen::Vector2d direction = diff / dist;
+  robot_yaw_ = atan2(direction.y(), direction.x());
+  double step = std::min(sp_.kRobotSpeed * sp_.kSimStep, dist);
+  Eigen::Vector2d next_xy = robot_position_.head<2>() + direction * step;
+
+  // Follow the ground, stop at walls, drops and steps that are too high
+  double ground_height = robot_position_.z() - sp_.kSensorHeight;
+  double next_ground_height;
+  if (!world_.GetGroundHeight(Eigen::Vector3d(next_xy.x(), next_xy.y(), ground_height + sp_.kMaxStepHeight),
+                              next_ground_height) ||
+      std::abs(next_ground_height - ground_height) > sp_.kMaxStepHeight)
+  {
+    return;
+  }
+  Eigen::Vector3d body_position(next_xy.x(), next_xy.y(), next_ground_height + sp_.kMaxStepHeight + sp_.kRobotRadius);
+  Eigen::Vector3d sensor_position(next_xy.x(), next_xy.y(), next_ground_height + sp_.kSensorHeight);
+  if (world_.InCollision(body_position, sp_.kRobotRadius) || world_.InCollision(sensor_position, sp_.kRobotRadius))
+  {
+    return;
+  }
+  robot_position_ = sensor_position;
+  robot_speed_ = step / sp_.kSimStep;
+  traveled_distance_ += step;
+}
+
+void SyntheticWorldSimulator::UpdateExploredVoxels()
+{
+  double voxel_size = sp_.kExploredVoxelSize;
+  for (const auto& point : scan_->points)
+  {
+    Eigen::Vector3d end(point.x, point.y, point.z);
+    Eigen::Vector3d diff = end - robot_position_;
+    int sample_num = static_cast<int>(diff.norm() / voxel_size) + 1;
+    for (int i = 0; i <= sample_num; i++)
+    {
+      explored_voxels_.insert(VoxelKey(robot_position_ + diff * i / sample_num, voxel_size));
+    }
+  }
+}
+
+void SyntheticWorldSimulator::GetTerrainMap(const pcl::PointCloud<pcl::PointXYZ>& cloud, double radius,
+                                            double resolution, pcl::PointCloud<pcl::PointXYZI>::Ptr& terrain_map) const
+{
+  // The ground of a 2D cell is the lowest point in the 3x3 neighborhood, intensity is the height above the ground
+  terrain_map->clear();
+  std::unordered_map<int64_t, float> cell_min_z;
+  auto cell_key = [resolution](double x, double y) {
+    return VoxelKey(Eigen::Vector3d(x, y, 0), resolution);
+  };
+  double radius_sq = radius * radius;
+  std::vector<int> in_range_indices;
+  for (int i = 0; i < cloud.points.size(); i++)
+  {
+    const pcl::PointXYZ& point = cloud.points[i];
+    double dx = point.x - robot_position_.x();
+    double dy = point.y - robot_position_.y();
+    if (dx * dx + dy * dy > radius_sq)
+    {
+      continue;
+    }
+    in_range_indices.push_back(i);
+    int64_t key = cell_key(point.x, point.y);
+    auto it = cell_min_z.find(key);
+    if (it == cell_min_z.end() || point.z < it->second)
+    {
+      cell_min_z[key] = point.z;
+    }
+  }
+  pcl::PointXYZI terrain_point;
+  for (const auto& ind : in_range_indices)
+  {
+    const pcl::PointXYZ& point = cloud.points[ind];
+    float ground_z = point.z;
+    for (int dx = -1; dx <= 1; dx++)
+    {
+      for (int dy = -1; dy <= 1; dy++)
+      {
+        auto it = cell_min_z.find(cell_key(point.x + dx * resolution, point.y + dy * resolution));
+        if (it != cell_min_z.end())
+        {
+          ground_z = std::min(ground_z, it->second);
+        }
+      }
+    }
+    terrain_point.x = point.x;
+    terrain_point.y = point.y;
+    terrain_point.z = point.z;
+    terrain_point.intensity = point.z - ground_z;
+    terrain_map->points.push_back(terrain_point);
+  }
+  terrain_map->width = terrain_map->points.size();
+  terrain_map->height = 1;
+}
+
+void SyntheticWorldSimulator::PublishOdometry()
+{
+  nav_msgs::Odometry odometry;
+  odometry.header.frame_id = "map";
+  odometry.header.stamp = sim_time_;
+  odometry.child_frame_id = "sensor";
+  odometry.pose.pose.position.x = robot_position_.x();
+  odometry.pose.pose.position.y = robot_position_.y();
+  odometry.pose.pose.position.z = robot_position_.z();
+  odometry.pose.pose.orientation = tf::createQuaternionMsgFromYaw(robot_yaw_);
+  odometry.twist.twist.linear.x = robot_speed_;
+  state_estimation_pub_.publish(odometry);
+}
+
+void SyntheticWorldSimulator::PublishStats()
+{
+  double explored_volume = explored_voxels_.size() * std::pow(sp_.kExploredVoxelSize, 3);
+  std_msgs::Float32MultiArray stats_msg;
+  stats_msg.data.push_back(sim_time_.toSec());
+  stats_msg.data.push_back(traveled_distance_);
+  stats_msg.data.push_back(explored_volume);
+  stats_msg.data.push_back(map_voxels_.size());
+  stats_pub_.publish(stats_msg);
+  ROS_INFO("Synthetic world: time %.1f s, traveled %.1f m, explored volume %.0f m3, map points %zu",
+           sim_time_.toSec(), traveled_distance_, explored_volume, map_voxels_.size());
+}
+
+void SyntheticWorldSimulator::Step()
+{
+  if (!initialized_)
+  {
+    return;
+  }
+  step_count_++;
+  sim_time_ += ros::Duration(sp_.kSimStep);
+  if (sp_.kPublishClock)
+  {
+    rosgraph_msgs::Clock clock_msg;
+    clock_msg.clock = sim_time_;
+    clock_pub_.publish(clock_msg);
+  }
+
+  MoveRobot();
+  scan_simulator_->Scan(world_, robot_position_, robot_yaw_, scan_);
+  PublishOdometry();
+
+  sensor_msgs::PointCloud2 scan_msg;
+  pcl::toROSMsg(*scan_, scan_msg);
+  scan_msg.header.frame_id = "map";
+  scan_msg.header.stamp = sim_time_;
+  registered_scan_pub_.publish(scan_msg);
+
+  for (const auto& point : scan_->points)
+  {
+    map_voxels_.emplace(VoxelKey(Eigen::Vector3d(point.x, point.y, point.z), sp_.kTerrainMapExtResolution), point);
+  }
+  UpdateExploredVoxels();
+
+  pcl::PointCloud<pcl::PointXYZI>::Ptr terrain_map(new pcl::PointCloud<pcl::PointXYZI>());
+  GetTerrainMap(*scan_, sp_.kTerrainMapRadius, sp_.kTerrainMapResolution, terrain_map);
+  sensor_msgs::PointCloud2 terrain_map_msg;
+  pcl::toROSMsg(*terrain_map, terrain_map_msg);
+  terrain_map_msg.header.frame_id = "map";
+  terrain_map_msg.header.stamp = sim_time_;
+  terrain_map_pub_.publish(terrain_map_msg);
+
+  if (step_count_ % sp_.kTerrainMapExtInterval == 0)
+  {
+    pcl::PointCloud<pcl::PointXYZ> map_cloud;
+    map_cloud.points.reserve(map_voxels_.size());
+    for (const auto& map_voxel : map_voxels_)
+    {
+      map_cloud.points.push_back(map_voxel.second);
+    }
+    GetTerrainMap(map_cloud, sp_.kTerrainMapExtRadius, sp_.kTerrainMapExtResolution, terrain_map);
+    pcl::toROSMsg(*terrain_map, terrain_map_msg);
+    terrain_map_msg.header.frame_id = "map";
+    terrain_map_msg.header.stamp = sim_time_;
+    terrain_map_ext_pub_.publish(terrain_map_msg);
+  }
+
+  if (step_count_ % sp_.kStatsInterval == 0)
+  {
+    PublishStats();
+  }
+}
+}  // namespace world_generator_ns
@@ -0,0 +1,26 @@
+#include <ros/ros.h>
+#include "world_generator/world_generator.h"
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "world_generator_node");
+  ros::NodeHandle node_handle;
+  ros::NodeHandle private_node_handle("~");
+
+  world_generator_ns::SyntheticWorldSimulator simulator(node_handle, private_node_handle);
+
+  // Sim time advances by kSimStep per step. In lockstep the simulation steps as fast as the planner finishes its
+  // cycles, otherwise kRealTimeFactor steps it faster or slower than the wall clock
+  ros::WallRate rate(simulator.GetRealTimeFactor() / simulator.GetSimStep());
+  while (ros::ok())
+  {
+    ros::spinOnce();
+    bool lockstep = simulator.WaitForPlanningCycle();
+    simulator.Step();
+    if (!lockstep)
+    {
+      rate.sleep();
+    }
+  }
+  return 0;
+}